@@ -0,0 +1,584 @@
+#include "LogModel.h"
+#include <QFile>
+#include <QMetaObject>
+#include <cstring>
+
+const int LogModel::CHUNK_ROWS = 65536;
+const int LogModel::MAX_CHUNKS = 256;
+
+// Format of saved logs: this header, the number of chunks, and then for each chunk
+// the number of rows, the size of its heap, its columns and its heap, as in memory
+#define LOG_FILE_MAGIC "MEGALOGM"
+#define LOG_FILE_VERSION 1
+#define LOG_FILE_BYTE_ORDER 0x01020304
+
+static inline int padding(qint64 size)
+{
+    return (4 - (size & 3)) & 3;
+}
+
+class LogModel::FilterTask : public QRunnable
+{
+public:
+    FilterTask(LogModel *model, QSharedPointer<Chunk> chunk, quint32 firstRow, const Filter &filter, int generation)
+        : model(model), chunk(chunk), firstRow(firstRow), filter(filter), generation(generation) {}
+
+    virtual void run()
+    {
+        if (model->filterGeneration.fetchAndAddOrdered(0) != generation)
+        {
+            return;
+        }
+
+        QVector<quint32> rows;
+        LogModel::filterChunk(chunk.data(), firstRow, chunk->levels.size(), filter, &rows);
+
+        QMutexLocker locker(&model->resultsMutex);
+        if (model->filterGeneration.fetchAndAddOrdered(0) == generation)
+        {
+            model->filterResults.insert(firstRow, rows);
+            QMetaObject::invokeMethod(model, "onFilterResults", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    LogModel *model;
+    QSharedPointer<Chunk> chunk;
+    quint32 firstRow;
+    Filter filter;
+    int generation;
+};
+
+LogModel::LogModel(QObject *parent) : QAbstractTableModel(parent)
+{
+    firstRow = 0;
+    committedEnd = 0;
+    filtered = false;
+    filter.column = COLUMN_MESSAGE;
+}
+
+LogModel::~LogModel()
+{
+    filterGeneration.ref();
+    filterPool.waitForDone();
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return filtered ? visibleRows.size() : int(committedEnd - firstRow);
+}
+
+int LogModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : NUM_COLUMNS;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= rowCount())
+    {
+        return QVariant();
+    }
+
+    int i;
+    const Chunk *chunk = chunkForRow(rowAt(index.row()), &i);
+    switch (index.column())
+    {
+        case COLUMN_TIME:
+            return QString::fromUtf8(chunk->heap.constData() + chunk->timeOffsets.at(i), chunk->timeSizes.at(i));
+        case COLUMN_TYPE:
+            return levelName(chunk->levels.at(i));
+        case COLUMN_MESSAGE:
+            return QString::fromUtf8(chunk->heap.constData() + chunk->messageOffsets.at(i), chunk->messageSizes.at(i));
+        default:
+            return QVariant();
+    }
+}
+
+QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    switch (section)
+    {
+        case COLUMN_TIME:
+            return QString::fromUtf8("Timestamp");
+        case COLUMN_TYPE:
+            return QString::fromUtf8("Message Type");
+        case COLUMN_MESSAGE:
+            return QString::fromUtf8("Message");
+        default:
+            return QVariant();
+    }
+}
+
+void LogModel::appendRow(int level, const char *time, int timeSize, const char *message, int messageSize)
+{
+    if (chunks.isEmpty() || chunks.last()->levels.size() >= CHUNK_ROWS)
+    {
+        if (chunks.size() >= MAX_CHUNKS)
+        {
+            removeFirstChunk();
+        }
+
+        QSharedPointer<Chunk> chunk(new Chunk());
+        chunk->levels.reserve(CHUNK_ROWS);
+        chunk->timeSizes.reserve(CHUNK_ROWS);
+        chunk->timeOffsets.reserve(CHUNK_ROWS);
+        chunk->messageOffsets.reserve(CHUNK_ROWS);
+        chunk->messageSizes.reserve(CHUNK_ROWS);
+        chunks.append(chunk);
+    }
+
+    Chunk *chunk = chunks.last().data();
+    timeSize = qMin(timeSize, 255);
+    int last = chunk->levels.size() - 1;
+    if (last >= 0 && chunk->timeSizes.at(last) == timeSize
+            && !memcmp(chunk->heap.constData() + chunk->timeOffsets.at(last), time, timeSize))
+    {
+        chunk->timeOffsets.append(chunk->timeOffsets.at(last));
+    }
+    else
+    {
+        chunk->timeOffsets.append(chunk->heap.size());
+        chunk->heap.append(time, timeSize);
+    }
+
+    chunk->levels.append(level);
+    chunk->timeSizes.append(timeSize);
+    chunk->messageOffsets.append(chunk->heap.size());
+    chunk->messageSizes.append(messageSize);
+    chunk->heap.append(message, messageSize);
+}
+
+void LogModel::commitRows()
+{
+    quint32 end = storedEnd();
+    if (end == committedEnd)
+    {
+        return;
+    }
+
+    if (!filtered)
+    {
+        int first = committedEnd - firstRow;
+        beginInsertRows(QModelIndex(), first, first + int(end - committedEnd) - 1);
+        committedEnd = end;
+        endInsertRows();
+        return;
+    }
+
+    // New rows are checked here, they are only a few each time
+    QVector<quint32> rows;
+    while (committedEnd != end)
+    {
+        int i;
+        const Chunk *chunk = chunkForRow(committedEnd, &i);
+        int numRows = qMin(chunk->levels.size() - i, int(end - committedEnd));
+        for (int j = 0; j < numRows; j++)
+        {
+            if (matches(chunk, i + j, filter))
+            {
+                rows.append(committedEnd + j);
+            }
+        }
+        committedEnd += numRows;
+    }
+
+    if (!pendingChunks.isEmpty())
+    {
+        // They go after the matches of the chunks that are still being filtered
+        pendingNewRows += rows;
+        return;
+    }
+    appendVisibleRows(rows);
+}
+
+void LogModel::clear()
+{
+    resultsMutex.lock();
+    filterGeneration.ref();
+    filterResults.clear();
+    resultsMutex.unlock();
+
+    beginResetModel();
+    chunks.clear();
+    firstRow = 0;
+    committedEnd = 0;
+    visibleRows.clear();
+    pendingChunks.clear();
+    pendingNewRows.clear();
+    endResetModel();
+}
+
+void LogModel::setFilter(QRegExp regExp, int column)
+{
+    resultsMutex.lock();
+    int generation = filterGeneration.fetchAndAddOrdered(1) + 1;
+    filterResults.clear();
+    resultsMutex.unlock();
+
+    beginResetModel();
+    filter.regExp = regExp;
+    filter.column = column;
+    filter.fixedPattern.clear();
+    if (regExp.patternSyntax() == QRegExp::FixedString && regExp.caseSensitivity() == Qt::CaseSensitive)
+    {
+        filter.fixedPattern = regExp.pattern().toUtf8();
+    }
+    filtered = !regExp.pattern().isEmpty();
+    visibleRows.clear();
+    pendingChunks.clear();
+    pendingNewRows.clear();
+    endResetModel();
+
+    if (!filtered)
+    {
+        return;
+    }
+
+    for (int i = 0; i < chunks.size(); i++)
+    {
+        quint32 chunkFirstRow = firstRow + i * CHUNK_ROWS;
+        int numRows = qMin(chunks.at(i)->levels.size(), int(committedEnd - chunkFirstRow));
+        if (numRows <= 0)
+        {
+            break;
+        }
+
+        pendingChunks.append(chunkFirstRow);
+        if (numRows == CHUNK_ROWS)
+        {
+            // Full chunks don't change anymore
+            filterPool.start(new FilterTask(this, chunks.at(i), chunkFirstRow, filter, generation));
+        }
+        else
+        {
+            QVector<quint32> rows;
+            filterChunk(chunks.at(i).data(), chunkFirstRow, numRows, filter, &rows);
+            resultsMutex.lock();
+            filterResults.insert(chunkFirstRow, rows);
+            resultsMutex.unlock();
+        }
+    }
+    onFilterResults();
+}
+
+void LogModel::onFilterResults()
+{
+    // Results are shown in order, so a chunk waits for the ones before it
+    while (!pendingChunks.isEmpty())
+    {
+        resultsMutex.lock();
+        QMap<quint32, QVector<quint32> >::iterator it = filterResults.find(pendingChunks.first());
+        if (it == filterResults.end())
+        {
+            resultsMutex.unlock();
+            return;
+        }
+        QVector<quint32> rows = it.value();
+        filterResults.erase(it);
+        resultsMutex.unlock();
+
+        pendingChunks.removeFirst();
+        appendVisibleRows(rows);
+    }
+
+    if (!pendingNewRows.isEmpty())
+    {
+        QVector<quint32> rows = pendingNewRows;
+        pendingNewRows.clear();
+        appendVisibleRows(rows);
+    }
+}
+
+bool LogModel::save(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    quint32 header[4] = {LOG_FILE_VERSION, LOG_FILE_BYTE_ORDER, (quint32)chunks.size(), 0};
+    bool success = file.write(LOG_FILE_MAGIC, 8) == 8
+            && file.write((const char *)header, sizeof(header)) == sizeof(header);
+
+    static const char zeros[4] = {0, 0, 0, 0};
+    for (int i = 0; i < chunks.size() && success; i++)
+    {
+        const Chunk *chunk = chunks.at(i).data();
+        quint32 numRows = chunk->levels.size();
+        quint32 chunkHeader[2] = {numRows, (quint32)chunk->heap.size()};
+        success = file.write((const char *)chunkHeader, sizeof(chunkHeader)) == sizeof(chunkHeader)
+                && file.write((const char *)chunk->levels.constData(), numRows) == numRows
+                && file.write((const char *)chunk->timeSizes.constData(), numRows) == numRows
+                && file.write(zeros, padding(2 * numRows)) == padding(2 * numRows)
+                && file.write((const char *)chunk->timeOffsets.constData(), 4 * numRows) == 4 * numRows
+                && file.write((const char *)chunk->messageOffsets.constData(), 4 * numRows) == 4 * numRows
+                && file.write((const char *)chunk->messageSizes.constData(), 4 * numRows) == 4 * numRows
+                && file.write(chunk->heap) == chunk->heap.size()
+                && file.write(zeros, padding(chunk->heap.size())) == padding(chunk->heap.size());
+    }
+
+    file.close();
+    if (!success)
+    {
+        QFile::remove(path);
+    }
+    return success;
+}
+
+bool LogModel::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < 24)
+    {
+        return false;
+    }
+
+    const char *data = (const char *)file.map(0, file.size());
+    if (!data)
+    {
+        return false;
+    }
+
+    const char *end = data + file.size();
+    quint32 header[4];
+    memcpy(header, data + 8, sizeof(header));
+    if (memcmp(data, LOG_FILE_MAGIC, 8) || header[0] != LOG_FILE_VERSION || header[1] != LOG_FILE_BYTE_ORDER
+            || header[2] > (quint32)MAX_CHUNKS)
+    {
+        file.unmap((uchar *)data);
+        return false;
+    }
+
+    // Columns are copied from the mapped file in blocks, rows aren't parsed one by one
+    QList<QSharedPointer<Chunk> > loadedChunks;
+    const char *p = data + 24;
+    bool success = true;
+    for (quint32 i = 0; i < header[2] && success; i++)
+    {
+        quint32 chunkHeader[2];
+        if (end - p < (qint64)sizeof(chunkHeader))
+        {
+            success = false;
+            break;
+        }
+        memcpy(chunkHeader, p, sizeof(chunkHeader));
+        p += sizeof(chunkHeader);
+
+        qint64 numRows = chunkHeader[0];
+        qint64 heapSize = chunkHeader[1];
+        qint64 columnsSize = 2 * numRows + padding(2 * numRows) + 12 * numRows;
+        // Only the last chunk can be partially filled
+        if (numRows > CHUNK_ROWS || (numRows < CHUNK_ROWS && i + 1 < header[2])
+                || end - p < columnsSize + heapSize + padding(heapSize))
+        {
+            success = false;
+            break;
+        }
+
+        QSharedPointer<Chunk> chunk(new Chunk());
+        chunk->levels.resize(numRows);
+        chunk->timeSizes.resize(numRows);
+        chunk->timeOffsets.resize(numRows);
+        chunk->messageOffsets.resize(numRows);
+        chunk->messageSizes.resize(numRows);
+        memcpy(chunk->levels.data(), p, numRows);
+        p += numRows;
+        memcpy(chunk->timeSizes.data(), p, numRows);
+        p += numRows + padding(2 * numRows);
+        memcpy(chunk->timeOffsets.data(), p, 4 * numRows);
+        p += 4 * numRows;
+        memcpy(chunk->messageOffsets.data(), p, 4 * numRows);
+        p += 4 * numRows;
+        memcpy(chunk->messageSizes.data(), p, 4 * numRows);
+        p += 4 * numRows;
+        chunk->heap = QByteArray(p, heapSize);
+        p += heapSize + padding(heapSize);
+
+        for (int j = 0; j < numRows; j++)
+        {
+            if ((qint64)chunk->timeOffsets.at(j) + chunk->timeSizes.at(j) > heapSize
+                    || (qint64)chunk->messageOffsets.at(j) + chunk->messageSizes.at(j) > heapSize)
+            {
+                success = false;
+                break;
+            }
+        }
+        loadedChunks.append(chunk);
+    }
+
+    file.unmap((uchar *)data);
+    file.close();
+    if (!success)
+    {
+        return false;
+    }
+
+    clear();
+    chunks = loadedChunks;
+    committedEnd = storedEnd();
+    setFilter(filter.regExp, filter.column);
+    return true;
+}
+
+QString LogModel::levelName(int level)
+{
+    // Same values as the SDK log levels
+    switch (level)
+    {
+        case 0:
+            return QString::fromUtf8("fatal");
+        case 1:
+            return QString::fromUtf8("error");
+        case 2:
+            return QString::fromUtf8("warning");
+        case 3:
+            return QString::fromUtf8("info");
+        case 4:
+            return QString::fromUtf8("debug");
+        case 5:
+            return QString::fromUtf8("verbose");
+        default:
+            return QString::fromUtf8("unknown");
+    }
+}
+
+int LogModel::levelFromName(const QString &name)
+{
+    for (int level = 0; level <= 5; level++)
+    {
+        if (levelName(level) == name)
+        {
+            return level;
+        }
+    }
+    return 255;
+}
+
+const LogModel::Chunk *LogModel::chunkForRow(quint32 row, int *index) const
+{
+    quint32 offset = row - firstRow;
+    *index = offset % CHUNK_ROWS;
+    return chunks.at(offset / CHUNK_ROWS).data();
+}
+
+quint32 LogModel::rowAt(int visibleRow) const
+{
+    return filtered ? visibleRows.at(visibleRow) : firstRow + visibleRow;
+}
+
+quint32 LogModel::storedEnd() const
+{
+    if (chunks.isEmpty())
+    {
+        return firstRow;
+    }
+    return firstRow + (chunks.size() - 1) * CHUNK_ROWS + chunks.last()->levels.size();
+}
+
+void LogModel::removeFirstChunk()
+{
+    quint32 removedEnd = firstRow + CHUNK_ROWS;
+    int numRemoved;
+    if (filtered)
+    {
+        numRemoved = 0;
+        while (numRemoved < visibleRows.size() && visibleRows.at(numRemoved) < removedEnd)
+        {
+            numRemoved++;
+        }
+    }
+    else
+    {
+        numRemoved = qMin(CHUNK_ROWS, int(committedEnd - firstRow));
+    }
+
+    if (numRemoved)
+    {
+        beginRemoveRows(QModelIndex(), 0, numRemoved - 1);
+    }
+
+    chunks.removeFirst();
+    if (filtered)
+    {
+        visibleRows.remove(0, numRemoved);
+    }
+    if (committedEnd - firstRow < (quint32)CHUNK_ROWS)
+    {
+        committedEnd = removedEnd;
+    }
+    firstRow = removedEnd;
+
+    if (numRemoved)
+    {
+        endRemoveRows();
+    }
+}
+
+void LogModel::appendVisibleRows(const QVector<quint32> &rows)
+{
+    // Rows of chunks removed while they were being filtered are skipped
+    int first = 0;
+    while (first < rows.size() && rows.at(first) - firstRow >= committedEnd - firstRow)
+    {
+        first++;
+    }
+
+    int numRows = rows.size() - first;
+    if (!numRows)
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), visibleRows.size(), visibleRows.size() + numRows - 1);
+    visibleRows += rows.mid(first);
+    endInsertRows();
+}
+
+bool LogModel::matches(const Chunk *chunk, int index, const Filter &filter)
+{
+    if (filter.column == COLUMN_TYPE)
+    {
+        return filter.regExp.indexIn(levelName(chunk->levels.at(index))) >= 0;
+    }
+
+    const char *text;
+    int size;
+    if (filter.column == COLUMN_TIME)
+    {
+        text = chunk->heap.constData() + chunk->timeOffsets.at(index);
+        size = chunk->timeSizes.at(index);
+    }
+    else
+    {
+        text = chunk->heap.constData() + chunk->messageOffsets.at(index);
+        size = chunk->messageSizes.at(index);
+    }
+
+    if (!filter.fixedPattern.isEmpty())
+    {
+        return QByteArray::fromRawData(text, size).indexOf(filter.fixedPattern) >= 0;
+    }
+    return filter.regExp.indexIn(QString::fromUtf8(text, size)) >= 0;
+}
+
+void LogModel::filterChunk(const Chunk *chunk, quint32 firstRow, int numRows, const Filter &filter, QVector<quint32> *rows)
+{
+    for (int i = 0; i < numRows; i++)
+    {
+        if (matches(chunk, i, filter))
+        {
+            rows->append(firstRow + i);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include <QRegExp>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+
+// Rows are kept in chunks of columns: levels, time and message sizes, and offsets
+// into a heap of UTF-8 text. Consecutive rows with the same time share it.
+// Only full chunks are filtered, in parallel, and their matches are shown in order
+// as they arrive. Rows appended meanwhile are checked in the GUI thread.
+class LogModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        COLUMN_TIME = 0,
+        COLUMN_TYPE,
+        COLUMN_MESSAGE,
+        NUM_COLUMNS
+    };
+
+    explicit LogModel(QObject *parent = 0);
+    virtual ~LogModel();
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    // Rows are stored here and shown by commitRows()
+    void appendRow(int level, const char *time, int timeSize, const char *message, int messageSize);
+    void commitRows();
+    void clear();
+
+    // An empty pattern shows all the rows
+    void setFilter(QRegExp regExp, int column);
+
+    bool save(const QString &path);
+    bool load(const QString &path);
+
+    static QString levelName(int level);
+    static int levelFromName(const QString &name);
+
+    static const int CHUNK_ROWS;
+    static const int MAX_CHUNKS;
+
+protected slots:
+    void onFilterResults();
+
+protected:
+    class FilterTask;
+
+    struct Chunk
+    {
+        QVector<quint8> levels;
+        QVector<quint8> timeSizes;
+        QVector<quint32> timeOffsets;
+        QVector<quint32> messageOffsets;
+        QVector<quint32> messageSizes;
+        QByteArray heap;
+    };
+
+    struct Filter
+    {
+        QRegExp regExp;
+        int column;
+        // Case sensitive fixed strings are searched in the UTF-8 text
+        QByteArray fixedPattern;
+    };
+
+    const Chunk *chunkForRow(quint32 row, int *index) const;
+    quint32 rowAt(int visibleRow) const;
+    quint32 storedEnd() const;
+    void removeFirstChunk();
+    void appendVisibleRows(const QVector<quint32> &rows);
+    static bool matches(const Chunk *chunk, int index, const Filter &filter);
+    static void filterChunk(const Chunk *chunk, quint32 firstRow, int numRows, const Filter &filter, QVector<quint32> *rows);
+
+    QList<QSharedPointer<Chunk> > chunks;
+    // Absolute numbers of the first stored row and of the first one not shown yet
+    quint32 firstRow;
+    quint32 committedEnd;
+
+    bool filtered;
+    Filter filter;
+    QVector<quint32> visibleRows;
+
+    // Matches of the running filter, by the first row of each chunk
+    QMutex resultsMutex;
+    QMap<quint32, QVector<quint32> > filterResults;
+    QList<quint32> pendingChunks;
+    QVector<quint32> pendingNewRows;
+    QAtomicInt filterGeneration;
+    QThreadPool filterPool;
+};
+
+#endif // LOGMODEL_H
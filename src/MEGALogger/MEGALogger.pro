@@ -13,10 +13,12 @@ TEMPLATE = app
 
 
 SOURCES += main.cpp \
-    MegaDebugServer.cpp
+    MegaDebugServer.cpp \
+    LogModel.cpp
 
 HEADERS  += \
-    MegaDebugServer.h
+    MegaDebugServer.h \
+    LogModel.h
 
 FORMS    += \
     MegaDebugServer.ui
@@ -1,10 +1,19 @@
 #include "MegaDebugServer.h"
 #include "ui_MegaDebugServer.h"
+#include <QDateTime>
+#include <QtEndian>
 #include <iostream>
+#include <cstring>
 
 #define MEGA_LOGGER "MEGA_LOGGER"
 #define ENABLE_MEGASYNC_LOGS "MEGA_ENABLE_LOGS"
-#define MAX_LOG_MESSAGES 16384
+
+// Binary stream sent by MEGAsync, see MegaSyncLogger
+#define LOG_STREAM_HEADER "MEGALOG\x01"
+#define LOG_STREAM_HEADER_SIZE 8
+#define FRAME_HEADER_SIZE 4
+#define RECORD_HEADER_SIZE 6
+#define MAX_FRAME_SIZE 16777216
 
 using namespace std;
 
@@ -19,8 +28,7 @@ MegaDebugServer::MegaDebugServer(QWidget *parent) :
     megaSyncClient = NULL;
     megaServer = NULL;
     debugDataModel = NULL;
-    debugProxyModel = NULL;
-    reader = NULL;
+    headerReceived = false;
 
     ui->filterTypeComboBox->addItem("Regular Expression", QRegExp::RegExp);
     ui->filterTypeComboBox->addItem("Wildcard", QRegExp::Wildcard);
@@ -41,16 +49,13 @@ MegaDebugServer::MegaDebugServer(QWidget *parent) :
     connect(ui->actionClear, SIGNAL(triggered()), this, SLOT(clearDebugWindow()));
     connect(ui->actionStop, SIGNAL(triggered()), this, SLOT(startstop()));
 
-    debugDataModel = new QStandardItemModel(0, 3, this);
-    debugDataModel->setHeaderData(0, Qt::Horizontal,QString::fromUtf8("Timestamp"), Qt::DisplayRole);
-    debugDataModel->setHeaderData(1, Qt::Horizontal,QString::fromUtf8("Message Type"), Qt::DisplayRole);
-    debugDataModel->setHeaderData(2, Qt::Horizontal,QString::fromUtf8("Message"), Qt::DisplayRole);
-
-    debugProxyModel = new QSortFilterProxyModel;
-    debugProxyModel->setSourceModel(debugDataModel);
-    ui->messagesTreeView->setModel(debugProxyModel);
+    // Rows are shown in the order they arrive, all of them with the same height
+    // so the view only asks for the visible ones
+    debugDataModel = new LogModel(this);
+    ui->messagesTreeView->setModel(debugDataModel);
+    ui->messagesTreeView->setUniformRowHeights(true);
+    ui->messagesTreeView->setSortingEnabled(false);
 
-    ui->messagesTreeView->sortByColumn(1, Qt::AscendingOrder);
     ui->messagesTreeView->resizeColumnToContents(0);
     ui->messagesTreeView->resizeColumnToContents(1);
     ui->messagesTreeView->resizeColumnToContents(2);
@@ -78,7 +83,8 @@ void MegaDebugServer::clientConnected()
         megaSyncClient->disconnectFromServer();
         megaSyncClient->deleteLater();
     }
-    reader = new QXmlStreamReader(megaSyncClient);
+    pendingData.clear();
+    headerReceived = false;
 
     connect(megaSyncClient, SIGNAL(readyRead()), this, SLOT(readDebugMsg()));
     connect(megaSyncClient, SIGNAL(disconnected()), this, SLOT(disconnected()));
@@ -93,45 +99,96 @@ void MegaDebugServer::parseReader(QXmlStreamReader *reader)
         if (token == QXmlStreamReader::StartElement && reader->name() == "log")
         {
             QXmlStreamAttributes attr = reader->attributes();
-            DebugRow dr;
-            dr.timeStamp = attr.value(QString::fromUtf8("timestamp")).toString();
-            dr.messageType = attr.value(QString::fromUtf8("type")).toString();
-            dr.content = attr.value(QString::fromUtf8("content")).toString();
-            appendDebugRow(&dr);
+            appendDebugRow(LogModel::levelFromName(attr.value(QString::fromUtf8("type")).toString()),
+                           attr.value(QString::fromUtf8("timestamp")).toString(),
+                           attr.value(QString::fromUtf8("content")).toString());
         }
     } while (!reader->error());
+    debugDataModel->commitRows();
 }
 
 void MegaDebugServer::readDebugMsg()
 {
-    parseReader(reader);
-}
-
-void MegaDebugServer::appendDebugRow(DebugRow *dr)
-{
-    int index = debugDataModel->rowCount();
+    if (!megaSyncClient)
+    {
+        return;
+    }
 
-    if (index >= MAX_LOG_MESSAGES)
+    pendingData.append(megaSyncClient->readAll());
+    int offset = 0;
+    if (!headerReceived)
     {
-        QList<QStandardItem*> items = debugDataModel->takeRow(0);
-        for (int i = 0; i < items.size(); i++)
+        if (pendingData.size() < LOG_STREAM_HEADER_SIZE)
+        {
+            return;
+        }
+
+        if (memcmp(pendingData.constData(), LOG_STREAM_HEADER, LOG_STREAM_HEADER_SIZE))
         {
-            delete items[i];
+            ui->statusBar->showMessage(tr("Unknown log format"));
+            disconnected();
+            return;
         }
-        index--;
+
+        headerReceived = true;
+        offset = LOG_STREAM_HEADER_SIZE;
+
+        appendDebugRow(3, QDateTime::currentDateTime().toString(QString::fromUtf8("yyyy-MM-dd hh:mm:ss")),
+                       QString::fromUtf8("LOG START"));
     }
 
-    QStandardItem *ts = new QStandardItem(dr->timeStamp);
-    QStandardItem *mt = new QStandardItem(dr->messageType);
-    QStandardItem *c = new QStandardItem(dr->content);
+    // Complete frames are parsed, the rest waits for more data
+    while (pendingData.size() - offset >= FRAME_HEADER_SIZE)
+    {
+        quint32 frameSize = qFromBigEndian<quint32>((const uchar *)pendingData.constData() + offset);
+        if (frameSize > MAX_FRAME_SIZE)
+        {
+            ui->statusBar->showMessage(tr("Invalid log data"));
+            disconnected();
+            return;
+        }
+
+        if ((quint32)(pendingData.size() - offset - FRAME_HEADER_SIZE) < frameSize)
+        {
+            break;
+        }
 
-    debugDataModel->setItem(index, 0, ts);
-    debugDataModel->setItem(index, 1, mt);
-    debugDataModel->setItem(index, 2, c);
+        parseRecords(pendingData.constData() + offset + FRAME_HEADER_SIZE, frameSize);
+        offset += FRAME_HEADER_SIZE + frameSize;
+    }
+    pendingData.remove(0, offset);
 
+    // The view is updated once per read, not once per row
+    debugDataModel->commitRows();
     ui->messagesTreeView->scrollToBottom();
 }
 
+void MegaDebugServer::parseRecords(const char *data, int size)
+{
+    const char *end = data + size;
+    while (end - data >= RECORD_HEADER_SIZE)
+    {
+        int level = (unsigned char)data[0];
+        int timeSize = (unsigned char)data[1];
+        quint32 messageSize = qFromBigEndian<quint32>((const uchar *)data + 2);
+        data += RECORD_HEADER_SIZE;
+        if ((quint32)(end - data) < timeSize + messageSize)
+        {
+            return;
+        }
+
+        debugDataModel->appendRow(level, data, timeSize, data + timeSize, messageSize);
+        data += timeSize + messageSize;
+    }
+}
+
+void MegaDebugServer::appendDebugRow(int level, const QString &timeStamp, const QString &content)
+{
+    QByteArray time = timeStamp.toUtf8();
+    QByteArray message = content.toUtf8();
+    debugDataModel->appendRow(level, time.constData(), time.size(), message.constData(), message.size());
+}
+
 void MegaDebugServer::startstop()
 {
     if (!megaServer)
@@ -167,9 +224,9 @@ void MegaDebugServer::disconnected()
 {
     if (megaServer)
     {
-        delete reader;
         megaServer->deleteLater();
-        reader = NULL;
+        pendingData.clear();
+        headerReceived = false;
         megaServer = NULL;
         megaSyncClient = NULL;
         ui->actionSave->setEnabled(true);
@@ -187,22 +244,20 @@ void MegaDebugServer::tryConnect()
 
 void MegaDebugServer::filterTextRegExp()
 {
-    qDebug() << ui->filterTypeComboBox->itemData(ui->filterTypeComboBox->currentIndex()).toInt();
     QRegExp::PatternSyntax syntax = QRegExp::PatternSyntax(ui->filterTypeComboBox->itemData(ui->filterTypeComboBox->currentIndex()).toInt());
     Qt::CaseSensitivity caseSensitivity = ui->caseSensitivecheckBox->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
     QRegExp regExp(ui->filterPatternLineEdit->text(), caseSensitivity, syntax);
-    qDebug() << regExp;
-    debugProxyModel->setFilterRegExp(regExp);
+    debugDataModel->setFilter(regExp, ui->columnComboBox->currentIndex());
 }
 
 void MegaDebugServer::filterColumn()
 {
-    debugProxyModel->setFilterKeyColumn(ui->columnComboBox->currentIndex());
+    filterTextRegExp();
 }
 
 void MegaDebugServer::filterCaseSensitive()
 {
-    debugProxyModel->setSortCaseSensitivity(ui->caseSensitivecheckBox->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    filterTextRegExp();
 }
 
 void MegaDebugServer::saveToFile()
@@ -216,42 +271,12 @@ void MegaDebugServer::saveToFile()
         return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QFile::Truncate))
+    if (!debugDataModel->save(fileName))
     {
-        QMessageBox::information(this, tr("Unable to open file"), file.errorString());
-        return;
-    }
-
-    QByteArray ba;
-    QXmlStreamWriter xmlWriterLog(&ba);
-    QDataStream out(&file);
-    out.setVersion(QDataStream::Qt_4_8);
-    qint32 n(debugDataModel->rowCount());
-
-    /* Writes a document start with the XML version number. */
-    xmlWriterLog.writeStartDocument();
-    xmlWriterLog.writeStartElement("MEGA");
-    for (int i = 0; i < n; i++)
-    {
-        xmlWriterLog.writeStartElement("log");
-        //Add timestamp and value
-        xmlWriterLog.writeAttribute("timestamp", debugDataModel->item(i,0)->text());
-        //Add type and value
-        xmlWriterLog.writeAttribute("type", debugDataModel->item(i,1)->text());
-        //Add content and value
-        xmlWriterLog.writeAttribute("content", debugDataModel->item(i,2)->text());
-        xmlWriterLog.writeEndElement();
+        QMessageBox::information(this, tr("Unable to save file"), fileName);
     }
-
-    //Close tags
-    xmlWriterLog.writeEndElement();
-    xmlWriterLog.writeEndDocument();
-    out << qCompress(ba);
-    file.close();
 }
 
-
 void MegaDebugServer::loadFromFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
@@ -263,6 +288,12 @@ void MegaDebugServer::loadFromFile()
         return;
     }
 
+    if (debugDataModel->load(fileName))
+    {
+        return;
+    }
+
+    // Logs saved by older versions
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly))
     {
@@ -283,12 +314,10 @@ void MegaDebugServer::loadFromFile()
 
 void MegaDebugServer::clearDebugWindow()
 {
-    debugDataModel->removeRows(0,debugDataModel->rowCount());
+    debugDataModel->clear();
 }
 MegaDebugServer::~MegaDebugServer()
 {
     disconnected();
-    delete debugDataModel;
-    delete debugProxyModel;
     delete ui;
 }
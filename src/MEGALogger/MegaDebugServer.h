@@ -5,20 +5,12 @@
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QObject>
-#include <QSortFilterProxyModel>
-#include <QStandardItemModel>
 #include <QXmlStreamReader>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QTimer>
 
-struct DebugRow
-{
-    QString timeStamp;
-    QString messageType;
-    QString content;
-
-};
+#include "LogModel.h"
 
 namespace Ui {
 class MegaDebugServer;
@@ -37,11 +29,11 @@ private:
     Ui::MegaDebugServer *ui;
     QLocalServer *megaServer;
     QLocalSocket *megaSyncClient;
-    QXmlStreamReader *reader;
+    QByteArray pendingData;
+    bool headerReceived;
     QLocalSocket client;
 
-    QSortFilterProxyModel *debugProxyModel;
-    QStandardItemModel *debugDataModel;
+    LogModel *debugDataModel;
     QTimer timer;
 
 private slots:
@@ -55,14 +47,14 @@ private slots:
     void filterColumn();
     void filterCaseSensitive();
 
-    void appendDebugRow(DebugRow *);
-
     void saveToFile();
     void loadFromFile();
     void clearDebugWindow();
 
 public:
     void parseReader(QXmlStreamReader *);
+    void parseRecords(const char *data, int size);
+    void appendDebugRow(int level, const QString &timeStamp, const QString &content);
 
 };
 
@@ -43,6 +43,7 @@ TEMPLATE = app
 #DEFINES += LOG_TO_LOGGER
 #DEFINES += LOG_TO_FILE
 #DEFINES += LOG_TO_STDOUT
+#DEFINES += ENABLE_TRACING
 
 debug {
     CONFIG += console
@@ -50,6 +51,7 @@ debug {
     DEFINES += LOG_TO_STDOUT
 #   DEFINES += LOG_TO_FILE
     DEFINES += LOG_TO_LOGGER
+    DEFINES += ENABLE_TRACING
 }
 
 CONFIG += USE_LIBUV
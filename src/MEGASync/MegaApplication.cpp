@@ -6,6 +6,7 @@
 #include "control/Utilities.h"
 #include "control/CrashHandler.h"
 #include "control/ExportProcessor.h"
+#include "control/Tracer.h"
 #include "platform/Platform.h"
 #include "qtlockedfile/qtlockedfile.h"
 
@@ -480,7 +481,10 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     QApplication(argc, argv)
 {
     appfinished = false;
+    Tracer::initialize();
     logger = new MegaSyncLogger(this);
+    CrashHandler::setLogger(logger);
+    connect(logger, SIGNAL(logsExported(QString, bool)), this, SLOT(onLogsExported(QString, bool)), Qt::QueuedConnection);
 
     #if defined(LOG_TO_STDOUT) || defined(LOG_TO_FILE) || defined(LOG_TO_LOGGER)
     #if defined(LOG_TO_STDOUT)
@@ -516,6 +520,16 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     }
 #endif
 
+#ifdef ENABLE_TRACING
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (!strcmp("--trace", argv[i]))
+        {
+            traceFilePath = QFileInfo(QString::fromLocal8Bit(argv[i + 1])).absoluteFilePath();
+        }
+    }
+#endif
+
     MegaApi::addLoggerObject(logger);
 
     //Set QApplication fields
@@ -569,6 +583,9 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     megaApi = NULL;
     megaApiFolders = NULL;
     delegateListener = NULL;
+    nodeUpdateProcessor = NULL;
+    transferDispatcher = NULL;
+    transferDispatchListener = NULL;
     httpServer = NULL;
     httpsServer = NULL;
     numTransfers[MegaTransfer::TYPE_DOWNLOAD] = 0;
@@ -633,6 +650,8 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     uploadAction = NULL;
     downloadAction = NULL;
     streamAction = NULL;
+    exportLogsAction = NULL;
+    saveTraceAction = NULL;
     webAction = NULL;
     addSyncAction = NULL;
     waiting = false;
@@ -653,6 +672,7 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     updateTask = NULL;
     multiUploadFileDialog = NULL;
     exitDialog = NULL;
+    syncCopyDialog = NULL;
     sslKeyPinningError = NULL;
     downloadNodeSelector = NULL;
     notificator = NULL;
@@ -664,9 +684,11 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     infoWizard = NULL;
     externalNodesTimestamp = 0;
     noKeyDetected = 0;
+    storageEpoch = 0;
     isFirstSyncDone = false;
     isFirstFileSynced = false;
     transferManager = NULL;
+    transferHistory = NULL;
     queuedUserStats = 0;
     cleaningSchedulerExecution = 0;
     lastUserActivityExecution = 0;
@@ -688,6 +710,7 @@ MegaApplication::~MegaApplication()
 {
     if (logger)
     {
+        CrashHandler::setLogger(NULL);
         MegaApi::removeLoggerObject(logger);
         delete logger;
     }
@@ -742,6 +765,17 @@ void MegaApplication::initialize()
         QMegaMessageBox::critical(NULL, QString::fromAscii("MEGAsync"), tr("Your config is corrupt, please start over"), Utilities::getDevicePixelRatio());
     }
 
+    long long rebootTime = 0;
+    if (CrashHandler::instance()->takeCrashFlag(&rebootTime))
+    {
+        preferences->setCrashed(true);
+        if (rebootTime)
+        {
+            preferences->setLastReboot(rebootTime);
+        }
+    }
+    CrashHandler::instance()->setLastReboot(preferences->getLastReboot());
+
     preferences->setLastStatsRequest(0);
     lastExit = preferences->getLastExit();
 
@@ -785,6 +819,12 @@ void MegaApplication::initialize()
     megaApi->log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("MEGAsync is starting. Version string: %1   Version code: %2.%3   User-Agent: %4").arg(Preferences::VERSION_STRING)
              .arg(Preferences::VERSION_CODE).arg(Preferences::BUILD_ID).arg(QString::fromUtf8(megaApi->getUserAgent())).toUtf8().constData());
 
+    transferHistory = new TransferHistory();
+    if (!transferHistory->open(QDir(dataPath).filePath(QString::fromAscii("transfers"))))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to open the transfer history");
+    }
+
     megaApi->setLanguage(currentLanguageCode.toUtf8().constData());
     megaApiFolders->setLanguage(currentLanguageCode.toUtf8().constData());
     megaApi->setDownloadMethod(preferences->transferDownloadMethod());
@@ -798,11 +838,18 @@ void MegaApplication::initialize()
     megaApi->retrySSLerrors(true);
     megaApi->setPublicKeyPinning(!preferences->SSLcertificateException());
 
+    transferDispatchListener = new MEGASyncTransferDispatchListener(this);
+    transferDispatcher = new TransferDispatcher(megaApi, transferDispatchListener, TransferDispatcher::DEFAULT_INTERVAL_MS, this);
     delegateListener = new MEGASyncDelegateListener(megaApi, this, this);
     megaApi->addListener(delegateListener);
     uploader = new MegaUploader(megaApi);
+    connect(uploader, SIGNAL(uploadBatchPlanned(unsigned long long, int, int, int)), this, SLOT(onUploadBatchPlanned(unsigned long long, int, int, int)), Qt::QueuedConnection);
+    connect(uploader, SIGNAL(copyProgress(long long, long long, int, int)), this, SLOT(onSyncCopyProgress(long long, long long, int, int)));
+    connect(uploader, SIGNAL(copyFinished(bool)), this, SLOT(onSyncCopyFinished(bool)));
     downloader = new MegaDownloader(megaApi);
-    connect(downloader, SIGNAL(finishedTransfers(unsigned long long)), this, SLOT(showNotificationFinishedTransfers(unsigned long long)), Qt::QueuedConnection);
+    connect(downloader, SIGNAL(foldersCreated(unsigned long long, int, int, int)), this, SLOT(onDownloadFoldersCreated(unsigned long long, int, int, int)), Qt::QueuedConnection);
+    nodeUpdateProcessor = new NodeUpdateProcessor(megaApi);
+    connect(nodeUpdateProcessor, SIGNAL(nodesProcessed(NodeUpdateSummary)), this, SLOT(onNodesProcessed(NodeUpdateSummary)), Qt::QueuedConnection);
 
 
     connectivityTimer = new QTimer(this);
@@ -1599,6 +1646,7 @@ void MegaApplication::applyStorageState(int state)
                     {
                         preferences->setUsedStorage(preferences->totalStorage());
                         preferences->sync();
+                        storageEpoch++;
 
                         if (infoDialog)
                         {
@@ -1691,38 +1739,34 @@ void MegaApplication::processUploadQueue(MegaHandle nodeHandle)
         return;
     }
 
+    if (uploadQueue.isEmpty())
+    {
+        delete node;
+        return;
+    }
+
     unsigned long long transferId = preferences->transferIdentifier();
     TransferMetaData* data = new TransferMetaData(MegaTransfer::TYPE_UPLOAD, uploadQueue.size(), uploadQueue.size());
     transferAppData.insert(transferId, data);
     preferences->setOverStorageDismissExecution(0);
 
-    //Process the upload queue using the MegaUploader object
-    while (!uploadQueue.isEmpty())
+    // Load parent folder to provide "Show in Folder" option
+    QDir uploadPath(uploadQueue.head());
+    if (data->totalTransfers > 1)
     {
-        QString filePath = uploadQueue.dequeue();
-
-        // Load parent folder to provide "Show in Folder" option
-        if (data->localPath.isEmpty())
-        {
-            QDir uploadPath(filePath);
-            if (data->totalTransfers > 1)
-            {
-                uploadPath.cdUp();
-            }
-            data->localPath = uploadPath.path();
-        }
-
-        if (QFileInfo (filePath).isDir())
-        {
-            data->totalFolders++;
-        }
-        else
-        {
-            data->totalFiles++;
-        }
+        uploadPath.cdUp();
+    }
+    data->localPath = uploadPath.path();
 
-        uploader->upload(filePath, node, transferId);
+    //Process the upload queue using the MegaUploader object.
+    //Paths are checked from a worker thread, that reports them in onUploadBatchPlanned
+    QStringList paths;
+    paths.reserve(uploadQueue.size());
+    while (!uploadQueue.isEmpty())
+    {
+        paths.append(uploadQueue.dequeue());
     }
+    uploader->upload(paths, node, transferId);
     delete node;
 }
 
@@ -2461,7 +2505,6 @@ void MegaApplication::cleanAll()
     }
 
     closeDialogs();
-    removeAllFinishedTransfers();
     clearViewedTransfers();
 
     delete bwOverquotaDialog;
@@ -2476,12 +2519,22 @@ void MegaApplication::cleanAll()
     httpServer = NULL;
     delete httpsServer;
     httpsServer = NULL;
+    delete syncCopyDialog;
+    syncCopyDialog = NULL;
     delete uploader;
     uploader = NULL;
     delete downloader;
     downloader = NULL;
+    delete nodeUpdateProcessor;
+    nodeUpdateProcessor = NULL;
     delete delegateListener;
     delegateListener = NULL;
+    delete transferDispatcher;
+    transferDispatcher = NULL;
+    delete transferDispatchListener;
+    transferDispatchListener = NULL;
+    delete transferHistory;
+    transferHistory = NULL;
     delete pricing;
     pricing = NULL;
 
@@ -2511,13 +2564,20 @@ void MegaApplication::cleanAll()
     megaApiFolders = NULL;
 
     preferences->setLastExit(QDateTime::currentMSecsSinceEpoch());
+    preferences->waitForSync();
     trayIcon->deleteLater();
     trayIcon = NULL;
 
+    CrashHandler::setLogger(NULL);
     MegaApi::removeLoggerObject(logger);
     delete logger;
     logger = NULL;
 
+    if (!traceFilePath.isEmpty())
+    {
+        Tracer::save(traceFilePath);
+    }
+
     if (reboot)
     {
 #ifndef __APPLE__
@@ -3219,9 +3279,10 @@ void MegaApplication::cleanLocalCaches()
     if (preferences->cleanerDaysLimit())
     {
         int timeLimitDays = preferences->cleanerDaysLimitValue();
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+        QSharedPointer<const SyncRegistry> syncs = preferences->getSyncRegistry();
+        for (int i = 0; i < syncs->size(); i++)
         {
-            QString syncPath = preferences->getLocalFolder(i);
+            QString syncPath = syncs->at(i).localPath;
             if (!syncPath.isEmpty())
             {
                 QDir cacheDir(syncPath + QDir::separator() + QString::fromAscii(MEGA_DEBRIS_FOLDER));
@@ -3613,7 +3674,7 @@ void MegaApplication::checkFirstTransfer()
         MegaTransfer *nextTransfer = megaApi->getFirstTransfer(MegaTransfer::TYPE_DOWNLOAD);
         if (nextTransfer)
         {
-            onTransferUpdate(megaApi, nextTransfer);
+            processTransferUpdate(nextTransfer);
             delete nextTransfer;
         }
     }
@@ -3623,7 +3684,7 @@ void MegaApplication::checkFirstTransfer()
         MegaTransfer *nextTransfer = megaApi->getFirstTransfer(MegaTransfer::TYPE_UPLOAD);
         if (nextTransfer)
         {
-            onTransferUpdate(megaApi, nextTransfer);
+            processTransferUpdate(nextTransfer);
             delete nextTransfer;
         }
     }
@@ -3693,6 +3754,84 @@ int MegaApplication::getPrevVersion()
     return prevVersion;
 }
 
+void MegaApplication::onUploadBatchPlanned(unsigned long long appDataId, int numFiles, int numFolders, int numSkipped)
+{
+    QHash<unsigned long long, TransferMetaData*>::iterator it
+           = transferAppData.find(appDataId);
+    if (it == transferAppData.end())
+    {
+        return;
+    }
+
+    TransferMetaData *data = it.value();
+    data->totalFiles += numFiles;
+    data->totalFolders += numFolders;
+    if (numSkipped)
+    {
+        // Skipped paths and copies into synced folders won't finish any transfer
+        data->pendingTransfers -= numSkipped;
+        showNotificationFinishedTransfers(appDataId);
+    }
+}
+
+void MegaApplication::onDownloadFoldersCreated(unsigned long long appDataId, int numFinished, int numTopLevelOK, int numTopLevelFailed)
+{
+    QHash<unsigned long long, TransferMetaData*>::iterator it
+           = transferAppData.find(appDataId);
+    if (it == transferAppData.end())
+    {
+        return;
+    }
+
+    TransferMetaData *data = it.value();
+    data->transfersFolderOK += numTopLevelOK;
+    data->transfersFailed += numTopLevelFailed;
+    data->pendingTransfers -= numFinished;
+    showNotificationFinishedTransfers(appDataId);
+}
+
+void MegaApplication::onSyncCopyProgress(long long copiedBytes, long long totalBytes, int copiedFiles, int totalFiles)
+{
+    if (appfinished)
+    {
+        return;
+    }
+
+    if (!syncCopyDialog)
+    {
+        // The dialog only shows up for copies that take a while
+        syncCopyDialog = new QProgressDialog(QString(), tr("Cancel"), 0, 100);
+        syncCopyDialog->setWindowTitle(tr("MEGAsync"));
+        syncCopyDialog->setMinimumDuration(2000);
+        syncCopyDialog->setAutoClose(false);
+        syncCopyDialog->setAutoReset(false);
+        connect(syncCopyDialog, SIGNAL(canceled()), uploader, SLOT(cancelCopies()));
+    }
+
+    syncCopyDialog->setLabelText(tr("Copying files to the synced folder (%1 of %2 files, %3 of %4)")
+                                 .arg(copiedFiles).arg(totalFiles)
+                                 .arg(Utilities::getSizeString(copiedBytes))
+                                 .arg(Utilities::getSizeString(totalBytes)));
+    syncCopyDialog->setValue(totalBytes ? (int)(copiedBytes * 100 / totalBytes) : 0);
+}
+
+void MegaApplication::onSyncCopyFinished(bool cancelled)
+{
+    if (syncCopyDialog)
+    {
+        // close() would report a cancellation
+        syncCopyDialog->disconnect();
+        syncCopyDialog->close();
+        syncCopyDialog->deleteLater();
+        syncCopyDialog = NULL;
+    }
+
+    if (cancelled)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Copy to synced folder cancelled");
+    }
+}
+
 void MegaApplication::showNotificationFinishedTransfers(unsigned long long appDataId)
 {
     QHash<unsigned long long, TransferMetaData*>::iterator it
@@ -4036,38 +4175,114 @@ void MegaApplication::toggleLogging()
                      .arg(Preferences::VERSION_CODE).arg(Preferences::BUILD_ID).arg(QString::fromUtf8(megaApi->getUserAgent())).toUtf8().constData());
         }
     }
+
+    if (exportLogsAction)
+    {
+        exportLogsAction->setVisible(logger->isLogToFileEnabled());
+    }
+}
+
+void MegaApplication::exportLogs()
+{
+    if (appfinished)
+    {
+        return;
+    }
+
+    QString defaultPath = QFileInfo(QDir::home(), QString::fromUtf8("MEGAsync-logs.gz")).absoluteFilePath();
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export logs"), defaultPath,
+                                                    QString::fromUtf8("Gzip file (*.gz)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    //Segments are compressed and written in a background thread
+    logger->exportLogs(fileName);
+}
+
+void MegaApplication::saveTrace()
+{
+    if (appfinished)
+    {
+        return;
+    }
+
+    QString defaultPath = QFileInfo(QDir::home(), QString::fromUtf8("MEGAsync-trace.json")).absoluteFilePath();
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Save trace"), defaultPath,
+                                                    QString::fromUtf8("Trace file (*.json)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    if (Tracer::save(fileName))
+    {
+        showInfoMessage(tr("Trace saved to %1").arg(QDir::toNativeSeparators(fileName)));
+    }
+    else
+    {
+        showErrorMessage(tr("Error saving trace to %1").arg(QDir::toNativeSeparators(fileName)));
+    }
+}
+
+void MegaApplication::onLogsExported(QString path, bool success)
+{
+    if (appfinished)
+    {
+        return;
+    }
+
+    if (success)
+    {
+        showInfoMessage(tr("Logs exported to %1").arg(QDir::toNativeSeparators(path)));
+    }
+    else
+    {
+        showErrorMessage(tr("Error exporting logs to %1").arg(QDir::toNativeSeparators(path)));
+    }
 }
 
-void MegaApplication::removeFinishedTransfer(int transferTag)
+void MegaApplication::removeFinishedTransfer(int historyId)
 {
-    QMap<int, MegaTransfer*>::iterator it = finishedTransfers.find(transferTag);
-    if (it != finishedTransfers.end())
-    {     
-        for (QList<MegaTransfer*>::iterator it2 = finishedTransferOrder.begin(); it2 != finishedTransferOrder.end(); it2++)
+    int transferTag;
+    if (transferHistory->remove(historyId, &transferTag))
+    {
+        // Tags are only meaningful for transfers of this session
+        if (transferHistory->isFromCurrentSession(historyId))
         {
-            if ((*it2)->getTag() == transferTag)
-            {
-                finishedTransferOrder.erase(it2);
-                break;
-            }
+            emit clearFinishedTransfer(transferTag);
         }
-        delete it.value();
-        finishedTransfers.erase(it);
 
-        emit clearFinishedTransfer(transferTag);
-
-        if (!finishedTransfers.size() && infoDialog)
+        if (transferHistory->isEmpty() && infoDialog)
         {
             infoDialog->updateDialogState();
         }
     }
 }
 
+void MegaApplication::removeFinishedTransfers(const QList<int> &historyIds)
+{
+    QList<int> transferTags;
+    if (!transferHistory->remove(historyIds, &transferTags))
+    {
+        return;
+    }
+
+    for (int i = 0; i < transferTags.size(); i++)
+    {
+        emit clearFinishedTransfer(transferTags.at(i));
+    }
+
+    if (transferHistory->isEmpty() && infoDialog)
+    {
+        infoDialog->updateDialogState();
+    }
+}
+
 void MegaApplication::removeAllFinishedTransfers()
 {
-    qDeleteAll(finishedTransfers);
-    finishedTransferOrder.clear();
-    finishedTransfers.clear();
+    transferHistory->clear();
 
     emit clearAllFinishedTransfers();
 
@@ -4077,9 +4292,9 @@ void MegaApplication::removeAllFinishedTransfers()
     }
 }
 
-QList<MegaTransfer*> MegaApplication::getFinishedTransfers()
+TransferHistory *MegaApplication::getTransferHistory()
 {
-    return finishedTransferOrder;
+    return transferHistory;
 }
 
 int MegaApplication::getNumUnviewedTransfers()
@@ -4087,15 +4302,6 @@ int MegaApplication::getNumUnviewedTransfers()
     return nUnviewedTransfers;
 }
 
-MegaTransfer* MegaApplication::getFinishedTransferByTag(int tag)
-{
-    if (!finishedTransfers.contains(tag))
-    {
-        return NULL;
-    }
-    return finishedTransfers.value(tag);
-}
-
 void MegaApplication::pauseTransfers()
 {
     pauseTransfers(!preferences->getGlobalPaused());
@@ -5889,6 +6095,28 @@ void MegaApplication::createTrayMenu()
     streamAction = new MenuItemAction(tr("Stream"), QIcon(QString::fromAscii("://images/ico_stream_out.png")), QIcon(QString::fromAscii("://images/ico_stream_over.png")), true);
     connect(streamAction, SIGNAL(triggered()), this, SLOT(streamActionClicked()), Qt::QueuedConnection);
 
+    if (exportLogsAction)
+    {
+        exportLogsAction->deleteLater();
+        exportLogsAction = NULL;
+    }
+
+    // No icon of its own yet, the empty one keeps the text aligned with the other items
+    exportLogsAction = new MenuItemAction(tr("Export logs"), QIcon(), true);
+    connect(exportLogsAction, SIGNAL(triggered()), this, SLOT(exportLogs()), Qt::QueuedConnection);
+    exportLogsAction->setVisible(logger->isLogToFileEnabled());
+
+    if (saveTraceAction)
+    {
+        saveTraceAction->deleteLater();
+        saveTraceAction = NULL;
+    }
+
+#ifdef ENABLE_TRACING
+    saveTraceAction = new MenuItemAction(tr("Save trace"), QIcon(), true);
+    connect(saveTraceAction, SIGNAL(triggered()), this, SLOT(saveTrace()), Qt::QueuedConnection);
+#endif
+
     if (updateAction)
     {
         updateAction->deleteLater();
@@ -5914,6 +6142,11 @@ void MegaApplication::createTrayMenu()
     trayMenu->addAction(downloadAction);
     trayMenu->addAction(streamAction);
     trayMenu->addAction(settingsAction);
+    trayMenu->addAction(exportLogsAction);
+    if (saveTraceAction)
+    {
+        trayMenu->addAction(saveTraceAction);
+    }
     trayMenu->addSeparator();
     trayMenu->addAction(exitAction);
 }
@@ -5995,6 +6228,7 @@ void MegaApplication::createGuestMenu()
 
 void MegaApplication::onEvent(MegaApi *api, MegaEvent *event)
 {
+    TRACE_SPAN("MegaApplication::onEvent");
     if (event->getType() == MegaEvent::EVENT_CHANGE_TO_HTTPS)
     {
         preferences->setUseHttpsOnly(true);
@@ -6018,6 +6252,7 @@ void MegaApplication::onEvent(MegaApi *api, MegaEvent *event)
 //Called when a request is about to start
 void MegaApplication::onRequestStart(MegaApi* , MegaRequest *request)
 {
+    TRACE_SPAN("MegaApplication::onRequestStart");
     if (appfinished)
     {
         return;
@@ -6032,6 +6267,7 @@ void MegaApplication::onRequestStart(MegaApi* , MegaRequest *request)
 //Called when a request has finished
 void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError* e)
 {
+    TRACE_SPAN("MegaApplication::onRequestFinish");
     if (appfinished)
     {
         return;
@@ -6420,6 +6656,7 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
         preferences->setAccountType(details->getProLevel());
         preferences->setTotalStorage(details->getStorageMax());
         preferences->setUsedStorage(details->getStorageUsed());
+        storageEpoch++;
         preferences->setTotalBandwidth(details->getTransferMax());
         preferences->setBandwidthInterval(details->getTemporalBandwidthInterval());
         preferences->setUsedBandwidth(details->getProLevel() ? details->getTransferOwnUsed() : details->getTemporalBandwidth());
@@ -6814,13 +7051,24 @@ void MegaApplication::onRequestFinish(MegaApi*, MegaRequest *request, MegaError*
 }
 
 //Called when a transfer is about to start
-void MegaApplication::onTransferStart(MegaApi *api, MegaTransfer *transfer)
+void MegaApplication::onTransferStart(MegaApi *, MegaTransfer *transfer)
 {
+    TRACE_SPAN("MegaApplication::onTransferStart");
     if (appfinished || transfer->isStreamingTransfer() || transfer->isFolderTransfer())
     {
         return;
     }
 
+    transferDispatcher->onTransferStart(transfer);
+}
+
+void MegaApplication::processTransferStart(MegaTransfer *transfer)
+{
+    if (appfinished)
+    {
+        return;
+    }
+
     if (transfer->getType() == MegaTransfer::TYPE_DOWNLOAD)
     {
         HTTPServer::onTransferDataUpdate(transfer->getNodeHandle(),
@@ -6835,7 +7083,7 @@ void MegaApplication::onTransferStart(MegaApi *api, MegaTransfer *transfer)
         transferManager->onTransferStart(megaApi, transfer);
     }
 
-    onTransferUpdate(api, transfer);
+    processTransferUpdate(transfer);
     if (!numTransfers[MegaTransfer::TYPE_DOWNLOAD]
             && !numTransfers[MegaTransfer::TYPE_UPLOAD])
     {
@@ -6847,16 +7095,28 @@ void MegaApplication::onTransferStart(MegaApi *api, MegaTransfer *transfer)
 //Called when there is a temporal problem in a request
 void MegaApplication::onRequestTemporaryError(MegaApi *, MegaRequest *, MegaError* )
 {
+    TRACE_SPAN("MegaApplication::onRequestTemporaryError");
 }
 
 //Called when a transfer has finished
 void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaError* e)
 {
+    TRACE_SPAN("MegaApplication::onTransferFinish");
     if (appfinished || transfer->isStreamingTransfer())
     {
         return;
     }
 
+    transferDispatcher->onTransferFinish(transfer, e);
+}
+
+void MegaApplication::processTransferFinish(MegaTransfer *transfer, MegaError *e)
+{
+    if (appfinished)
+    {
+        return;
+    }
+
     // check if it's a top level transfer
     int folderTransferTag = transfer->getFolderTransferTag();
     if (folderTransferTag == 0 // file transfer
@@ -6901,16 +7161,9 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
 
     if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
     {
-        MegaTransfer *t = transfer->copy();
-        if (finishedTransfers.count(transfer->getTag()))
-        {
-            assert(false);
-            megaApi->sendEvent(99512, QString::fromUtf8("Duplicated finished transfer: %1").arg(QString::number(transfer->getTag())).toUtf8().constData());
-            removeFinishedTransfer(transfer->getTag());
-        }
-
-        finishedTransfers.insert(transfer->getTag(), t);
-        finishedTransferOrder.push_back(t);
+        TransferRowData row;
+        row.update(transfer);
+        transferHistory->append(row);
 
         if (!transferManager)
         {
@@ -6947,11 +7200,6 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
         infoDialog->onTransferFinish(megaApi, transfer, e);
     }
 
-    if (finishedTransferOrder.size() > Preferences::MAX_COMPLETED_ITEMS)
-    {
-        removeFinishedTransfer(finishedTransferOrder.first()->getTag());
-    }
-
     //Show the transfer in the "recently updated" list
     if (e->getErrorCode() == MegaError::API_OK && transfer->getNodeHandle() != INVALID_HANDLE)
     {
@@ -7030,6 +7278,17 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
 
 //Called when a transfer has been updated
 void MegaApplication::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
+{
+    TRACE_SPAN("MegaApplication::onTransferUpdate");
+    if (appfinished || transfer->isStreamingTransfer() || transfer->isFolderTransfer())
+    {
+        return;
+    }
+
+    transferDispatcher->onTransferUpdate(transfer);
+}
+
+void MegaApplication::processTransferUpdate(MegaTransfer *transfer)
 {
     if (appfinished || transfer->isStreamingTransfer() || transfer->isFolderTransfer())
     {
@@ -7084,19 +7343,18 @@ void MegaApplication::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
 //Called when there is a temporal problem in a transfer
 void MegaApplication::onTransferTemporaryError(MegaApi *api, MegaTransfer *transfer, MegaError* e)
 {
+    TRACE_SPAN("MegaApplication::onTransferTemporaryError");
     if (appfinished)
     {
         return;
     }
 
-    if (transferManager)
-    {
-        transferManager->onTransferTemporaryError(megaApi, transfer, e);
-    }
-
+    // Models handle temporary errors as regular updates, so they are coalesced too
     onTransferUpdate(api, transfer);
+    preferences->beginTransaction();
     preferences->setTransferDownloadMethod(api->getDownloadMethod());
     preferences->setTransferUploadMethod(api->getUploadMethod());
+    preferences->commitTransaction();
 
     if (e->getErrorCode() == MegaError::API_EOVERQUOTA && e->getValue() && bwOverquotaTimestamp <= (QDateTime::currentMSecsSinceEpoch() / 1000))
     {
@@ -7116,6 +7374,7 @@ void MegaApplication::onTransferTemporaryError(MegaApi *api, MegaTransfer *trans
 
 void MegaApplication::onAccountUpdate(MegaApi *)
 {
+    TRACE_SPAN("MegaApplication::onAccountUpdate");
     if (appfinished || !preferences->logged())
     {
         return;
@@ -7133,6 +7392,7 @@ void MegaApplication::onAccountUpdate(MegaApi *)
 //Called when contacts have been updated in MEGA
 void MegaApplication::onUsersUpdate(MegaApi *, MegaUserList *userList)
 {
+    TRACE_SPAN("MegaApplication::onUsersUpdate");
     if (appfinished || !infoDialog || !userList || !preferences->logged())
     {
         return;
@@ -7176,124 +7436,94 @@ void MegaApplication::onUsersUpdate(MegaApi *, MegaUserList *userList)
 //Called when nodes have been updated in MEGA
 void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
 {
+    TRACE_SPAN("MegaApplication::onNodesUpdate");
     if (appfinished || !infoDialog || !nodes || !preferences->logged())
     {
         return;
     }
 
-    bool externalNodes = false;
-    bool newNodes = false;
-    bool nodesRemoved = false;
-    long long usedStorage = preferences->usedStorage();
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("%1 updated files/folders").arg(nodes->size()).toUtf8().constData());
 
-    //Check all modified nodes
-    QString localPath;
-    for (int i = 0; i < nodes->size(); i++)
-    {
-        localPath.clear();
-        MegaNode *node = nodes->get(i);
-
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
-        {
-            if (!preferences->isFolderActive(i))
-            {
-                continue;
-            }
+    //Nodes are checked in a worker thread, that reports the results in onNodesProcessed
+    nodeUpdateProcessor->process(nodes->copy(), preferences->getSyncRegistry(), nodescurrent, lastExit,
+                                 preferences->email(), storageEpoch);
+}
 
-            if (node->getType() == MegaNode::TYPE_FOLDER
-                    && (node->getHandle() == preferences->getMegaFolderHandle(i)))
-            {
-                MegaNode *nodeByHandle = megaApi->getNodeByHandle(preferences->getMegaFolderHandle(i));
-                const char *nodePath = megaApi->getNodePath(nodeByHandle);
+void MegaApplication::onNodesProcessed(NodeUpdateSummary summary)
+{
+    TRACE_SPAN("MegaApplication::onNodesProcessed");
+    if (appfinished || !infoDialog || !preferences->logged()
+            || summary.account != preferences->email())
+    {
+        return;
+    }
 
-                if (!nodePath || preferences->getMegaFolder(i).compare(QString::fromUtf8(nodePath)))
-                {
-                    if (nodePath && QString::fromUtf8(nodePath).startsWith(QString::fromUtf8("//bin")))
-                    {
-                        showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder is in the rubbish bin")
-                                         .arg(preferences->getSyncName(i)));
-                    }
-                    else
-                    {
-                        showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder doesn't exist")
-                                         .arg(preferences->getSyncName(i)));
-                    }
-                    Platform::syncFolderRemoved(preferences->getLocalFolder(i),
-                                                preferences->getSyncName(i),
-                                                preferences->getSyncID(i));
-                    notifyItemChange(preferences->getLocalFolder(i), MegaApi::STATE_NONE);
-                    MegaNode *node = megaApi->getNodeByHandle(preferences->getMegaFolderHandle(i));
-                    megaApi->removeSync(node);
-                    delete node;
-                    preferences->setSyncState(i, false);
-                    openSettings(SettingsDialog::SYNCS_TAB);
-                    createTrayMenu();
-                }
+    // Account details received meanwhile already include these changes
+    bool storageCurrent = summary.storageEpoch == storageEpoch;
 
-                delete nodeByHandle;
-                delete [] nodePath;
-            }
+    for (int i = 0; i < summary.disabledSyncs.size(); i++)
+    {
+        const DisabledSync &sync = summary.disabledSyncs.at(i);
+        int num = preferences->getSyncIDs().indexOf(sync.syncID);
+        if (num < 0 || !preferences->isFolderActive(num))
+        {
+            continue;
         }
 
-        if (nodescurrent && node->isRemoved() && (node->getType() == MegaNode::TYPE_FILE) && node->getSize())
+        if (sync.inRubbishBin)
         {
-            usedStorage -= node->getSize();
-            nodesRemoved = true;
+            showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder is in the rubbish bin")
+                             .arg(sync.name));
         }
-
-        if (nodescurrent && !node->isRemoved() && !node->isSyncDeleted()
-                && (node->getType() == MegaNode::TYPE_FILE)
-                && node->getSize() && node->hasChanged(MegaNode::CHANGE_TYPE_NEW))
+        else
         {
-            long long bytes = node->getSize();
-            if (!megaApi->isInCloud(node))
-            {
-                preferences->setInShareStorage(preferences->inShareStorage() + bytes);
-            }
-            else
-            {
-                preferences->setCloudDriveStorage(preferences->cloudDriveStorage() + bytes);
-            }
+            showErrorMessage(tr("Your sync \"%1\" has been disabled because the remote folder doesn't exist")
+                             .arg(sync.name));
+        }
+        Platform::syncFolderRemoved(sync.localPath, sync.name, sync.syncID);
+        notifyItemChange(sync.localPath, MegaApi::STATE_NONE);
+        MegaNode *node = megaApi->getNodeByHandle(sync.handle);
+        megaApi->removeSync(node);
+        delete node;
+        preferences->setSyncState(num, false);
+        openSettings(SettingsDialog::SYNCS_TAB);
+        createTrayMenu();
+    }
 
-            usedStorage += bytes;
-            newNodes = true;
+    if (storageCurrent && summary.inShareDelta)
+    {
+        preferences->setInShareStorage(preferences->inShareStorage() + summary.inShareDelta);
+    }
 
-            if (!externalNodes && !node->getTag()
-                    && ((lastExit / 1000) < node->getCreationTime())
-                    && megaApi->isInsideSync(node))
-            {
-                externalNodes = true;
-            }
-        }
+    if (storageCurrent && summary.cloudDriveDelta)
+    {
+        preferences->setCloudDriveStorage(preferences->cloudDriveStorage() + summary.cloudDriveDelta);
+    }
 
-        if (!node->isRemoved() && node->getTag()
-                && !node->isSyncDeleted()
-                && (node->getType() == MegaNode::TYPE_FILE)
-                && node->getAttrString()->size())
+    for (int i = 0; i < summary.numNoKeyNodes; i++)
+    {
+        //NO_KEY node created by this client detected
+        if (!noKeyDetected)
         {
-            //NO_KEY node created by this client detected
-            if (!noKeyDetected)
-            {
-                if (megaApi->isLoggedIn())
-                {
-                    megaApi->fetchNodes();
-                }
-            }
-            else if (noKeyDetected > 20)
+            if (megaApi->isLoggedIn())
             {
-                QMegaMessageBox::critical(NULL, QString::fromUtf8("MEGAsync"),
-                    QString::fromUtf8("Something went wrong. MEGAsync will restart now. If the problem persists please contact bug@mega.co.nz"), Utilities::getDevicePixelRatio());
-                preferences->setCrashed(true);
-                rebootApplication(false);
+                megaApi->fetchNodes();
             }
-            noKeyDetected++;
         }
+        else if (noKeyDetected > 20)
+        {
+            QMegaMessageBox::critical(NULL, QString::fromUtf8("MEGAsync"),
+                QString::fromUtf8("Something went wrong. MEGAsync will restart now. If the problem persists please contact bug@mega.co.nz"), Utilities::getDevicePixelRatio());
+            preferences->setCrashed(true);
+            rebootApplication(false);
+            break;
+        }
+        noKeyDetected++;
     }
 
-    if (nodesRemoved || newNodes)
+    if (storageCurrent && (summary.nodesRemoved || summary.newNodes))
     {
-        preferences->setUsedStorage(usedStorage);
+        preferences->setUsedStorage(preferences->usedStorage() + summary.usedStorageDelta);
         preferences->sync();
 
         if (infoDialog)
@@ -7317,7 +7547,7 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
         }
     }
 
-    if (externalNodes)
+    if (summary.externalNodes)
     {
         if (QDateTime::currentMSecsSinceEpoch() - externalNodesTimestamp > Preferences::MIN_EXTERNAL_NODES_WARNING_MS)
         {
@@ -7329,6 +7559,7 @@ void MegaApplication::onNodesUpdate(MegaApi* , MegaNodeList *nodes)
 
 void MegaApplication::onReloadNeeded(MegaApi*)
 {
+    TRACE_SPAN("MegaApplication::onReloadNeeded");
     if (appfinished)
     {
         return;
@@ -7342,6 +7573,7 @@ void MegaApplication::onReloadNeeded(MegaApi*)
 
 void MegaApplication::onGlobalSyncStateChanged(MegaApi *)
 {
+    TRACE_SPAN("MegaApplication::onGlobalSyncStateChanged");
     if (appfinished)
     {
         return;
@@ -7383,6 +7615,7 @@ void MegaApplication::onGlobalSyncStateChanged(MegaApi *)
 
 void MegaApplication::onSyncStateChanged(MegaApi *api, MegaSync *)
 {
+    TRACE_SPAN("MegaApplication::onSyncStateChanged");
     if (appfinished)
     {
         return;
@@ -7393,6 +7626,7 @@ void MegaApplication::onSyncStateChanged(MegaApi *api, MegaSync *)
 
 void MegaApplication::onSyncFileStateChanged(MegaApi *, MegaSync *, string *localPath, int newState)
 {
+    TRACE_SPAN("MegaApplication::onSyncFileStateChanged");
     if (appfinished)
     {
         return;
@@ -7460,3 +7694,23 @@ void MEGASyncDelegateListener::onRequestFinish(MegaApi *api, MegaRequest *reques
         }
     }
 }
+
+MEGASyncTransferDispatchListener::MEGASyncTransferDispatchListener(MegaApplication *app)
+{
+    this->app = app;
+}
+
+void MEGASyncTransferDispatchListener::onTransferStart(MegaApi *, MegaTransfer *transfer)
+{
+    app->processTransferStart(transfer);
+}
+
+void MEGASyncTransferDispatchListener::onTransferFinish(MegaApi *, MegaTransfer *transfer, MegaError *e)
+{
+    app->processTransferFinish(transfer, e);
+}
+
+void MEGASyncTransferDispatchListener::onTransferUpdate(MegaApi *, MegaTransfer *transfer)
+{
+    app->processTransferUpdate(transfer);
+}
@@ -12,6 +12,7 @@
 #include <QQueue>
 #include <QNetworkConfigurationManager>
 #include <QNetworkInterface>
+#include <QProgressDialog>
 
 #include "gui/TransferManager.h"
 #include "gui/NodeSelector.h"
@@ -28,12 +29,15 @@
 #include "gui/ChangeLogDialog.h"
 #include "gui/UpgradeDialog.h"
 #include "gui/InfoWizard.h"
+#include "gui/TransferHistory.h"
 #include "control/Preferences.h"
 #include "control/HTTPServer.h"
 #include "control/MegaUploader.h"
 #include "control/MegaDownloader.h"
+#include "control/NodeUpdateProcessor.h"
 #include "control/UpdateTask.h"
 #include "control/MegaSyncLogger.h"
+#include "control/TransferDispatcher.h"
 #include "megaapi.h"
 #include "QTMegaListener.h"
 
@@ -69,6 +73,7 @@ public:
 
 class Notificator;
 class MEGASyncDelegateListener;
+class MEGASyncTransferDispatchListener;
 
 class MegaApplication : public QApplication, public mega::MegaListener
 {
@@ -107,6 +112,10 @@ public:
     virtual void onSyncStateChanged(mega::MegaApi *api,  mega::MegaSync *sync);
     virtual void onSyncFileStateChanged(mega::MegaApi *api, mega::MegaSync *sync, std::string *localPath, int newState);
 
+    // Coalesced transfer events delivered by the TransferDispatcher
+    void processTransferStart(mega::MegaTransfer *transfer);
+    void processTransferFinish(mega::MegaTransfer *transfer, mega::MegaError* e);
+    void processTransferUpdate(mega::MegaTransfer *transfer);
 
     mega::MegaApi *getMegaApi() { return megaApi; }
 
@@ -130,11 +139,11 @@ public:
     void showTrayMenu(QPoint *point = NULL);
     void createTrayMenu();
     void toggleLogging();
-    QList<mega::MegaTransfer* > getFinishedTransfers();
+    TransferHistory *getTransferHistory();
     int getNumUnviewedTransfers();
-    void removeFinishedTransfer(int transferTag);
+    void removeFinishedTransfer(int historyId);
+    void removeFinishedTransfers(const QList<int> &historyIds);
     void removeAllFinishedTransfers();
-    mega::MegaTransfer* getFinishedTransferByTag(int tag);
 
     TransferMetaData* getTransferAppData(unsigned long long appDataID);
 
@@ -156,6 +165,8 @@ public slots:
     void openBwOverquotaDialog();
     void changeProxy();
     void importLinks();
+    void exportLogs();
+    void saveTrace();
     void officialWeb();
     void pauseTransfers();
     void showChangeLog();
@@ -220,6 +231,12 @@ public slots:
     int getPrevVersion();
     void onDismissOQ(bool overStorage);
     void showNotificationFinishedTransfers(unsigned long long appDataId);
+    void onUploadBatchPlanned(unsigned long long appDataId, int numFiles, int numFolders, int numSkipped);
+    void onDownloadFoldersCreated(unsigned long long appDataId, int numFinished, int numTopLevelOK, int numTopLevelFailed);
+    void onNodesProcessed(NodeUpdateSummary summary);
+    void onLogsExported(QString path, bool success);
+    void onSyncCopyProgress(long long copiedBytes, long long totalBytes, int copiedFiles, int totalFiles);
+    void onSyncCopyFinished(bool cancelled);
     void renewLocalSSLcert();
 #ifdef __APPLE__
     void enableFinderExt();
@@ -281,6 +298,8 @@ protected:
     MenuItemAction *uploadAction;
     MenuItemAction *downloadAction;
     MenuItemAction *streamAction;
+    MenuItemAction *exportLogsAction;
+    MenuItemAction *saveTraceAction;
     MenuItemAction *webAction;
     MenuItemAction *addSyncAction;
 
@@ -338,8 +357,11 @@ protected:
     bool bwOverquotaEvent;
     InfoWizard *infoWizard;
     mega::QTMegaListener *delegateListener;
+    TransferDispatcher *transferDispatcher;
+    MEGASyncTransferDispatchListener *transferDispatchListener;
     MegaUploader *uploader;
     MegaDownloader *downloader;
+    NodeUpdateProcessor *nodeUpdateProcessor;
     QTimer *periodicTasksTimer;
     QTimer *infoDialogTimer;
     QTimer *firstTransferTimer;
@@ -348,6 +370,7 @@ protected:
     ChangeLogDialog *changeLogDialog;
     ImportMegaLinksDialog *importDialog;
     QMessageBox *exitDialog;
+    QProgressDialog *syncCopyDialog;
     QMessageBox *sslKeyPinningError;
     NodeSelector *downloadNodeSelector;
     QString lastTrayMessage;
@@ -366,9 +389,10 @@ protected:
     QList<QNetworkInterface> activeNetworkInterfaces;
     QMap<QString, QString> pendingLinks;
     MegaSyncLogger *logger;
+    // Trace saved on exit, set with --trace <path>
+    QString traceFilePath;
     QPointer<TransferManager> transferManager;
-    QMap<int, mega::MegaTransfer*> finishedTransfers;
-    QList<mega::MegaTransfer*> finishedTransferOrder;
+    TransferHistory *transferHistory;
 
     QHash<unsigned long long, TransferMetaData*> transferAppData;
 
@@ -386,6 +410,8 @@ protected:
     bool isLinux;
     long long externalNodesTimestamp;
     int noKeyDetected;
+    // Bumped when the storage values are replaced by account details
+    int storageEpoch;
     bool isFirstSyncDone;
     bool isFirstFileSynced;
     bool networkConnectivity;
@@ -408,4 +434,16 @@ protected:
     MegaApplication *app;
 };
 
+class MEGASyncTransferDispatchListener: public mega::MegaTransferListener
+{
+public:
+    MEGASyncTransferDispatchListener(MegaApplication *app);
+    virtual void onTransferStart(mega::MegaApi *api, mega::MegaTransfer *transfer);
+    virtual void onTransferFinish(mega::MegaApi* api, mega::MegaTransfer *transfer, mega::MegaError* e);
+    virtual void onTransferUpdate(mega::MegaApi *api, mega::MegaTransfer *transfer);
+
+protected:
+    MegaApplication *app;
+};
+
 #endif // MEGAAPPLICATION_H
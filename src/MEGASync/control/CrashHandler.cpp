@@ -2,6 +2,7 @@
 #include <QtCore/QDir>
 #include <QtCore/QProcess>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
 #include <QString>
 #include <sstream>
 #include "MegaApplication.h"
@@ -9,6 +10,18 @@
 using namespace mega;
 using namespace std;
 
+// Logger drained before breakpad writes a minidump. The plain signal handler
+// doesn't use it because it would need locks that aren't async-signal-safe
+static MegaSyncLogger *crash_logger = NULL;
+
+static void flushLogs()
+{
+    if (crash_logger)
+    {
+        crash_logger->flushBeforeCrash(1000);
+    }
+}
+
 #if defined(Q_OS_MAC)
 #include "client/mac/handler/exception_handler.h"
 #elif defined(Q_OS_LINUX)
@@ -18,6 +31,9 @@ using namespace std;
 #endif
 
 #ifndef WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+
     #ifndef CREATE_COMPATIBLE_MINIDUMPS
 
     #include <signal.h>
@@ -272,6 +288,59 @@ string getDistroVersion()
     #endif
 #endif
 
+/************************************************************************/
+/* Crash flag                                                           */
+/************************************************************************/
+// Written from the crash handlers, that can't take locks nor wait for the settings writer.
+// The path and the time of the last reboot are set before any crash can happen
+#ifdef WIN32
+static std::wstring crash_flag_path;
+#else
+static std::string crash_flag_path;
+#endif
+static long long last_reboot_time = 0;
+
+static void writeCrashFlag(long long rebootTime)
+{
+    if (crash_flag_path.empty())
+    {
+        return;
+    }
+
+    char digits[24];
+    int size = 0;
+    do
+    {
+        digits[sizeof(digits) - 1 - size++] = char('0' + rebootTime % 10);
+        rebootTime /= 10;
+    } while (rebootTime > 0 && size < 20);
+    const char *data = digits + sizeof(digits) - size;
+
+#ifdef WIN32
+    HANDLE file = CreateFileW(crash_flag_path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    DWORD written = 0;
+    WriteFile(file, data, size, &written, NULL);
+    FlushFileBuffers(file);
+    CloseHandle(file);
+#else
+    int file = open(crash_flag_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (file < 0)
+    {
+        return;
+    }
+
+    write(file, data, size);
+    fsync(file);
+    close(file);
+#endif
+}
+
 /************************************************************************/
 /* CrashHandlerPrivate                                                  */
 /************************************************************************/
@@ -296,6 +365,26 @@ public:
 google_breakpad::ExceptionHandler* CrashHandlerPrivate::pHandler = NULL;
 bool CrashHandlerPrivate::bReportCrashesToSystem = true;
 
+/************************************************************************/
+/* FilterCallback                                                       */
+/************************************************************************/
+// Called before the minidump is written
+#if defined(Q_OS_WIN32)
+bool FilterCallback(void* context, EXCEPTION_POINTERS* exinfo, MDRawAssertionInfo* assertion)
+#else
+bool FilterCallback(void* context)
+#endif
+{
+    Q_UNUSED(context);
+#if defined(Q_OS_WIN32)
+    Q_UNUSED(exinfo);
+    Q_UNUSED(assertion);
+#endif
+
+    flushLogs();
+    return true;
+}
+
 /************************************************************************/
 /* DumpCallback                                                         */
 /************************************************************************/
@@ -328,7 +417,7 @@ void CrashHandlerPrivate::InitCrashHandler(const QString& dumpPath)
     std::wstring pathAsStr = (const wchar_t*)dumpPath.utf16();
     pHandler = new google_breakpad::ExceptionHandler(
         pathAsStr,
-        /*FilterCallback*/ NULL,
+        FilterCallback,
         DumpCallback,
         /*context*/
         NULL,
@@ -341,7 +430,7 @@ void CrashHandlerPrivate::InitCrashHandler(const QString& dumpPath)
             google_breakpad::MinidumpDescriptor md(pathAsStr);
             pHandler = new google_breakpad::ExceptionHandler(
                 md,
-                /*FilterCallback*/ 0,
+                FilterCallback,
                 DumpCallback,
                 /*context*/ 0,
                 true,
@@ -351,7 +440,7 @@ void CrashHandlerPrivate::InitCrashHandler(const QString& dumpPath)
             std::string pathAsStr = dumpPath.toUtf8().constData();
             pHandler = new google_breakpad::ExceptionHandler(
                 pathAsStr,
-                /*FilterCallback*/ 0,
+                FilterCallback,
                 DumpCallback,
                 /*context*/
                 0,
@@ -397,13 +486,11 @@ CrashHandler* CrashHandler::instance()
 
 void CrashHandler::tryReboot()
 {
-    Preferences *preferences = Preferences::instance();
-    preferences->setCrashed(true);
-
-    if ((QDateTime::currentMSecsSinceEpoch()-preferences->getLastReboot()) > Preferences::MIN_REBOOT_INTERVAL_MS)
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    if ((now - last_reboot_time) > Preferences::MIN_REBOOT_INTERVAL_MS)
     {
         MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Restarting app...");
-        preferences->setLastReboot(QDateTime::currentMSecsSinceEpoch());
+        writeCrashFlag(now);
 
 #ifndef __APPLE__
         QString app = MegaApplication::applicationFilePath();
@@ -430,6 +517,7 @@ void CrashHandler::tryReboot()
     }
     else
     {
+        writeCrashFlag(0);
         MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "The app was recently restarted. Restart skipped");
     }
 }
@@ -617,9 +705,44 @@ void CrashHandler::deletePendingCrashReports()
 void CrashHandler::Init( const QString& reportPath )
 {
     this->dumpPath = reportPath;
+    QString flagPath = QDir(reportPath).filePath(QString::fromAscii("crashed.flag"));
+#ifdef WIN32
+    crash_flag_path = (const wchar_t*)QDir::toNativeSeparators(flagPath).utf16();
+#else
+    crash_flag_path = flagPath.toUtf8().constData();
+#endif
     d->InitCrashHandler(reportPath);
 }
 
+bool CrashHandler::takeCrashFlag(long long *rebootTime)
+{
+    if (dumpPath.isEmpty())
+    {
+        return false;
+    }
+
+    QFile file(QDir(dumpPath).filePath(QString::fromAscii("crashed.flag")));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    *rebootTime = file.readAll().trimmed().toLongLong();
+    file.close();
+    file.remove();
+    return true;
+}
+
+void CrashHandler::setLogger(MegaSyncLogger *logger)
+{
+    crash_logger = logger;
+}
+
+void CrashHandler::setLastReboot(long long value)
+{
+    last_reboot_time = value;
+}
+
 void CrashHandler::Disable()
 {
     delete d;
@@ -11,6 +11,7 @@
 #include "control/Utilities.h"
 
 class CrashHandlerPrivate;
+class MegaSyncLogger;
 class CrashHandler: public QObject
 {
     Q_OBJECT
@@ -18,7 +19,12 @@ class CrashHandler: public QObject
 public:
     static CrashHandler* instance();
     static void tryReboot();
+    // Its queued lines are written before the crash dumps
+    static void setLogger(MegaSyncLogger *logger);
     void Init(const QString&  reportPath);
+    // Returns true if the previous execution crashed. rebootTime is zero if it wasn't restarted
+    bool takeCrashFlag(long long *rebootTime);
+    void setLastReboot(long long value);
     void Disable();
     void setReportCrashesToSystem(bool report);
     bool writeMinidump();
@@ -1,83 +1,619 @@
 #include "EncryptedSettings.h"
 #include "platform/Platform.h"
+#include "Tracer.h"
+#include <QDateTime>
+#include <QFile>
 
-EncryptedSettings::EncryptedSettings(QString file) :
-    QSettings(file, QSettings::IniFormat)
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+const int EncryptedSettings::SYNC_DELAY_MS = 1000;
+const int EncryptedSettings::MAX_SYNC_DELAY_MS = 5000;
+
+class EncryptedSettings::FlushTask : public QRunnable
 {
-    QByteArray fixedSeed("$JY/X?o=h·&%v/M(");
-    QByteArray localKey = Platform::getLocalStorageKey();
-    QByteArray xLocalKey = XOR(fixedSeed, localKey);
-    QByteArray hLocalKey = QCryptographicHash::hash(xLocalKey, QCryptographicHash::Sha1);
-    encryptionKey = hLocalKey;
+public:
+    FlushTask(EncryptedSettings *settings) : settings(settings) {}
+
+    virtual void run()
+    {
+        settings->flush(true);
+    }
+
+private:
+    EncryptedSettings *settings;
+};
+
+EncryptedSettings::EncryptedSettings(QString file)
+{
+    encryptionKey = getLocalEncryptionKey();
+
+    // The file is only read here, it's written by writeFile()
+    fileName = file;
+    QSettings reader(file, QSettings::IniFormat);
+    QStringList keys = reader.allKeys();
+    for (int i = 0; i < keys.size(); i++)
+    {
+        storedValues.insert(keys.at(i), reader.value(keys.at(i)).toString());
+    }
+    storedValuesChanged = false;
+
+    transactionDepth = 0;
+    syncPending = false;
+    flushScheduled = false;
+    syncNow = false;
+    firstSyncTime = 0;
+    lastSyncTime = 0;
+    writerPool.setMaxThreadCount(1);
+    publish();
+}
+
+EncryptedSettings::~EncryptedSettings()
+{
+    waitForSync();
 }
 
 void EncryptedSettings::setValue(const QString &key, const QVariant &value)
 {
-    QSettings::setValue(hash(key), encrypt(key, value.toString()));
+    TRACE_SPAN("EncryptedSettings::setValue");
+    QMutexLocker locker(&mutex);
+    CacheKey cacheKey(currentGroup, key);
+    cache.insert(cacheKey, value);
+    dirtyKeys.insert(cacheKey);
+    publishPending.fetchAndStoreOrdered(1);
+    scheduleFlush();
 }
 
 QVariant EncryptedSettings::value(const QString &key, const QVariant &defaultValue)
 {
-    return QVariant(decrypt(key, QSettings::value(hash(key), encrypt(key, defaultValue.toString())).toString()));
+    TRACE_SPAN("EncryptedSettings::value");
+    QMutexLocker locker(&mutex);
+    return cachedValue(currentGroup, key, defaultValue);
+}
+
+QVariant EncryptedSettings::snapshotValue(const QString &key, const QVariant &defaultValue)
+{
+    TRACE_SPAN("EncryptedSettings::snapshotValue");
+    const Snapshot *current = currentSnapshot();
+    QHash<CacheKey, QVariant>::const_iterator it = current->values.constFind(CacheKey(current->group, key));
+    if (it == current->values.constEnd())
+    {
+        QMutexLocker locker(&mutex);
+        return cachedValue(current->group, key, defaultValue);
+    }
+
+    if (!it.value().isValid())
+    {
+        return QVariant(defaultValue.toString());
+    }
+    return it.value();
+}
+
+QVariantList EncryptedSettings::snapshotValues(const QStringList &keys)
+{
+    TRACE_SPAN("EncryptedSettings::snapshotValues");
+    const Snapshot *current = currentSnapshot();
+    QVariantList values;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        QHash<CacheKey, QVariant>::const_iterator it = current->values.constFind(CacheKey(current->group, keys.at(i)));
+        if (it == current->values.constEnd())
+        {
+            break;
+        }
+        values.append(it.value().isValid() ? it.value() : QVariant(QString()));
+    }
+
+    if (values.size() == keys.size())
+    {
+        return values;
+    }
+
+    // All of them are read again from the cache, so they stay consistent
+    QMutexLocker locker(&mutex);
+    values.clear();
+    for (int i = 0; i < keys.size(); i++)
+    {
+        values.append(cachedValue(current->group, keys.at(i), QVariant()));
+    }
+    return values;
+}
+
+bool EncryptedSettings::isPublishedGroupEmpty()
+{
+    return currentSnapshot()->group.isEmpty();
+}
+
+void EncryptedSettings::publishGroup()
+{
+    QMutexLocker locker(&mutex);
+    publishedGroup = currentGroup;
+    publish();
+}
+
+void EncryptedSettings::preload(const QStringList &keys)
+{
+    QMutexLocker locker(&mutex);
+    for (int i = 0; i < keys.size(); i++)
+    {
+        cachedValue(publishedGroup, keys.at(i), QVariant());
+    }
+    publish();
+}
+
+QVariant EncryptedSettings::cachedValue(const QString &group, const QString &key, const QVariant &defaultValue)
+{
+    CacheKey cacheKey(group, key);
+    QHash<CacheKey, QVariant>::const_iterator it = cache.constFind(cacheKey);
+    if (it == cache.constEnd())
+    {
+        QString storedKey = fullKey(group, hash(key, group));
+        QVariant storedValue;
+        QMap<QString, QString>::const_iterator stored = storedValues.constFind(storedKey);
+        if (stored != storedValues.constEnd())
+        {
+            storedValue = QVariant(decrypt(key, group, stored.value()));
+        }
+        it = cache.insert(cacheKey, storedValue);
+        publishPending.fetchAndStoreOrdered(1);
+    }
+
+    if (!it.value().isValid())
+    {
+        return QVariant(defaultValue.toString());
+    }
+    return it.value();
+}
+
+const EncryptedSettings::Snapshot *EncryptedSettings::currentSnapshot()
+{
+    // Changes since the last snapshot are published by the first reader
+#if QT_VERSION >= 0x050000
+    bool pending = publishPending.loadAcquire();
+#else
+    bool pending = publishPending;
+#endif
+    if (pending)
+    {
+        QMutexLocker locker(&mutex);
+        if (publishPending.fetchAndAddOrdered(0))
+        {
+            publish();
+        }
+    }
+
+    LocalSnapshot *local = localSnapshots.localData();
+    if (!local)
+    {
+        local = new LocalSnapshot();
+        local->version = -1;
+        localSnapshots.setLocalData(local);
+    }
+
+#if QT_VERSION >= 0x050000
+    int version = snapshotVersion.loadAcquire();
+#else
+    int version = snapshotVersion;
+#endif
+    if (local->version != version)
+    {
+        snapshotMutex.lock();
+        local->snapshot = snapshot;
+#if QT_VERSION >= 0x050000
+        local->version = snapshotVersion.load();
+#else
+        local->version = snapshotVersion;
+#endif
+        snapshotMutex.unlock();
+    }
+    return local->snapshot.data();
+}
+
+void EncryptedSettings::publish()
+{
+    // The values are shared with the cache until the next change
+    Snapshot *next = new Snapshot();
+    next->group = publishedGroup;
+    next->values = cache;
+    QSharedPointer<const Snapshot> pointer(next);
+    publishPending.fetchAndStoreOrdered(0);
+
+    snapshotMutex.lock();
+    snapshot = pointer;
+    snapshotVersion.ref();
+    snapshotMutex.unlock();
 }
 
 void EncryptedSettings::beginGroup(const QString &prefix)
 {
-    QSettings::beginGroup(hash(prefix));
+    QMutexLocker locker(&mutex);
+    groups.append(hash(prefix, currentGroup));
+    currentGroup = groups.join(QString::fromAscii("/"));
 }
 
 void EncryptedSettings::beginGroup(int numGroup)
 {
-     QSettings::beginGroup(QSettings::childGroups().at(numGroup));
+    QMutexLocker locker(&mutex);
+    groups.append(childGroups(currentGroup).at(numGroup));
+    currentGroup = groups.join(QString::fromAscii("/"));
 }
 
 void EncryptedSettings::endGroup()
 {
-    QSettings::endGroup();
+    QMutexLocker locker(&mutex);
+    if (groups.size())
+    {
+        groups.removeLast();
+        currentGroup = groups.join(QString::fromAscii("/"));
+    }
 }
 
 int EncryptedSettings::numChildGroups()
 {
-    return QSettings::childGroups().size();
+    QMutexLocker locker(&mutex);
+    return childGroups(currentGroup).size();
 }
 
 bool EncryptedSettings::containsGroup(QString groupName)
 {
-    return QSettings::childGroups().contains(hash(groupName));
+    QMutexLocker locker(&mutex);
+    return childGroups(currentGroup).contains(hash(groupName, currentGroup));
 }
 
 bool EncryptedSettings::isGroupEmpty()
 {
-    return QSettings::group().isEmpty();
+    QMutexLocker locker(&mutex);
+    return currentGroup.isEmpty();
 }
 
 void EncryptedSettings::remove(const QString &key)
 {
-    if (!key.length())
+    QMutexLocker locker(&mutex);
+    QString path = currentGroup;
+    if (key.length())
     {
-        QSettings::remove(QString::fromAscii(""));
+        path = fullKey(currentGroup, hash(key, currentGroup));
     }
-    else
+
+    // The key itself and everything below it
+    if (storedValues.remove(path))
     {
-        QSettings::remove(hash(key));
+        storedValuesChanged = true;
     }
+
+    QString prefix = path.isEmpty() ? path : path + QString::fromAscii("/");
+    QMap<QString, QString>::iterator it = storedValues.lowerBound(prefix);
+    while (it != storedValues.end() && it.key().startsWith(prefix))
+    {
+        it = storedValues.erase(it);
+        storedValuesChanged = true;
+    }
+    invalidate(key, path);
+    publishPending.fetchAndStoreOrdered(1);
+    scheduleFlush();
 }
 
 void EncryptedSettings::clear()
 {
-    QSettings::clear();
+    QMutexLocker locker(&mutex);
+    storedValues.clear();
+    storedValuesChanged = true;
+    cache.clear();
+    dirtyKeys.clear();
+    publishPending.fetchAndStoreOrdered(1);
+    scheduleFlush();
 }
 
 void EncryptedSettings::sync()
 {
-    QSettings::sync();
+    TRACE_SPAN("EncryptedSettings::sync");
+    QMutexLocker locker(&mutex);
+    scheduleFlush();
+}
+
+void EncryptedSettings::scheduleFlush()
+{
+    if (transactionDepth)
+    {
+        syncPending = true;
+        return;
+    }
+
+    lastSyncTime = QDateTime::currentMSecsSinceEpoch();
+    if (!flushScheduled)
+    {
+        flushScheduled = true;
+        firstSyncTime = lastSyncTime;
+        writerPool.start(new FlushTask(this));
+    }
+}
+
+void EncryptedSettings::waitForSync()
+{
+    mutex.lock();
+    syncNow = true;
+    syncCondition.wakeAll();
+    mutex.unlock();
 
-    QFile::remove(this->fileName().append(QString::fromUtf8(".bak")));
-    QFile::copy(this->fileName(),this->fileName().append(QString::fromUtf8(".bak")));
+    writerPool.waitForDone();
+    flush(false);
+
+    mutex.lock();
+    syncNow = false;
+    mutex.unlock();
+}
+
+void EncryptedSettings::beginTransaction()
+{
+    QMutexLocker locker(&mutex);
+    transactionDepth++;
+}
+
+void EncryptedSettings::commitTransaction()
+{
+    mutex.lock();
+    bool committed = transactionDepth && !--transactionDepth;
+    bool pending = committed && syncPending;
+    if (pending)
+    {
+        syncPending = false;
+    }
+    if (committed && publishPending.fetchAndAddOrdered(0))
+    {
+        publish();
+    }
+    mutex.unlock();
+
+    if (pending)
+    {
+        sync();
+    }
+}
+
+void EncryptedSettings::flush(bool delayed)
+{
+    QList<QPair<CacheKey, QVariant> > writes;
+    mutex.lock();
+    if (delayed)
+    {
+        // Wait until syncs stop coming for a while, but not forever
+        long long now = QDateTime::currentMSecsSinceEpoch();
+        long long deadline = qMin(lastSyncTime + SYNC_DELAY_MS, firstSyncTime + MAX_SYNC_DELAY_MS);
+        while (!syncNow && now < deadline)
+        {
+            syncCondition.wait(&mutex, deadline - now);
+            now = QDateTime::currentMSecsSinceEpoch();
+            deadline = qMin(lastSyncTime + SYNC_DELAY_MS, firstSyncTime + MAX_SYNC_DELAY_MS);
+        }
+    }
+
+    flushScheduled = false;
+    for (QSet<CacheKey>::const_iterator it = dirtyKeys.constBegin(); it != dirtyKeys.constEnd(); ++it)
+    {
+        writes.append(qMakePair(*it, cache.value(*it)));
+    }
+    dirtyKeys.clear();
+    mutex.unlock();
+
+    // Encryption doesn't need the lock, so readers can go on meanwhile
+    QStringList keys;
+    QStringList values;
+    for (int i = 0; i < writes.size(); i++)
+    {
+        const CacheKey &cacheKey = writes.at(i).first;
+        keys.append(fullKey(cacheKey.first, hash(cacheKey.second, cacheKey.first)));
+        values.append(encrypt(cacheKey.second, cacheKey.first, writes.at(i).second.toString()));
+    }
+
+    mutex.lock();
+    for (int i = 0; i < writes.size(); i++)
+    {
+        // Keys removed or changed since then are skipped. Changed ones are dirty again
+        QHash<CacheKey, QVariant>::const_iterator it = cache.constFind(writes.at(i).first);
+        if (it != cache.constEnd() && it.value() == writes.at(i).second)
+        {
+            storedValues.insert(keys.at(i), values.at(i));
+            storedValuesChanged = true;
+        }
+    }
+
+    if (!storedValuesChanged)
+    {
+        mutex.unlock();
+        return;
+    }
+
+    QMap<QString, QString> snapshot = storedValues;
+    storedValuesChanged = false;
+    mutex.unlock();
+
+    if (!writeFile(toIni(snapshot)))
+    {
+        QMutexLocker locker(&mutex);
+        storedValuesChanged = true;
+    }
+}
+
+QByteArray EncryptedSettings::toIni(const QMap<QString, QString> &values)
+{
+    // Same layout as QSettings::IniFormat. Keys are hex hashes and values are
+    // base64, so only values with padding need quotes
+    QByteArray general;
+    QByteArray sections;
+    QString currentSection;
+    for (QMap<QString, QString>::const_iterator it = values.constBegin(); it != values.constEnd(); ++it)
+    {
+        QByteArray value = it.value().toUtf8();
+        if (value.contains('=') || value.contains(',') || value.contains(';'))
+        {
+            value = '"' + value + '"';
+        }
+
+        int separator = it.key().indexOf(QChar::fromAscii('/'));
+        if (separator < 0)
+        {
+            general += it.key().toUtf8() + '=' + value + '\n';
+            continue;
+        }
+
+        QString section = it.key().left(separator);
+        if (section != currentSection)
+        {
+            currentSection = section;
+            sections += '\n' + ('[' + section.toUtf8() + ']') + '\n';
+        }
+
+        QString key = it.key().mid(separator + 1);
+        key.replace(QChar::fromAscii('/'), QChar::fromAscii('\\'));
+        sections += key.toUtf8() + '=' + value + '\n';
+    }
+
+    if (general.isEmpty())
+    {
+        return sections.mid(1);
+    }
+    return QByteArray("[General]\n") + general + sections;
+}
+
+bool EncryptedSettings::writeFile(const QByteArray &data)
+{
+    QString tempFileName = fileName + QString::fromAscii(".tmp");
+    QFile file(tempFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    bool success = file.write(data) == data.size() && file.flush();
+    if (success)
+    {
+#ifdef WIN32
+        success = FlushFileBuffers((HANDLE)_get_osfhandle(file.handle()));
+#else
+        success = !fsync(file.handle());
+#endif
+    }
+    file.close();
+
+    if (success)
+    {
+#ifdef WIN32
+        success = MoveFileExW((LPCWSTR)tempFileName.utf16(), (LPCWSTR)fileName.utf16(),
+                              MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        success = !rename(QFile::encodeName(tempFileName).constData(), QFile::encodeName(fileName).constData());
+#endif
+    }
+
+    if (!success)
+    {
+        QFile::remove(tempFileName);
+    }
+    return success;
+}
+
+QString EncryptedSettings::fullKey(const QString &group, const QString &hashedKey)
+{
+    if (group.isEmpty())
+    {
+        return hashedKey;
+    }
+    return group + QString::fromAscii("/") + hashedKey;
+}
+
+bool EncryptedSettings::isInPath(const QString &group, const QString &path)
+{
+    return path.isEmpty() || group == path
+            || (group.startsWith(path) && group.at(path.size()) == QChar::fromAscii('/'));
+}
+
+QStringList EncryptedSettings::childGroups(const QString &group)
+{
+    QString prefix = group.isEmpty() ? group : group + QString::fromAscii("/");
+    QStringList result;
+    for (QMap<QString, QString>::const_iterator it = storedValues.lowerBound(prefix);
+         it != storedValues.constEnd() && it.key().startsWith(prefix); ++it)
+    {
+        int separator = it.key().indexOf(QChar::fromAscii('/'), prefix.size());
+        if (separator >= 0)
+        {
+            QString child = it.key().mid(prefix.size(), separator - prefix.size());
+            if (result.isEmpty() || result.last() != child)
+            {
+                result.append(child);
+            }
+        }
+    }
+
+    // Groups written since the last flush are only in the cache
+    bool merged = false;
+    for (QHash<CacheKey, QVariant>::const_iterator it = cache.constBegin(); it != cache.constEnd(); ++it)
+    {
+        const QString &keyGroup = it.key().first;
+        if (!it.value().isValid() || keyGroup.size() <= prefix.size() || !keyGroup.startsWith(prefix))
+        {
+            continue;
+        }
+
+        int separator = keyGroup.indexOf(QChar::fromAscii('/'), prefix.size());
+        QString child = keyGroup.mid(prefix.size(), separator < 0 ? -1 : separator - prefix.size());
+        if (!result.contains(child))
+        {
+            result.append(child);
+            merged = true;
+        }
+    }
+
+    if (merged)
+    {
+        // beginGroup(int) relies on the same order as the stored keys
+        result.sort();
+    }
+    return result;
+}
+
+void EncryptedSettings::invalidate(const QString &key, const QString &path)
+{
+    for (QHash<CacheKey, QVariant>::iterator it = cache.begin(); it != cache.end(); )
+    {
+        if ((it.key().first == currentGroup && it.key().second == key) || isInPath(it.key().first, path))
+        {
+            it = cache.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (QSet<CacheKey>::iterator it = dirtyKeys.begin(); it != dirtyKeys.end(); )
+    {
+        if ((it->first == currentGroup && it->second == key) || isInPath(it->first, path))
+        {
+            it = dirtyKeys.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+QByteArray EncryptedSettings::getLocalEncryptionKey()
+{
+    QByteArray fixedSeed("$JY/X?o=h·&%v/M(");
+    QByteArray localKey = Platform::getLocalStorageKey();
+    QByteArray xLocalKey = XOR(fixedSeed, localKey);
+    return QCryptographicHash::hash(xLocalKey, QCryptographicHash::Sha1);
 }
 
 //Simplified XOR fun
-QByteArray EncryptedSettings::XOR(const QByteArray& key, const QByteArray& data) const
+QByteArray EncryptedSettings::XOR(const QByteArray& key, const QByteArray& data)
 {
     int keyLen = key.length();
     if (!keyLen)
@@ -99,37 +635,37 @@ QByteArray EncryptedSettings::XOR(const QByteArray& key, const QByteArray& data)
     return result;
 }
 
-QString EncryptedSettings::encrypt(const QString key, const QString value) const
+QString EncryptedSettings::encrypt(const QString key, const QString group, const QString value) const
 {
     if (value.isEmpty())
     {
         return value;
     }
 
-    QByteArray k = hash(key).toAscii();
+    QByteArray k = hash(key, group).toAscii();
     QByteArray xValue = XOR(k, value.toUtf8());
-    QByteArray xKey = XOR(k, group().toAscii());
+    QByteArray xKey = XOR(k, group.toAscii());
     QByteArray xEncrypted = XOR(k, Platform::encrypt(xValue, xKey));
     return QString::fromAscii(xEncrypted.toBase64());
 }
 
-QString EncryptedSettings::decrypt(const QString key, const QString value) const
+QString EncryptedSettings::decrypt(const QString key, const QString group, const QString value) const
 {
     if (value.isEmpty())
     {
         return value;
     }
 
-    QByteArray k = hash(key).toAscii();
+    QByteArray k = hash(key, group).toAscii();
     QByteArray xValue = XOR(k, QByteArray::fromBase64(value.toAscii()));
-    QByteArray xKey = XOR(k, group().toAscii());
+    QByteArray xKey = XOR(k, group.toAscii());
     QByteArray xDecrypted = XOR(k, Platform::decrypt(xValue, xKey));
     return QString::fromUtf8(xDecrypted);
 }
 
-QString EncryptedSettings::hash(const QString key) const
+QString EncryptedSettings::hash(const QString key, const QString group) const
 {
-    QByteArray xPath = XOR(encryptionKey, (key+group()).toUtf8());
+    QByteArray xPath = XOR(encryptionKey, (key+group).toUtf8());
     QByteArray keyHash = QCryptographicHash::hash(xPath, QCryptographicHash::Sha1);
     QByteArray xKeyHash = XOR(key.toUtf8(), keyHash);
     return QString::fromAscii(xKeyHash.toHex());
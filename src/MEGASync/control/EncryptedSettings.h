@@ -5,13 +5,30 @@
 #include <QVariant>
 #include <QStringList>
 #include <QCryptographicHash>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QPair>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QSharedPointer>
+#include <QAtomicInt>
 
-class EncryptedSettings : protected QSettings
+// Values are kept decrypted in memory once read or written. Every write is
+// encrypted and saved to disk in the background, as sync() does.
+// Syncs are coalesced for a short while, and the file is replaced atomically
+// (temporary file, fsync, rename), so it is never left half written.
+// The cache is also published as immutable snapshots, so snapshotValue()
+// can be used from any thread without waiting for writers. Writes only mark
+// the snapshot as outdated: it's published again once per batch of writes,
+// by the next snapshot read or at the end of a transaction.
+class EncryptedSettings
 {
-    Q_OBJECT
-
 public:
     explicit EncryptedSettings(QString file);
+    virtual ~EncryptedSettings();
 
     void setValue(const QString & key, const QVariant & value);
     QVariant value(const QString & key, const QVariant & defaultValue = QVariant());
@@ -24,13 +41,100 @@ public:
     void remove(const QString & key);
     void clear();
     void sync();
+    // Blocks until all the values written so far are on disk
+    void waitForSync();
+
+    // Lock-free read in the published group. Only the first read of a key that
+    // wasn't preloaded, and the first read after writes, take the lock
+    QVariant snapshotValue(const QString & key, const QVariant & defaultValue = QVariant());
+    // Reads all the keys from the same snapshot
+    QVariantList snapshotValues(const QStringList &keys);
+    bool isPublishedGroupEmpty();
+    // Makes the current group the one seen by snapshot readers, so that writers
+    // can move to other groups for a while without affecting them
+    void publishGroup();
+    // Decrypts these keys of the published group into the cache at once,
+    // so that their first snapshot reads don't take the lock
+    void preload(const QStringList &keys);
+
+    // Syncs requested inside a transaction are done once it is committed
+    void beginTransaction();
+    void commitTransaction();
+
+    // Key derived from the local storage key, also used by other files kept encrypted on disk
+    static QByteArray getLocalEncryptionKey();
+    static QByteArray XOR(const QByteArray &key, const QByteArray& data);
+
+    static const int SYNC_DELAY_MS;
+    static const int MAX_SYNC_DELAY_MS;
 
 protected:
-    QByteArray XOR(const QByteArray &key, const QByteArray& data) const;
-    QString encrypt(const QString key, const QString value) const;
-    QString decrypt(const QString key, const QString value) const;
-    QString hash(const QString key) const;
+    class FlushTask;
+
+    // Plain key inside the (hashed) path of its group
+    typedef QPair<QString, QString> CacheKey;
+
+    struct Snapshot
+    {
+        QString group;
+        QHash<CacheKey, QVariant> values;
+    };
+
+    // Each thread keeps the last snapshot it loaded, and only takes
+    // the snapshot lock to load a newer one
+    struct LocalSnapshot
+    {
+        int version;
+        QSharedPointer<const Snapshot> snapshot;
+    };
+
+    QString encrypt(const QString key, const QString group, const QString value) const;
+    QString decrypt(const QString key, const QString group, const QString value) const;
+    QString hash(const QString key, const QString group) const;
+    static QString fullKey(const QString &group, const QString &hashedKey);
+    static bool isInPath(const QString &group, const QString &path);
+    QVariant cachedValue(const QString &group, const QString &key, const QVariant &defaultValue);
+    const Snapshot *currentSnapshot();
+    void publish();
+    // Called with the mutex locked
+    void scheduleFlush();
+    QStringList childGroups(const QString &group);
+    void invalidate(const QString &key, const QString &path);
+    void flush(bool delayed);
+    static QByteArray toIni(const QMap<QString, QString> &values);
+    bool writeFile(const QByteArray &data);
+
+    QString fileName;
     QByteArray encryptionKey;
+
+    QStringList groups;
+    QString currentGroup;
+
+    // Encrypted values as stored on disk, by full hashed key
+    QMap<QString, QString> storedValues;
+    bool storedValuesChanged;
+
+    // Invalid values mean that the key isn't stored
+    QHash<CacheKey, QVariant> cache;
+    QSet<CacheKey> dirtyKeys;
+
+    QString publishedGroup;
+    QSharedPointer<const Snapshot> snapshot;
+    QAtomicInt snapshotVersion;
+    QAtomicInt publishPending;
+    QMutex snapshotMutex;
+    QThreadStorage<LocalSnapshot *> localSnapshots;
+
+    int transactionDepth;
+    bool syncPending;
+    bool flushScheduled;
+    bool syncNow;
+    long long firstSyncTime;
+    long long lastSyncTime;
+
+    QMutex mutex;
+    QWaitCondition syncCondition;
+    QThreadPool writerPool;
 };
 
 #endif // ENCRYPTEDSETTINGS_H
@@ -1,6 +1,8 @@
 #include "HTTPServer.h"
 #include "Preferences.h"
 #include "Utilities.h"
+#include "Tracer.h"
+#include "JSONReader.h"
 #include "MegaApplication.h"
 
 #include <iostream>
@@ -9,12 +11,183 @@
 using namespace mega;
 
 const unsigned int HTTPServer::MAX_REQUEST_TIME_SECS = 1800;
+const int HTTPServer::KEEP_ALIVE_TIMEOUT_MS = 30000;
+const int HTTPServer::PROGRESS_FEED_INTERVAL_MS = 500;
+const int HTTPServer::PROGRESS_FEED_TIMEOUT_MS = 25000;
 
 bool ts_comparator(RequestData* i, RequestData *j)
 {
     return i->tsStart < j->tsStart;
 }
 
+struct ForeignNodeData
+{
+    int type;
+    MegaHandle handle;
+    MegaHandle parentHandle;
+    QByteArray name;
+    QByteArray key;
+    long long size;
+    long long mtime;
+};
+
+// Reads {"a":"d","esid"|"en"|"auth":...,"f":[{"t","h","p","n","k","s","ts"}, ...]} in a single pass
+static bool parseDownloadRequest(const QByteArray &body, QByteArray *privateAuth, QByteArray *publicAuth,
+                                 QVector<ForeignNodeData> *nodes)
+{
+    JSONReader reader(body.constData(), body.size());
+    QByteArray auth;
+    const char *key;
+    int keySize;
+    if (!reader.enterObject())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Error parsing webclient request");
+        return false;
+    }
+
+    while (reader.nextKey(&key, &keySize))
+    {
+        if (JSONReader::keyIs(key, keySize, "esid"))
+        {
+            reader.readString(privateAuth);
+        }
+        else if (JSONReader::keyIs(key, keySize, "en"))
+        {
+            reader.readString(publicAuth);
+        }
+        else if (JSONReader::keyIs(key, keySize, "auth"))
+        {
+            reader.readString(&auth);
+        }
+        else if (JSONReader::keyIs(key, keySize, "f") && reader.enterArray())
+        {
+            bool firstNode = true;
+            while (reader.nextElement())
+            {
+                ForeignNodeData data;
+                data.type = -1;
+                data.handle = INVALID_HANDLE;
+                data.parentHandle = INVALID_HANDLE;
+                data.size = 0;
+                data.mtime = 0;
+                QByteArray handle;
+                QByteArray parentHandle;
+                long long type = -1;
+                if (!reader.enterObject())
+                {
+                    break;
+                }
+
+                while (reader.nextKey(&key, &keySize))
+                {
+                    if (JSONReader::keyIs(key, keySize, "t"))
+                    {
+                        reader.readNumber(&type);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "h"))
+                    {
+                        reader.readString(&handle);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "p"))
+                    {
+                        reader.readString(&parentHandle);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "n"))
+                    {
+                        reader.readString(&data.name);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "k"))
+                    {
+                        reader.readString(&data.key);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "s"))
+                    {
+                        reader.readNumber(&data.size);
+                    }
+                    else if (JSONReader::keyIs(key, keySize, "ts"))
+                    {
+                        reader.readNumber(&data.mtime);
+                    }
+                    else
+                    {
+                        reader.skipValue();
+                    }
+                }
+
+                if (reader.hasError())
+                {
+                    break;
+                }
+
+                if (type < 0)
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without type in webclient request");
+                    return false;
+                }
+                data.type = int(type);
+
+                if (handle.isEmpty())
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without handle in webclient request");
+                    return false;
+                }
+                data.handle = MegaApi::base64ToHandle(handle.constData());
+
+                // Names are in URL-safe base64
+                data.name.replace('-', '+');
+                data.name.replace('_', '/');
+                data.name = QByteArray::fromBase64(data.name);
+                data.name.truncate(qstrlen(data.name.constData()));
+                if (data.name.isEmpty())
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without name in webclient request");
+                    return false;
+                }
+
+                // The first node is the root of the download
+                if (!firstNode)
+                {
+                    data.parentHandle = MegaApi::base64ToHandle(parentHandle.constData());
+                }
+                else
+                {
+                    firstNode = false;
+                }
+
+                if (data.type == MegaNode::TYPE_FILE && data.key.size() != 43)
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without key (or an invalid key) in webclient request");
+                    continue;
+                }
+                nodes->append(data);
+            }
+        }
+        else
+        {
+            reader.skipValue();
+        }
+    }
+
+    if (reader.hasError())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Error parsing webclient request");
+        return false;
+    }
+
+    if (privateAuth->isEmpty() && publicAuth->isEmpty())
+    {
+        if (auth.size() == 8)
+        {
+            *publicAuth = auth;
+        }
+        else
+        {
+            *privateAuth = auth;
+        }
+    }
+    return true;
+}
+
 RequestData::RequestData()
 {
     files = -1;
@@ -32,9 +205,12 @@ RequestTransferData::RequestTransferData()
     speed = 0;
     tsStart = QDateTime::currentMSecsSinceEpoch() / 1000;
     tsEnd = -1;
+    sequence = 0;
 }
 
 bool HTTPServer::isFirstWebDownloadDone = false;
+QList<HTTPServer*> HTTPServer::servers;
+long long HTTPServer::progressSequence = 0;
 QMultiMap<QString, RequestData*> HTTPServer::webDataRequests;
 QMap<mega::MegaHandle, RequestTransferData*> HTTPServer::webTransferStateRequests;
 
@@ -43,12 +219,22 @@ HTTPServer::HTTPServer(MegaApi *megaApi, quint16 port, bool sslEnabled)
 {
     this->megaApi = megaApi;
     this->sslEnabled = sslEnabled;
+    sslConfigurationValid = false;
+    if (sslEnabled)
+    {
+        // The server is created again when the certificate is renewed
+        loadSslConfiguration();
+    }
+
+    progressFeedTimer.setSingleShot(true);
+    connect(&progressFeedTimer, SIGNAL(timeout()), this, SLOT(sendProgressFeeds()));
+    servers.append(this);
     listen(QHostAddress::LocalHost, port);
 }
 
 HTTPServer::~HTTPServer()
 {
-
+    servers.removeAll(this);
 }
 
 #if QT_VERSION >= 0x050000
@@ -63,7 +249,6 @@ void HTTPServer::incomingConnection(int socket)
     }
 
     MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Incoming webclient connection");
-    Preferences *preferences = Preferences::instance();
     QTcpSocket* s = NULL;
     QSslSocket *sslSocket = NULL;
 
@@ -84,34 +269,55 @@ void HTTPServer::incomingConnection(int socket)
     connect(s, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(error(QAbstractSocket::SocketError)));
 
     s->setSocketDescriptor(socket);
-    requests.insert(s, new HTTPRequest());
+    HTTPConnection *connection = new HTTPConnection();
+    connection->idleTimer = new QTimer(s);
+    connection->idleTimer->setSingleShot(true);
+    connection->idleTimer->setInterval(KEEP_ALIVE_TIMEOUT_MS);
+    connect(connection->idleTimer, SIGNAL(timeout()), this, SLOT(closeIdleConnection()));
+    connection->idleTimer->start();
+    connections.insert(s, connection);
 
     if (sslSocket)
     {
-        sslSocket->setPeerVerifyMode(QSslSocket::VerifyNone);
-
-        QSslKey key(preferences->getHttpsKey().toUtf8(), QSsl::Rsa, QSsl::Pem, QSsl::PrivateKey);
-        if (key.isNull())
+        if (!sslConfigurationValid)
         {
             s->disconnectFromHost();
             return;
         }
 
+        sslSocket->setSslConfiguration(sslConfiguration);
+        sslSocket->startServerEncryption();
+    }
+}
+
+void HTTPServer::loadSslConfiguration()
+{
+    Preferences *preferences = Preferences::instance();
+    QSslKey key(preferences->getHttpsKey().toUtf8(), QSsl::Rsa, QSsl::Pem, QSsl::PrivateKey);
+    if (key.isNull())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Invalid key for the local SSL certificate");
+        return;
+    }
+
+    QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+    configuration.setPeerVerifyMode(QSslSocket::VerifyNone);
+    configuration.setPrivateKey(key);
 #if QT_VERSION >= 0x050100
-        QList<QSslCertificate> certificates;
-        certificates.append(QSslCertificate(preferences->getHttpsCert().toUtf8(), QSsl::Pem));
-        QStringList intermediates = preferences->getHttpsCertIntermediate().split(QString::fromUtf8(";"), QString::SkipEmptyParts);
-        for (int i = 0; i < intermediates.size(); i++)
-        {
-            certificates.append(QSslCertificate(intermediates.at(i).toUtf8(), QSsl::Pem));
-        }
-        sslSocket->setLocalCertificateChain(certificates);
+    QList<QSslCertificate> certificates;
+    certificates.append(QSslCertificate(preferences->getHttpsCert().toUtf8(), QSsl::Pem));
+    QStringList intermediates = preferences->getHttpsCertIntermediate().split(QString::fromUtf8(";"), QString::SkipEmptyParts);
+    for (int i = 0; i < intermediates.size(); i++)
+    {
+        certificates.append(QSslCertificate(intermediates.at(i).toUtf8(), QSsl::Pem));
+    }
+    configuration.setLocalCertificateChain(certificates);
 #else
-        sslSocket->setLocalCertificate(QSslCertificate(preferences->getHttpsCert().toUtf8(), QSsl::Pem));
+    configuration.setLocalCertificate(QSslCertificate(preferences->getHttpsCert().toUtf8(), QSsl::Pem));
 #endif
-        sslSocket->setPrivateKey(key);
-        sslSocket->startServerEncryption();
-    }
+
+    sslConfiguration = configuration;
+    sslConfigurationValid = true;
 }
 
 void HTTPServer::pause()
@@ -198,151 +404,318 @@ void HTTPServer::onTransferDataUpdate(MegaHandle handle, int state, long long pr
     tData->progress = progress;
     tData->size = size;
     tData->speed = speed;
+    tData->sequence = ++progressSequence;
     if (state == MegaTransfer::STATE_CANCELLED
             || state == MegaTransfer::STATE_COMPLETED
             || state == MegaTransfer::STATE_FAILED)
     {
         tData->tsEnd = QDateTime::currentMSecsSinceEpoch() / 1000;
     }
+
+    // Changes are batched and sent to the waiting progress feed requests
+    for (int i = 0; i < servers.size(); i++)
+    {
+        if (!servers.at(i)->progressFeedTimer.isActive())
+        {
+            servers.at(i)->progressFeedTimer.start(PROGRESS_FEED_INTERVAL_MS);
+        }
+    }
 }
 
 void HTTPServer::readClient()
 {
     MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Processing webclient request via %1").arg(QString::fromUtf8(sslEnabled ? "HTTPS" : "HTTP")).toUtf8().constData());
     QAbstractSocket *socket = (QAbstractSocket*)sender();
-    HTTPRequest *request = requests.value(socket);
-    if (disabled || !request)
+    HTTPConnection *connection = connections.value(socket);
+    if (disabled || !connection)
     {
         MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Webclient request not found");
         discardClient();
         return;
     }
 
-    request->data.append(QString::fromUtf8(socket->readAll().data()));
-    if (request->data.contains(QString::fromUtf8("\r\n\r\n")))
+    connection->buffer.append(socket->readAll());
+    if (!connection->waitingProgress)
     {
-        QStringList tokens = request->data.split(QString::fromUtf8("\r\n\r\n"));
-        QStringList headers = tokens[0].split(QString::fromUtf8("\r\n"));
-        if (!headers.size() || !headers[0].startsWith(QString::fromAscii("POST")))
-        {
-            MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Method not allowed for webclient request");
-            rejectRequest(socket, QString::fromUtf8("405 Method Not Allowed"));
-            return;
-        }
+        connection->idleTimer->start(KEEP_ALIVE_TIMEOUT_MS);
+    }
+    processRequests(socket, connection);
+}
 
-        if (Preferences::HTTPS_ORIGIN_CHECK_ENABLED && !Preferences::HTTPS_ALLOWED_ORIGINS.isEmpty())
+void HTTPServer::processRequests(QAbstractSocket *socket, HTTPConnection *connection)
+{
+    // Requests received while another one is being processed or waiting for progress wait for it
+    while (!connection->busy && !connection->waitingProgress)
+    {
+        if (!connection->bodyStart)
         {
-            bool found = false;
-            for (int i = 0; i < Preferences::HTTPS_ALLOWED_ORIGINS.size(); i++)
-            {                
-                QRegExp check = QRegExp(QString::fromUtf8("Origin: %1").arg(Preferences::HTTPS_ALLOWED_ORIGINS.at(i)),
-                                        Qt::CaseSensitive, QRegExp::Wildcard);
-                for (int j = 0; j < headers.size(); j++)
-                {
-                    if (check.exactMatch(headers[j]))
-                    {
-                       request->origin = headers[j].mid(8);
-                       found = true;
-                       break;
-                    }
-                }
-
-                if (found)
-                {
-                    break;
-                }
+            int headersSize = connection->buffer.indexOf("\r\n\r\n");
+            if (headersSize < 0)
+            {
+                return;
             }
 
-            if (!found)
+            if (!parseHeaders(socket, connection, headersSize))
             {
-                MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Missing or invalid Origin header");
-                rejectRequest(socket);
                 return;
             }
         }
 
-        QString contentLengthId = QString::fromUtf8("Content-length: ");
-        QStringList contentLengthHeader = headers.filter(QRegExp(contentLengthId, Qt::CaseInsensitive));
-        if (!contentLengthHeader.size())
+        HTTPRequest request = connection->request;
+        if (connection->buffer.size() - connection->bodyStart < request.contentLength)
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Missing Content-length header");
-            rejectRequest(socket);
             return;
         }
 
-        bool ok;
-        request->contentLength = contentLengthHeader[0].mid(contentLengthId.size(), contentLengthHeader[0].size() - contentLengthId.size()).toInt(&ok);
-        if (!ok || request->contentLength < tokens[1].size())
+        request.body = connection->buffer.mid(connection->bodyStart, request.contentLength);
+        request.data = QString::fromUtf8(request.body.constData(), request.body.size());
+        connection->buffer.remove(0, connection->bodyStart + request.contentLength);
+        connection->bodyStart = 0;
+        connection->request = HTTPRequest();
+        connection->numRequests++;
+
+        QPointer<QAbstractSocket> safeSocket = socket;
+        QPointer<HTTPServer> safeServer = this;
+        connection->busy = true;
+        processRequest(socket, request);
+        if (!safeServer || !safeSocket || connections.value(socket, NULL) != connection)
+        {
+            return;
+        }
+        connection->busy = false;
+
+        if (!request.keepAlive)
+        {
+            return;
+        }
+
+        if (!connection->waitingProgress)
+        {
+            connection->idleTimer->start(KEEP_ALIVE_TIMEOUT_MS);
+        }
+    }
+}
+
+bool HTTPServer::parseHeaders(QAbstractSocket *socket, HTTPConnection *connection, int headersSize)
+{
+    HTTPRequest *request = &connection->request;
+    QStringList headers = QString::fromUtf8(connection->buffer.constData(), headersSize).split(QString::fromUtf8("\r\n"));
+    if (!headers.size() || !headers[0].startsWith(QString::fromAscii("POST")))
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Method not allowed for webclient request");
+        rejectRequest(socket, QString::fromUtf8("405 Method Not Allowed"));
+        return false;
+    }
+
+    if (Preferences::HTTPS_ORIGIN_CHECK_ENABLED && !Preferences::HTTPS_ALLOWED_ORIGINS.isEmpty())
+    {
+        bool found = false;
+        for (int i = 0; i < Preferences::HTTPS_ALLOWED_ORIGINS.size(); i++)
         {
-            if (!ok)
+            QRegExp check = QRegExp(QString::fromUtf8("Origin: %1").arg(Preferences::HTTPS_ALLOWED_ORIGINS.at(i)),
+                                    Qt::CaseSensitive, QRegExp::Wildcard);
+            for (int j = 0; j < headers.size(); j++)
             {
-                MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to parse Content-length header: %1")
-                             .arg(contentLengthHeader[0]).toUtf8().constData());
+                if (check.exactMatch(headers[j]))
+                {
+                   request->origin = headers[j].mid(8);
+                   found = true;
+                   break;
+                }
             }
-            else
+
+            if (found)
             {
-                MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Invalid Content-length header. Header: %1 - Data: %2")
-                             .arg(request->contentLength).arg(tokens[1].size()).toUtf8().constData());
+                break;
             }
-            rejectRequest(socket);
-            return;
         }
 
-        if (request->contentLength > tokens[1].size())
+        if (!found)
         {
-            return;
+            MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Missing or invalid Origin header");
+            rejectRequest(socket);
+            return false;
         }
+    }
 
-        request->data = tokens[1];
+    QString contentLengthId = QString::fromUtf8("Content-length: ");
+    QStringList contentLengthHeader = headers.filter(QRegExp(contentLengthId, Qt::CaseInsensitive));
+    if (!contentLengthHeader.size())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Missing Content-length header");
+        rejectRequest(socket);
+        return false;
+    }
 
+    bool ok;
+    request->contentLength = contentLengthHeader[0].mid(contentLengthId.size(), contentLengthHeader[0].size() - contentLengthId.size()).toInt(&ok);
+    if (!ok || request->contentLength < 0)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to parse Content-length header: %1")
+                     .arg(contentLengthHeader[0]).toUtf8().constData());
+        rejectRequest(socket);
+        return false;
+    }
 
-        QPointer<QAbstractSocket> safeSocket = socket;
-        QPointer<HTTPServer> safeServer = this;
-        processRequest(socket, *request);
-        if (!safeServer || !safeSocket)
+    // HTTP/1.1 connections are persistent unless the client closes them
+    request->keepAlive = headers[0].endsWith(QString::fromUtf8("HTTP/1.1"));
+    QString connectionId = QString::fromUtf8("Connection:");
+    QStringList connectionHeader = headers.filter(QRegExp(QString::fromUtf8("^") + connectionId, Qt::CaseInsensitive));
+    if (connectionHeader.size())
+    {
+        QString value = connectionHeader[0].mid(connectionId.size()).trimmed();
+        if (!value.compare(QString::fromUtf8("close"), Qt::CaseInsensitive))
         {
-            return;
+            request->keepAlive = false;
         }
-
-        HTTPRequest *req = requests.value(socket, NULL);
-        if (request == req)
+        else if (!value.compare(QString::fromUtf8("keep-alive"), Qt::CaseInsensitive))
         {
-            requests.remove(socket);
-            delete request;
+            request->keepAlive = true;
         }
     }
+
+    connection->bodyStart = headersSize + 4;
+    return true;
 }
+
 void HTTPServer::discardClient()
 {
     QAbstractSocket* socket = (QSslSocket*)sender();
     socket->deleteLater();
+    removeConnection(socket);
+}
+
+void HTTPServer::closeIdleConnection()
+{
+    QTimer *timer = (QTimer *)sender();
+    QAbstractSocket *socket = (QAbstractSocket *)timer->parent();
+    HTTPConnection *connection = connections.value(socket);
+    if (!connection || connection->busy)
+    {
+        return;
+    }
+
+    if (connection->waitingProgress)
+    {
+        // Nothing changed, the client asks again
+        answerProgressFeed(socket, connection);
+        return;
+    }
+
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Closing idle webclient connection");
+    socket->disconnectFromHost();
+    socket->deleteLater();
+    removeConnection(socket);
+}
+
+void HTTPServer::sendProgressFeeds()
+{
+    QList<QAbstractSocket*> waitingSockets;
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    long long nextTime = 0;
+    for (QMap<QAbstractSocket*, HTTPConnection*>::iterator it = connections.begin(); it != connections.end(); it++)
+    {
+        HTTPConnection *connection = it.value();
+        if (!connection->waitingProgress || connection->progressCursor >= progressSequence)
+        {
+            continue;
+        }
+
+        // Connections answered less than an interval ago wait for the next batch
+        long long readyTime = connection->lastProgressTime + PROGRESS_FEED_INTERVAL_MS;
+        if (readyTime <= now)
+        {
+            waitingSockets.append(it.key());
+        }
+        else if (!nextTime || readyTime < nextTime)
+        {
+            nextTime = readyTime;
+        }
+    }
+
+    if (nextTime)
+    {
+        progressFeedTimer.start(int(nextTime - now));
+    }
+
+    QPointer<HTTPServer> safeServer = this;
+    for (int i = 0; i < waitingSockets.size() && safeServer; i++)
+    {
+        // Answering a request can process the next ones of the same connection
+        HTTPConnection *connection = connections.value(waitingSockets.at(i));
+        if (connection && connection->waitingProgress)
+        {
+            answerProgressFeed(waitingSockets.at(i), connection);
+        }
+    }
+}
+
+void HTTPServer::answerProgressFeed(QAbstractSocket *socket, HTTPConnection *connection)
+{
+    HTTPRequest request = connection->progressRequest;
+    connection->waitingProgress = false;
+    connection->lastProgressTime = QDateTime::currentMSecsSinceEpoch();
+    sendResponse(socket, request, progressFeed(connection->progressCursor));
+    if (!request.keepAlive)
+    {
+        return;
+    }
+
+    connection->idleTimer->start(KEEP_ALIVE_TIMEOUT_MS);
+    processRequests(socket, connection);
+}
 
-    HTTPRequest *request = requests.value(socket);
-    if (request)
+QString HTTPServer::progressFeed(long long cursor)
+{
+    QString transfers;
+    for (QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.begin(); it != webTransferStateRequests.end(); it++)
+    {
+        RequestTransferData *tData = it.value();
+        if (cursor && tData->sequence <= cursor)
+        {
+            continue;
+        }
+
+        char *base64Handle = MegaApi::handleToBase64(it.key());
+        transfers.append(transfers.isEmpty() ? QString::fromUtf8("") : QString::fromUtf8(","));
+        transfers.append(QString::fromUtf8("{\"h\":\"%1\",\"s\":%2,\"p\":%3,\"t\":%4,\"v\":%5}")
+                         .arg(QString::fromUtf8(base64Handle))
+                         .arg(tData->state)
+                         .arg(tData->progress)
+                         .arg(tData->size)
+                         .arg(tData->speed));
+        delete [] base64Handle;
+    }
+
+    return QString::fromUtf8("{\"c\":%1,\"t\":[%2]}").arg(progressSequence).arg(transfers);
+}
+
+void HTTPServer::removeConnection(QAbstractSocket *socket)
+{
+    HTTPConnection *connection = connections.value(socket);
+    if (connection)
     {
-        requests.remove(socket);
-        delete request;
+        connection->idleTimer->stop();
+        connections.remove(socket);
+        delete connection;
     }
 }
 
 void HTTPServer::rejectRequest(QAbstractSocket *socket, QString response)
 {
-    socket->write(QString::fromUtf8("HTTP/1.0 %1\r\n"
+    socket->write(QString::fromUtf8("HTTP/1.1 %1\r\n"
+                  "Connection: close\r\n"
+                  "Content-Length: 0\r\n"
                   "\r\n").arg(response).toUtf8());
     socket->flush();
     socket->disconnectFromHost();
     socket->deleteLater();
-
-    HTTPRequest *request = requests.value(socket);
-    if (request)
-    {
-        requests.remove(socket);
-        delete request;
-    }
+    removeConnection(socket);
 }
 
 void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
 {
+    TRACE_SPAN("HTTPServer::processRequest");
     QString response;
     QString openLinkRequestStart(QString::fromUtf8("{\"a\":\"l\","));
     QString externalDownloadRequestStart   = QString::fromUtf8("{\"a\":\"d\",");
@@ -353,6 +726,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
     QString externalOpenTransferManagerStart   = QString::fromUtf8("{\"a\":\"tm\",");
     QString externalUploadSelectionStatusStart = QString::fromUtf8("{\"a\":\"uss\",");
     QString externalTransferQueryProgressStart = QString::fromUtf8("{\"a\":\"t\",");
+    QString externalTransferProgressFeedStart = QString::fromUtf8("{\"a\":\"ts\"");
 
     QPointer<QAbstractSocket> safeSocket = socket;
     QPointer<HTTPServer> safeServer = this;
@@ -421,134 +795,44 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
     else if (request.data.startsWith(externalDownloadRequestStart))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "ExternalDownload command received from the webclient");
-        int start = request.data.indexOf(QString::fromUtf8("\"f\":[")) + 5;
-        if (start > 0)
+        QByteArray privateAuth;
+        QByteArray publicAuth;
+        QVector<ForeignNodeData> nodes;
+        if (parseDownloadRequest(request.body, &privateAuth, &publicAuth, &nodes)
+                && (privateAuth.size() || publicAuth.size()))
         {
-            QString privateAuth = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("esid"));
-            QString publicAuth = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("en"));
-
-            if (privateAuth.isEmpty() && publicAuth.isEmpty())
+            // Nodes are created at once, when the whole request is known to be valid
+            QQueue<MegaNode *> downloadQueue;
+            for (int i = 0; i < nodes.size(); i++)
             {
-                QString auth  = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("auth"));
-                if (auth.length() == 8)
+                const ForeignNodeData &data = nodes.at(i);
+                if (data.type != MegaNode::TYPE_FILE)
                 {
-                    publicAuth = auth;
+                    MegaNode *node = megaApi->createForeignFolderNode(data.handle, data.name.constData(), data.parentHandle,
+                                                                     privateAuth.constData(), publicAuth.constData());
+                    downloadQueue.append(node);
                 }
                 else
                 {
-                    privateAuth = auth;
-                }
-            }
-
-            if (privateAuth.size() || publicAuth.size())
-            {
-                QQueue<MegaNode *> downloadQueue;
-                int end;
-                bool firstnode = true;
-
-                while (request.data[start] == QChar::fromAscii('{'))
-                {
-                    end = request.data.indexOf(QChar::fromAscii('}'), start);
-                    if (end < 0)
-                    {
-                        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Error parsing webclient request");
-                        qDeleteAll(downloadQueue);
-                        downloadQueue.clear();
-                        break;
-                    }
-
-                    end++;
-                    QString file = request.data.mid(start, end - start);
-                    start = end + 1;
-
-                    int type = Utilities::extractJSONNumber(file, QString::fromUtf8("t"));
-                    if (type < 0)
-                    {
-                        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without type in webclient request");
-                        qDeleteAll(downloadQueue);
-                        downloadQueue.clear();
-                        break;
-                    }
-
-                    QString handle = Utilities::extractJSONString(file, QString::fromUtf8("h"));
-                    if (handle.isEmpty())
+                    MegaNode *node = megaApi->createForeignFileNode(data.handle, data.key.constData(),
+                                                                   data.name.constData(), data.size, data.mtime,
+                                                                   data.parentHandle, privateAuth.constData(),
+                                                                   publicAuth.constData());
+                    downloadQueue.append(node);
+                    QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(data.handle);
+                    if (it != webTransferStateRequests.end())
                     {
-                        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without handle in webclient request");
-                        qDeleteAll(downloadQueue);
-                        downloadQueue.clear();
-                        break;
-                    }
-
-                    QString name = Utilities::extractJSONString(file, QString::fromUtf8("n"));
-                    name.replace(QString::fromUtf8("-"), QString::fromUtf8("+"));
-                    name.replace(QString::fromUtf8("_"), QString::fromUtf8("/"));
-                    name = QString::fromUtf8(QByteArray::fromBase64(name.toUtf8().constData()).constData());
-                    if (name.isEmpty())
-                    {
-                        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without name in webclient request");
-                        qDeleteAll(downloadQueue);
-                        downloadQueue.clear();
-                        break;
-                    }
-
-                    MegaHandle h = megaApi->base64ToHandle(handle.toUtf8().constData());
-                    MegaHandle p = INVALID_HANDLE;
-
-                    if (!firstnode)
-                    {
-                        QString parentHandle = Utilities::extractJSONString(file, QString::fromUtf8("p"));
-                        p = megaApi->base64ToHandle(parentHandle.toUtf8().constData());
-                        QApplication::processEvents();
-                        if (!safeServer || !safeSocket)
-                        {
-                            return;
-                        }
-                    }
-                    else
-                    {
-                        firstnode = false;
-                    }
-
-                    if (type != MegaNode::TYPE_FILE)
-                    {
-                        MegaNode *node = megaApi->createForeignFolderNode(h, name.toUtf8().constData(), p,
-                                                                         privateAuth.toUtf8().constData(),
-                                                                         publicAuth.toUtf8().constData());
-                        downloadQueue.append(node);
-                    }
-                    else
-                    {
-                        QString key = Utilities::extractJSONString(file, QString::fromUtf8("k"));
-                        if (key.size() == 43)
-                        {
-                            long long size = Utilities::extractJSONNumber(file, QString::fromUtf8("s"));
-                            long long mtime = Utilities::extractJSONNumber(file, QString::fromUtf8("ts"));
-
-                            MegaNode *node = megaApi->createForeignFileNode(h, key.toUtf8().constData(),
-                                                             name.toUtf8().constData(), size, mtime,
-                                                             p, privateAuth.toUtf8().constData(),
-                                                             publicAuth.toUtf8().constData());
-                            downloadQueue.append(node);
-                            QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(h);
-                            if (it != webTransferStateRequests.end())
-                            {
-                                delete it.value();
-                            }
-                            webTransferStateRequests.insert(h, new RequestTransferData());
-                        }
-                        else
-                        {
-                            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without key (or an invalid key) in webclient request");
-                        }
+                        delete it.value();
                     }
+                    webTransferStateRequests.insert(data.handle, new RequestTransferData());
                 }
+            }
 
-                if (downloadQueue.size())
-                {
-                    emit onExternalDownloadRequested(downloadQueue);
-                    emit onExternalDownloadRequestFinished();
-                    response = QString::number(MegaError::API_OK);
-                }
+            if (downloadQueue.size())
+            {
+                emit onExternalDownloadRequested(downloadQueue);
+                emit onExternalDownloadRequestFinished();
+                response = QString::number(MegaError::API_OK);
             }
         }
     }
@@ -752,6 +1036,42 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             }
         }
     }
+    else if (request.data.startsWith(externalTransferProgressFeedStart))
+    {
+        // Long poll: the answer has the changes of all the webclient transfers after the cursor "c".
+        // Cursors from a previous execution get the whole state
+        long long cursor = Utilities::extractJSONNumber(request.data, QString::fromUtf8("c"));
+        if (cursor > progressSequence)
+        {
+            cursor = 0;
+        }
+
+        // Requests that come back within the interval are held even if there are
+        // changes already, so each connection gets at most one answer per interval
+        HTTPConnection *connection = connections.value(socket);
+        long long now = QDateTime::currentMSecsSinceEpoch();
+        long long readyTime = connection ? connection->lastProgressTime + PROGRESS_FEED_INTERVAL_MS : 0;
+        if (!connection || (cursor < progressSequence && readyTime <= now))
+        {
+            if (connection)
+            {
+                connection->lastProgressTime = now;
+            }
+            response = progressFeed(cursor);
+        }
+        else
+        {
+            connection->waitingProgress = true;
+            connection->progressCursor = cursor;
+            connection->progressRequest = request;
+            connection->idleTimer->start(PROGRESS_FEED_TIMEOUT_MS);
+            if (cursor < progressSequence && !progressFeedTimer.isActive())
+            {
+                progressFeedTimer.start(int(readyTime - now));
+            }
+            return;
+        }
+    }
 
     if (!response.size())
     {
@@ -763,18 +1083,28 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Response to HTTP request: %1").arg(response).toUtf8().constData());
     }
 
-    QString fullResponse = QString::fromUtf8("HTTP/1.0 200 Ok\r\n"
-                                             "Access-Control-Allow-Origin: %1\r\n"
-                                             "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                                             "Content-Length: %2\r\n"
-                                             "\r\n"
-                                             "%3").arg(request.origin).arg(response.size()).arg(response);
     if (safeServer && safeSocket)
     {
-        safeSocket->write(fullResponse.toUtf8());
-        safeSocket->flush();
-        safeSocket->disconnectFromHost();
-        safeSocket->deleteLater();
+        sendResponse(safeSocket, request, response);
+    }
+}
+
+void HTTPServer::sendResponse(QAbstractSocket *socket, const HTTPRequest &request, const QString &response)
+{
+    QByteArray body = response.toUtf8();
+    QString headers = QString::fromUtf8("HTTP/1.1 200 Ok\r\n"
+                                        "Access-Control-Allow-Origin: %1\r\n"
+                                        "Content-Type: text/html; charset=\"utf-8\"\r\n"
+                                        "Content-Length: %2\r\n"
+                                        "Connection: %3\r\n"
+                                        "\r\n").arg(request.origin).arg(body.size())
+                                        .arg(QString::fromUtf8(request.keepAlive ? "keep-alive" : "close"));
+    socket->write(headers.toUtf8() + body);
+    socket->flush();
+    if (!request.keepAlive)
+    {
+        socket->disconnectFromHost();
+        socket->deleteLater();
     }
 }
 
@@ -783,8 +1113,8 @@ void HTTPServer::error(QAbstractSocket::SocketError)
     if (!disabled && sslEnabled)
     {
         QAbstractSocket *socket = (QAbstractSocket*)sender();
-        HTTPRequest *request = requests.value(socket);
-        if (request && !request->data.size())
+        HTTPConnection *connection = connections.value(socket);
+        if (connection && !connection->numRequests && !connection->buffer.size())
         {
             MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Webclient failed to connect using HTTPS");
             emit onConnectionError();
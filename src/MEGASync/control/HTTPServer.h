@@ -4,10 +4,12 @@
 #include <QTcpServer>
 #include <QSslSocket>
 #include <QSslKey>
+#include <QSslConfiguration>
 #include <QFile>
 #include <QStringList>
 #include <QDateTime>
 #include <QQueue>
+#include <QTimer>
 
 #include <megaapi.h>
 
@@ -39,15 +41,42 @@ public:
     long long speed;
     long long tsStart;
     long long tsEnd;
+    // Position in the progress feed of the last change
+    long long sequence;
 };
 
 class HTTPRequest
 {
 public:
-    HTTPRequest() : contentLength(0), origin(QString::fromUtf8("*")) {}
+    HTTPRequest() : contentLength(0), origin(QString::fromUtf8("*")), keepAlive(false) {}
     QString data;
+    // Raw UTF-8 body
+    QByteArray body;
     int contentLength;
     QString origin;
+    bool keepAlive;
+};
+
+// State of a persistent connection. Pipelined requests are parsed
+// from the buffer and answered one at a time, in order
+class HTTPConnection
+{
+public:
+    HTTPConnection() : bodyStart(0), busy(false), numRequests(0), idleTimer(NULL),
+        waitingProgress(false), progressCursor(0), lastProgressTime(0) {}
+    QByteArray buffer;
+    // Request whose headers have been parsed, its body starts at bodyStart
+    HTTPRequest request;
+    int bodyStart;
+    bool busy;
+    int numRequests;
+    QTimer *idleTimer;
+    // Progress feed request waiting for changes after progressCursor
+    bool waitingProgress;
+    long long progressCursor;
+    HTTPRequest progressRequest;
+    // Time of the last progress feed answer, changes are batched per interval
+    long long lastProgressTime;
 };
 
 class HTTPServer: public QTcpServer
@@ -56,6 +85,10 @@ class HTTPServer: public QTcpServer
 
     public:
         static const unsigned int MAX_REQUEST_TIME_SECS;
+        static const int KEEP_ALIVE_TIMEOUT_MS;
+        // Minimum time between answers to the progress feed requests of a connection
+        static const int PROGRESS_FEED_INTERVAL_MS;
+        static const int PROGRESS_FEED_TIMEOUT_MS;
 
         HTTPServer(mega::MegaApi *megaApi, quint16 port, bool sslEnabled);
         ~HTTPServer();
@@ -85,6 +118,8 @@ class HTTPServer: public QTcpServer
     public slots:
         void readClient();
         void discardClient();
+        void closeIdleConnection();
+        void sendProgressFeeds();
         void rejectRequest(QAbstractSocket *socket, QString response = QString::fromUtf8("403 Forbidden"));
         void processRequest(QAbstractSocket *socket, HTTPRequest request);
         void error(QAbstractSocket::SocketError);
@@ -92,10 +127,24 @@ class HTTPServer: public QTcpServer
         void peerVerifyError(const QSslError & error);
 
     private:
+        void loadSslConfiguration();
+        bool parseHeaders(QAbstractSocket *socket, HTTPConnection *connection, int headersSize);
+        void processRequests(QAbstractSocket *socket, HTTPConnection *connection);
+        void sendResponse(QAbstractSocket *socket, const HTTPRequest &request, const QString &response);
+        void answerProgressFeed(QAbstractSocket *socket, HTTPConnection *connection);
+        void removeConnection(QAbstractSocket *socket);
+        static QString progressFeed(long long cursor);
+
         bool disabled;
         bool sslEnabled;
+        // Parsed once and shared by all the connections
+        QSslConfiguration sslConfiguration;
+        bool sslConfigurationValid;
         mega::MegaApi *megaApi;
-        QMap<QAbstractSocket*, HTTPRequest*> requests;
+        QMap<QAbstractSocket*, HTTPConnection*> connections;
+        QTimer progressFeedTimer;
+        static QList<HTTPServer*> servers;
+        static long long progressSequence;
         static bool isFirstWebDownloadDone;
         static QMultiMap<QString, RequestData*> webDataRequests;
         static QMap<mega::MegaHandle, RequestTransferData*> webTransferStateRequests;
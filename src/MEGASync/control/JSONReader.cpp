@@ -0,0 +1,386 @@
+#include "JSONReader.h"
+#include <cstring>
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static void appendUtf8(QByteArray *value, unsigned int codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        value->append((char)codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        value->append((char)(0xC0 | (codePoint >> 6)));
+        value->append((char)(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        value->append((char)(0xE0 | (codePoint >> 12)));
+        value->append((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        value->append((char)(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        value->append((char)(0xF0 | (codePoint >> 18)));
+        value->append((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+        value->append((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        value->append((char)(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+JSONReader::JSONReader(const char *data, int size)
+{
+    position = data;
+    end = data + size;
+    error = false;
+}
+
+bool JSONReader::enterObject()
+{
+    return expect('{');
+}
+
+bool JSONReader::nextKey(const char **key, int *keySize)
+{
+    if (error)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position < end && *position == '}')
+    {
+        position++;
+        return false;
+    }
+
+    if (position < end && *position == ',')
+    {
+        position++;
+        skipWhitespace();
+    }
+
+    if (position >= end || *position != '"')
+    {
+        return fail();
+    }
+
+    const char *start = position + 1;
+    if (!skipString())
+    {
+        return false;
+    }
+
+    *key = start;
+    *keySize = int(position - 1 - start);
+    return expect(':');
+}
+
+bool JSONReader::enterArray()
+{
+    return expect('[');
+}
+
+bool JSONReader::nextElement()
+{
+    if (error)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position < end && *position == ']')
+    {
+        position++;
+        return false;
+    }
+
+    if (position < end && *position == ',')
+    {
+        position++;
+        skipWhitespace();
+    }
+
+    if (position >= end)
+    {
+        return fail();
+    }
+    return true;
+}
+
+bool JSONReader::readString(QByteArray *value)
+{
+    if (!expect('"'))
+    {
+        return false;
+    }
+
+    // Strings without escapes are copied at once
+    const char *start = position;
+    while (position < end && *position != '"' && *position != '\\')
+    {
+        position++;
+    }
+
+    if (position >= end)
+    {
+        return fail();
+    }
+
+    *value = QByteArray(start, int(position - start));
+    while (*position != '"')
+    {
+        if (*position != '\\')
+        {
+            value->append(*position++);
+        }
+        else if (end - position < 2)
+        {
+            return fail();
+        }
+        else
+        {
+            char c = position[1];
+            position += 2;
+            switch (c)
+            {
+                case '"':
+                case '\\':
+                case '/':
+                    value->append(c);
+                    break;
+                case 'b':
+                    value->append('\b');
+                    break;
+                case 'f':
+                    value->append('\f');
+                    break;
+                case 'n':
+                    value->append('\n');
+                    break;
+                case 'r':
+                    value->append('\r');
+                    break;
+                case 't':
+                    value->append('\t');
+                    break;
+                case 'u':
+                {
+                    unsigned int codePoint = 0;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        int digit = position < end ? hexValue(*position++) : -1;
+                        if (digit < 0)
+                        {
+                            return fail();
+                        }
+                        codePoint = (codePoint << 4) | digit;
+                    }
+
+                    // Surrogate pairs are joined, lone surrogates are replaced
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - position >= 6
+                            && position[0] == '\\' && position[1] == 'u')
+                    {
+                        unsigned int low = 0;
+                        int i;
+                        for (i = 2; i < 6 && hexValue(position[i]) >= 0; i++)
+                        {
+                            low = (low << 4) | hexValue(position[i]);
+                        }
+
+                        if (i == 6 && low >= 0xDC00 && low < 0xE000)
+                        {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                            position += 6;
+                        }
+                    }
+
+                    if (codePoint >= 0xD800 && codePoint < 0xE000)
+                    {
+                        codePoint = 0xFFFD;
+                    }
+                    appendUtf8(value, codePoint);
+                    break;
+                }
+                default:
+                    return fail();
+            }
+        }
+
+        if (position >= end)
+        {
+            return fail();
+        }
+    }
+
+    position++;
+    return true;
+}
+
+bool JSONReader::readNumber(long long *value)
+{
+    if (error)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    bool negative = false;
+    if (position < end && *position == '-')
+    {
+        negative = true;
+        position++;
+    }
+
+    if (position >= end || *position < '0' || *position > '9')
+    {
+        return fail();
+    }
+
+    long long number = 0;
+    while (position < end && *position >= '0' && *position <= '9')
+    {
+        number = number * 10 + (*position++ - '0');
+    }
+
+    while (position < end && (*position == '.' || *position == 'e' || *position == 'E'
+                              || *position == '+' || *position == '-'
+                              || (*position >= '0' && *position <= '9')))
+    {
+        position++;
+    }
+
+    *value = negative ? -number : number;
+    return true;
+}
+
+bool JSONReader::skipValue()
+{
+    if (error)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position >= end)
+    {
+        return fail();
+    }
+
+    if (*position == '"')
+    {
+        return skipString();
+    }
+
+    if (*position != '{' && *position != '[')
+    {
+        // Numbers, true, false and null
+        const char *start = position;
+        while (position < end && *position != ',' && *position != '}' && *position != ']'
+               && *position != ' ' && *position != '\t' && *position != '\r' && *position != '\n')
+        {
+            position++;
+        }
+        return position != start || fail();
+    }
+
+    int depth = 0;
+    while (position < end)
+    {
+        char c = *position;
+        if (c == '"')
+        {
+            if (!skipString())
+            {
+                return false;
+            }
+            continue;
+        }
+
+        position++;
+        if (c == '{' || c == '[')
+        {
+            depth++;
+        }
+        else if ((c == '}' || c == ']') && !--depth)
+        {
+            return true;
+        }
+    }
+    return fail();
+}
+
+bool JSONReader::hasError() const
+{
+    return error;
+}
+
+bool JSONReader::keyIs(const char *key, int keySize, const char *name)
+{
+    return int(strlen(name)) == keySize && !memcmp(key, name, keySize);
+}
+
+void JSONReader::skipWhitespace()
+{
+    while (position < end && (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n'))
+    {
+        position++;
+    }
+}
+
+bool JSONReader::expect(char c)
+{
+    if (error)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (position >= end || *position != c)
+    {
+        return fail();
+    }
+
+    position++;
+    return true;
+}
+
+bool JSONReader::skipString()
+{
+    // The position is at the opening quote
+    position++;
+    while (position < end)
+    {
+        if (*position == '\\')
+        {
+            position += 2;
+        }
+        else if (*position++ == '"')
+        {
+            return true;
+        }
+    }
+    return fail();
+}
+
+bool JSONReader::fail()
+{
+    error = true;
+    return false;
+}
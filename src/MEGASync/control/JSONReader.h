@@ -0,0 +1,42 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+
+// Pull reader for JSON in UTF-8. It walks the data once, without building a
+// document: callers enter objects and arrays and read or skip their values.
+// Keys are returned as slices of the data. After an error all the calls fail.
+class JSONReader
+{
+public:
+    JSONReader(const char *data, int size);
+
+    bool enterObject();
+    // Returns false at the end of the object
+    bool nextKey(const char **key, int *keySize);
+    bool enterArray();
+    // Returns false at the end of the array
+    bool nextElement();
+
+    // Strings are unescaped
+    bool readString(QByteArray *value);
+    // Fractions and exponents are ignored
+    bool readNumber(long long *value);
+    bool skipValue();
+
+    bool hasError() const;
+
+    static bool keyIs(const char *key, int keySize, const char *name);
+
+protected:
+    void skipWhitespace();
+    bool expect(char c);
+    bool skipString();
+    bool fail();
+
+    const char *position;
+    const char *end;
+    bool error;
+};
+
+#endif // JSONREADER_H
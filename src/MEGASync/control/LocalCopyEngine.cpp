@@ -0,0 +1,380 @@
+#include "LocalCopyEngine.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QMetaObject>
+#include <QThread>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
+#endif
+
+const int LocalCopyEngine::MAX_WORKERS = 8;
+const int LocalCopyEngine::CHUNK_SIZE = 1048576;
+const int LocalCopyEngine::PROGRESS_INTERVAL_MS = 250;
+
+class LocalCopyEngine::CopyTask : public QRunnable
+{
+public:
+    CopyTask(LocalCopyEngine *engine, const QString &srcPath, const QString &dstPath, bool isFolder)
+        : engine(engine), srcPath(srcPath), dstPath(dstPath), isFolder(isFolder) {}
+
+    virtual void run()
+    {
+        if (!engine->isCancelled())
+        {
+            isFolder ? engine->copyFolder(srcPath, dstPath) : engine->copyFile(srcPath, dstPath);
+        }
+        engine->taskFinished();
+    }
+
+private:
+    LocalCopyEngine *engine;
+    QString srcPath;
+    QString dstPath;
+    bool isFolder;
+};
+
+static bool longerPathFirst(const QPair<QString, long long> &a, const QPair<QString, long long> &b)
+{
+    return a.first.size() > b.first.size();
+}
+
+LocalCopyEngine::LocalCopyEngine(QObject *parent) : QObject(parent)
+{
+    cancelled = false;
+    pendingTasks = 0;
+    copiedBytes = 0;
+    totalBytes = 0;
+    copiedFiles = 0;
+    totalFiles = 0;
+
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), MAX_WORKERS));
+    progressTimer.setInterval(PROGRESS_INTERVAL_MS);
+    connect(&progressTimer, SIGNAL(timeout()), this, SLOT(onProgressTimeout()));
+}
+
+LocalCopyEngine::~LocalCopyEngine()
+{
+    cancel();
+    pool.waitForDone();
+}
+
+void LocalCopyEngine::copy(QString srcPath, QString dstPath)
+{
+    if (!srcPath.size() || !dstPath.size() || srcPath == dstPath)
+    {
+        return;
+    }
+
+    QFileInfo source(srcPath);
+    if (!source.exists() || QFile::exists(dstPath))
+    {
+        return;
+    }
+
+    if (source.isFile())
+    {
+        mutex.lock();
+        totalFiles++;
+        totalBytes += source.size();
+        mutex.unlock();
+        startTask(srcPath, dstPath, false);
+    }
+    else if (source.isDir())
+    {
+        startTask(srcPath, dstPath, true);
+    }
+}
+
+void LocalCopyEngine::cancel()
+{
+    QMutexLocker locker(&mutex);
+    if (pendingTasks)
+    {
+        cancelled = true;
+    }
+}
+
+bool LocalCopyEngine::isCancelled()
+{
+    QMutexLocker locker(&mutex);
+    return cancelled;
+}
+
+void LocalCopyEngine::startTask(const QString &srcPath, const QString &dstPath, bool isFolder)
+{
+    mutex.lock();
+    bool first = !pendingTasks++;
+    mutex.unlock();
+
+    if (first)
+    {
+        QMetaObject::invokeMethod(this, "onCopyStarted", Qt::QueuedConnection);
+    }
+    pool.start(new CopyTask(this, srcPath, dstPath, isFolder));
+}
+
+void LocalCopyEngine::taskFinished()
+{
+    QList<QPair<QString, long long> > folders;
+    mutex.lock();
+    bool last = !--pendingTasks;
+    if (last)
+    {
+        folders.swap(folderTimes);
+    }
+    mutex.unlock();
+
+    if (last)
+    {
+        applyFolderTimes(folders);
+        QMetaObject::invokeMethod(this, "onCopyFinished", Qt::QueuedConnection);
+    }
+}
+
+void LocalCopyEngine::copyFolder(const QString &srcPath, const QString &dstPath)
+{
+    QDir dstDir(dstPath);
+    if (!dstDir.mkpath(QString::fromAscii(".")))
+    {
+        return;
+    }
+
+    mutex.lock();
+    folderTimes.append(qMakePair(dstPath, (long long)QFileInfo(srcPath).lastModified().toTime_t()));
+    mutex.unlock();
+
+    // Subfolders are walked by other workers while the files of this one are queued
+    QDirIterator di(srcPath, QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+    while (di.hasNext() && !isCancelled())
+    {
+        di.next();
+        QFileInfo info = di.fileInfo();
+        QString entryDstPath = dstPath + QDir::separator() + di.fileName();
+        if (info.isSymLink() || QFile::exists(entryDstPath))
+        {
+            continue;
+        }
+
+        if (info.isDir())
+        {
+            startTask(di.filePath(), entryDstPath, true);
+        }
+        else if (info.isFile())
+        {
+            mutex.lock();
+            totalFiles++;
+            totalBytes += info.size();
+            mutex.unlock();
+            startTask(di.filePath(), entryDstPath, false);
+        }
+    }
+}
+
+void LocalCopyEngine::copyFile(const QString &srcPath, const QString &dstPath)
+{
+#ifndef WIN32
+    QByteArray localDstPath = dstPath.toUtf8();
+    int srcFd = open(srcPath.toUtf8().constData(), O_RDONLY);
+    if (srcFd < 0)
+    {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(srcFd, &info))
+    {
+        close(srcFd);
+        return;
+    }
+
+    int dstFd = open(localDstPath.constData(), O_WRONLY | O_CREAT | O_EXCL, info.st_mode & 0777);
+    if (dstFd < 0)
+    {
+        close(srcFd);
+        return;
+    }
+
+    bool success = false;
+#if defined(__linux__) && defined(FICLONE)
+    // Filesystems with reflinks share the extents instead of copying them
+    if (!ioctl(dstFd, FICLONE, srcFd))
+    {
+        addCopiedBytes(info.st_size);
+        success = true;
+    }
+#endif
+    if (!success)
+    {
+        success = copyData(srcFd, dstFd);
+    }
+
+    if (success)
+    {
+        struct timeval times[2];
+        times[0].tv_sec = times[1].tv_sec = info.st_mtime;
+        times[0].tv_usec = times[1].tv_usec = 0;
+        futimes(dstFd, times);
+    }
+
+    close(srcFd);
+    if (close(dstFd))
+    {
+        success = false;
+    }
+
+    if (!success)
+    {
+        unlink(localDstPath.constData());
+        return;
+    }
+#else
+    if (!QFile::copy(srcPath, dstPath))
+    {
+        return;
+    }
+    addCopiedBytes(QFileInfo(dstPath).size());
+#endif
+
+    mutex.lock();
+    copiedFiles++;
+    mutex.unlock();
+}
+
+bool LocalCopyEngine::copyData(int srcFd, int dstFd)
+{
+#ifndef WIN32
+#if defined(__linux__) && defined(SYS_copy_file_range)
+    bool copied = false;
+    // The kernel copies the data without passing it through user space
+    while (!isCancelled())
+    {
+        ssize_t size = syscall(SYS_copy_file_range, srcFd, NULL, dstFd, NULL, (size_t)CHUNK_SIZE, 0);
+        if (size < 0)
+        {
+            if (copied || (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP))
+            {
+                return false;
+            }
+            break;
+        }
+
+        if (!size)
+        {
+            return true;
+        }
+
+        copied = true;
+        addCopiedBytes(size);
+    }
+
+    if (copied)
+    {
+        return false;
+    }
+#endif
+
+    QByteArray buffer(CHUNK_SIZE, 0);
+    while (!isCancelled())
+    {
+        ssize_t size = read(srcFd, buffer.data(), CHUNK_SIZE);
+        if (size <= 0)
+        {
+            return !size;
+        }
+
+        for (ssize_t written = 0; written < size; )
+        {
+            ssize_t result = write(dstFd, buffer.constData() + written, size - written);
+            if (result < 0)
+            {
+                return false;
+            }
+            written += result;
+        }
+        addCopiedBytes(size);
+    }
+    return false;
+#else
+    Q_UNUSED(srcFd);
+    Q_UNUSED(dstFd);
+    return false;
+#endif
+}
+
+void LocalCopyEngine::addCopiedBytes(long long bytes)
+{
+    QMutexLocker locker(&mutex);
+    copiedBytes += bytes;
+}
+
+void LocalCopyEngine::applyFolderTimes(QList<QPair<QString, long long> > &folders)
+{
+#ifndef WIN32
+    // Children first, so setting their times doesn't touch their parents again
+    qSort(folders.begin(), folders.end(), longerPathFirst);
+    for (int i = 0; i < folders.size(); i++)
+    {
+        struct timeval times[2];
+        times[0].tv_sec = times[1].tv_sec = folders.at(i).second;
+        times[0].tv_usec = times[1].tv_usec = 0;
+        utimes(folders.at(i).first.toUtf8().constData(), times);
+    }
+#else
+    Q_UNUSED(folders);
+#endif
+}
+
+void LocalCopyEngine::onCopyStarted()
+{
+    if (!progressTimer.isActive())
+    {
+        progressTimer.start();
+    }
+}
+
+void LocalCopyEngine::onProgressTimeout()
+{
+    mutex.lock();
+    long long copied = copiedBytes;
+    long long total = totalBytes;
+    int numCopied = copiedFiles;
+    int numTotal = totalFiles;
+    mutex.unlock();
+
+    emit progress(copied, total, numCopied, numTotal);
+}
+
+void LocalCopyEngine::onCopyFinished()
+{
+    mutex.lock();
+    if (pendingTasks)
+    {
+        // A new copy started in the meantime
+        mutex.unlock();
+        return;
+    }
+
+    bool wasCancelled = cancelled;
+    cancelled = false;
+    copiedBytes = 0;
+    totalBytes = 0;
+    copiedFiles = 0;
+    totalFiles = 0;
+    mutex.unlock();
+
+    progressTimer.stop();
+    emit finished(wasCancelled);
+}
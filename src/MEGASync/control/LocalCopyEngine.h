@@ -0,0 +1,71 @@
+#ifndef LOCALCOPYENGINE_H
+#define LOCALCOPYENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QTimer>
+#include <QThreadPool>
+
+// Copies files and folder trees in a bounded thread pool. Folders are walked in
+// parallel, file contents are cloned or copied in the kernel when the platform
+// allows it, and modification times are kept.
+// copy() can be called from any thread, the signals are emitted in the thread of the engine.
+class LocalCopyEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LocalCopyEngine(QObject *parent = 0);
+    virtual ~LocalCopyEngine();
+
+    // Symlinks are skipped and existing destinations are left untouched
+    void copy(QString srcPath, QString dstPath);
+
+    static const int MAX_WORKERS;
+    static const int CHUNK_SIZE;
+    static const int PROGRESS_INTERVAL_MS;
+
+public slots:
+    void cancel();
+
+signals:
+    // Totals grow while folders are being walked
+    void progress(long long copiedBytes, long long totalBytes, int copiedFiles, int totalFiles);
+    void finished(bool cancelled);
+
+private slots:
+    void onCopyStarted();
+    void onProgressTimeout();
+    void onCopyFinished();
+
+private:
+    class CopyTask;
+
+    void startTask(const QString &srcPath, const QString &dstPath, bool isFolder);
+    void copyFolder(const QString &srcPath, const QString &dstPath);
+    void copyFile(const QString &srcPath, const QString &dstPath);
+    bool copyData(int srcFd, int dstFd);
+    void addCopiedBytes(long long bytes);
+    void taskFinished();
+    void applyFolderTimes(QList<QPair<QString, long long> > &folders);
+    bool isCancelled();
+
+    QThreadPool pool;
+    QTimer progressTimer;
+
+    QMutex mutex;
+    bool cancelled;
+    int pendingTasks;
+    long long copiedBytes;
+    long long totalBytes;
+    int copiedFiles;
+    int totalFiles;
+
+    // Folder times are applied once their contents have been copied
+    QList<QPair<QString, long long> > folderTimes;
+};
+
+#endif // LOCALCOPYENGINE_H
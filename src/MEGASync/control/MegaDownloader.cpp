@@ -2,23 +2,52 @@
 #include "Utilities.h"
 #include "MegaApplication.h"
 #include <QDateTime>
-#include <QPointer>
+#include <QSet>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 using namespace mega;
 
+const int MegaDownloader::BATCH_SIZE = 1000;
+
+class MegaDownloader::MaterializeTask : public QRunnable
+{
+public:
+    MaterializeTask(MegaDownloader *downloader, const QList<DownloadEntry> &entries, QString path,
+                    unsigned long long appDataId, int folderPermissions)
+        : downloader(downloader), entries(entries), path(path),
+          appDataId(appDataId), folderPermissions(folderPermissions) {}
+
+    virtual void run()
+    {
+        downloader->materialize(entries, path, appDataId, folderPermissions);
+    }
+
+private:
+    MegaDownloader *downloader;
+    QList<DownloadEntry> entries;
+    QString path;
+    unsigned long long appDataId;
+    int folderPermissions;
+};
+
 MegaDownloader::MegaDownloader(MegaApi *megaApi) : QObject()
 {
     this->megaApi = megaApi;
+    stopping = false;
 }
 
 MegaDownloader::~MegaDownloader()
 {
-
-}
-
-void MegaDownloader::download(MegaNode *parent, QString path, QString appData)
-{
-    return download(parent, QFileInfo(path), appData);
+    stopMutex.lock();
+    stopping = true;
+    stopMutex.unlock();
+    downloaderPool.waitForDone();
 }
 
 bool MegaDownloader::processDownloadQueue(QQueue<MegaNode *> *downloadQueue, QString path, unsigned long long appDataId)
@@ -33,113 +62,180 @@ bool MegaDownloader::processDownloadQueue(QQueue<MegaNode *> *downloadQueue, QSt
 
     TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(appDataId);
 
-    QString currentPath;
+    // Nodes inside foreign folders come after their parents in the queue
+    QSet<MegaHandle> foreignFolders;
+    QList<DownloadEntry> entries;
+    entries.reserve(downloadQueue->size());
     while (!downloadQueue->isEmpty())
     {
-        QString appData = QString::number(appDataId);
-        MegaNode *node = downloadQueue->dequeue();
-        if (node->isForeign() && pathMap.contains(node->getParentHandle()))
+        DownloadEntry entry;
+        entry.node = downloadQueue->dequeue();
+        entry.appData = QString::number(appDataId);
+        entry.topLevel = !entry.node->isForeign() || !foreignFolders.contains(entry.node->getParentHandle());
+        if (entry.topLevel && data)
         {
-            currentPath = pathMap[node->getParentHandle()];
-        }
-        else
-        {
-            if (data)
+            if (entry.node->isFolder())
             {
-                if (node->isFolder())
-                {
-                    data->totalFolders++;
-                }
-                else
-                {
-                    data->totalFiles++;
-                }
-                appData.append(QString::fromUtf8("*"));
+                data->totalFolders++;
+            }
+            else
+            {
+                data->totalFiles++;
+            }
+            entry.appData.append(QString::fromUtf8("*"));
 
-                if (data->localPath.isEmpty())
+            if (data->localPath.isEmpty())
+            {
+                data->localPath = QDir::toNativeSeparators(path);
+                if (data->totalTransfers == 1)
                 {
-                    data->localPath = QDir::toNativeSeparators(path);
-                    if (data->totalTransfers == 1)
-                    {
-                        char *escapedName = megaApi->escapeFsIncompatible(node->getName());
-                        QString nodeName = QString::fromUtf8(escapedName);
-                        delete [] escapedName;
-                        data->localPath += QDir::separator() + nodeName;
-                    }
+                    char *escapedName = megaApi->escapeFsIncompatible(entry.node->getName());
+                    QString nodeName = QString::fromUtf8(escapedName);
+                    delete [] escapedName;
+                    data->localPath += QDir::separator() + nodeName;
                 }
             }
-
-            currentPath = path;
         }
 
-        download(node, currentPath, appData);
-        delete node;
+        // Foreign folders can't be downloaded by the SDK, so their local folders are created here
+        if (entry.node->isForeign() && entry.node->getType() != MegaNode::TYPE_FILE)
+        {
+            char *escapedName = megaApi->escapeFsIncompatible(entry.node->getName());
+            entry.folderName = QString::fromUtf8(escapedName);
+            delete [] escapedName;
+            foreignFolders.insert(entry.node->getHandle());
+        }
+        entries.append(entry);
     }
-    pathMap.clear();
+
+    downloaderPool.start(new MaterializeTask(this, entries, QDir::toNativeSeparators(QFileInfo(path).absoluteFilePath()),
+                                             appDataId, megaApi->getDefaultFolderPermissions()));
     return true;
 }
 
-void MegaDownloader::download(MegaNode *parent, QFileInfo info, QString appData)
+void MegaDownloader::materialize(QList<DownloadEntry> &entries, const QString &path, unsigned long long appDataId, int folderPermissions)
 {
-    QPointer<MegaDownloader> safePointer = this;
-    QApplication::processEvents();
-    if (!safePointer)
+    QString openPath;
+    int openFd = -1;
+    QList<MegaHandle> createdFolders;
+    int numFinished = 0;
+    int numTopLevelOK = 0;
+    int numTopLevelFailed = 0;
+    for (int i = 0; i < entries.size(); i++)
     {
-        return;
+        const DownloadEntry &entry = entries.at(i);
+        MegaNode *node = entry.node;
+        if (!isStopping())
+        {
+            QString currentPath = path;
+            if (!entry.topLevel && !getFolderPath(FolderKey(appDataId, node->getParentHandle()), &currentPath))
+            {
+                // The parent folder couldn't be created
+                numFinished++;
+            }
+            else if (entry.folderName.isEmpty())
+            {
+                megaApi->startDownloadWithData(node, (currentPath + QDir::separator()).toUtf8().constData(), entry.appData.toUtf8().constData());
+            }
+            else
+            {
+                bool created = createFolder(currentPath, entry.folderName, folderPermissions, &openPath, &openFd);
+                if (created)
+                {
+                    setFolderPath(FolderKey(appDataId, node->getHandle()), currentPath + QDir::separator() + entry.folderName);
+                    createdFolders.append(node->getHandle());
+                }
+
+                numFinished++;
+                if (entry.topLevel)
+                {
+                    created ? numTopLevelOK++ : numTopLevelFailed++;
+                }
+            }
+        }
+        delete node;
+
+        if (numFinished && ((i + 1) % BATCH_SIZE == 0 || i + 1 == entries.size()))
+        {
+            emit foldersCreated(appDataId, numFinished, numTopLevelOK, numTopLevelFailed);
+            numFinished = 0;
+            numTopLevelOK = 0;
+            numTopLevelFailed = 0;
+        }
     }
 
-    QString currentPath = QDir::toNativeSeparators(info.absoluteFilePath());
+#ifndef WIN32
+    if (openFd >= 0)
+    {
+        close(openFd);
+    }
+#endif
 
-    if (parent->getType() == MegaNode::TYPE_FILE)
+    QWriteLocker locker(&folderPathsLock);
+    for (int i = 0; i < createdFolders.size(); i++)
     {
-        megaApi->startDownloadWithData(parent, (currentPath + QDir::separator()).toUtf8().constData(),appData.toUtf8().constData());
+        folderPaths.remove(FolderKey(appDataId, createdFolders.at(i)));
     }
-    else
+}
+
+bool MegaDownloader::createFolder(const QString &parentPath, const QString &name, int folderPermissions, QString *openPath, int *openFd)
+{
+#ifndef WIN32
+    // Siblings usually follow each other, so their parent is kept open between calls
+    if (*openFd < 0 || *openPath != parentPath)
     {
-        if (!parent->isForeign())
+        if (*openFd >= 0)
         {
-            megaApi->startDownloadWithData(parent, (currentPath + QDir::separator()).toUtf8().constData(), appData.toUtf8().constData());
+            close(*openFd);
         }
-        else
+
+        *openPath = parentPath;
+        *openFd = open(parentPath.toUtf8().constData(), O_RDONLY | O_DIRECTORY);
+        if (*openFd < 0)
         {
-            char *escapedName = megaApi->escapeFsIncompatible(parent->getName());
-            QString nodeName = QString::fromUtf8(escapedName);
-            delete [] escapedName;
+            return false;
+        }
+    }
 
-            QString destPath = currentPath + QDir::separator() + nodeName;
-            QDir dir(destPath);
-            if (!dir.exists())
-            {
-    #ifndef WIN32
-                if (!megaApi->createLocalFolder(dir.toNativeSeparators(destPath).toUtf8().constData()))
-    #else
-                if (!dir.mkpath(QString::fromAscii(".")))
-    #endif
-                {
-                    return;
-                }
-            }
+    QByteArray localName = name.toUtf8();
+    if (!mkdirat(*openFd, localName.constData(), folderPermissions))
+    {
+        return true;
+    }
 
-            QByteArray appDataArray = appData.toUtf8();
-            char *endptr;
-            unsigned long long notificationId = strtoll(appDataArray.constData(), &endptr, 10);
-            TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(notificationId);
-            if (data)
-            {
-                if ((endptr - appDataArray.constData()) != appData.size())
-                {
-                    data->transfersFolderOK++;
-                }
+    struct stat info;
+    return errno == EEXIST && !fstatat(*openFd, localName.constData(), &info, 0) && S_ISDIR(info.st_mode);
+#else
+    Q_UNUSED(folderPermissions);
+    Q_UNUSED(openPath);
+    Q_UNUSED(openFd);
 
-                data->pendingTransfers--;
-                if (data->pendingTransfers == 0)
-                {
-                    //Transfers finished, show notification
-                    emit finishedTransfers(notificationId);
-                }
-            }
+    QDir dir(parentPath + QDir::separator() + name);
+    return dir.exists() || dir.mkpath(QString::fromAscii("."));
+#endif
+}
 
-            pathMap[parent->getHandle()] = destPath;
-        }
+void MegaDownloader::setFolderPath(const FolderKey &key, const QString &path)
+{
+    QWriteLocker locker(&folderPathsLock);
+    folderPaths.insert(key, path);
+}
+
+bool MegaDownloader::getFolderPath(const FolderKey &key, QString *path)
+{
+    QReadLocker locker(&folderPathsLock);
+    QHash<FolderKey, QString>::const_iterator it = folderPaths.constFind(key);
+    if (it == folderPaths.constEnd())
+    {
+        return false;
     }
+
+    *path = it.value();
+    return true;
+}
+
+bool MegaDownloader::isStopping()
+{
+    QMutexLocker locker(&stopMutex);
+    return stopping;
 }
@@ -6,7 +6,11 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QQueue>
-#include <QMap>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QThreadPool>
 #include "megaapi.h"
 
 class MegaDownloader : public QObject
@@ -18,17 +22,45 @@ public:
     // provide megaApiGuest
     MegaDownloader(mega::MegaApi *megaApi);
     virtual ~MegaDownloader();
+
+    // Takes the nodes of the queue. Local folders for foreign folders are created
+    // from a worker thread, and every download is started as soon as its parent exists
     bool processDownloadQueue(QQueue<mega::MegaNode *> *downloadQueue, QString path, unsigned long long appDataId);
-    void download(mega::MegaNode *parent, QString path, QString appData);
+
+    static const int BATCH_SIZE;
 
 protected:
-    void download(mega::MegaNode *parent, QFileInfo info, QString appData);
+    struct DownloadEntry
+    {
+        mega::MegaNode *node;
+        QString appData;
+        QString folderName;
+        bool topLevel;
+    };
+
+    // Local folders are indexed by the download they belong to and the handle of their node
+    typedef QPair<unsigned long long, mega::MegaHandle> FolderKey;
+
+    class MaterializeTask;
+
+    void materialize(QList<DownloadEntry> &entries, const QString &path, unsigned long long appDataId, int folderPermissions);
+    bool createFolder(const QString &parentPath, const QString &name, int folderPermissions, QString *openPath, int *openFd);
+    void setFolderPath(const FolderKey &key, const QString &path);
+    bool getFolderPath(const FolderKey &key, QString *path);
+    bool isStopping();
 
     mega::MegaApi *megaApi;
-    QMap<mega::MegaHandle, QString> pathMap;
+    QHash<FolderKey, QString> folderPaths;
+    QReadWriteLock folderPathsLock;
+
+    QThreadPool downloaderPool;
+    QMutex stopMutex;
+    bool stopping;
 
 signals:
-    void finishedTransfers(unsigned long long appDataId);
+    // Emitted from a worker thread for the foreign folders created or skipped in a batch.
+    // Only top level folders are counted as succeeded or failed
+    void foldersCreated(unsigned long long appDataId, int numFinished, int numTopLevelOK, int numTopLevelFailed);
 };
 
 #endif // MEGADOWNLOADER_H
@@ -2,47 +2,196 @@
 #include "Utilities.h"
 
 #include <iostream>
-#include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 
 #include <QFileInfo>
 #include <QString>
 #include <QDesktopServices>
 #include <QDir>
 
+#include <QtEndian>
+
+#include <zlib.h>
+
 #define MEGA_LOGGER QString::fromUtf8("MEGA_LOGGER")
 #define ENABLE_MEGASYNC_LOGS QString::fromUtf8("MEGA_ENABLE_LOGS")
 #define MAX_MESSAGE_SIZE 4096
 
+// Stream sent to MEGAlogger: this header, then frames made of a 4-byte payload size
+// followed by records. Each record has the log level (1 byte), the size of the time
+// (1 byte), the size of the message (4 bytes) and both strings in UTF-8.
+// Sizes are big endian.
+#define LOG_STREAM_HEADER "MEGALOG\x01"
+#define LOG_STREAM_HEADER_SIZE 8
+#define FRAME_HEADER_SIZE 4
+#define RECORD_HEADER_SIZE 6
+
 using namespace mega;
 using namespace std;
 
+const int MegaSyncLogger::RING_SIZE = 16384;
+const int MegaSyncLogger::FLUSH_INTERVAL_MS = 200;
+const long long MegaSyncLogger::DEFAULT_SEGMENT_SIZE = 10485760;
+const int MegaSyncLogger::DEFAULT_NUM_SEGMENTS = 10;
+const int MegaSyncLogger::IO_CHUNK_SIZE = 65536;
+
+class MegaSyncLogger::WriterThread : public QThread
+{
+public:
+    WriterThread(MegaSyncLogger *logger) : logger(logger) {}
+
+protected:
+    virtual void run()
+    {
+        logger->writerLoop();
+    }
+
+private:
+    MegaSyncLogger *logger;
+};
+
+class MegaSyncLogger::CompressTask : public QRunnable
+{
+public:
+    CompressTask(MegaSyncLogger *logger, QString segmentPath)
+        : logger(logger), segmentPath(segmentPath) {}
+
+    virtual void run()
+    {
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        logger->compressSegment(segmentPath);
+    }
+
+private:
+    MegaSyncLogger *logger;
+    QString segmentPath;
+};
+
+class MegaSyncLogger::ExportTask : public QRunnable
+{
+public:
+    ExportTask(MegaSyncLogger *logger, QString path)
+        : logger(logger), path(path) {}
+
+    virtual void run()
+    {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        emit logger->logsExported(path, logger->writeExport(path));
+    }
+
+private:
+    MegaSyncLogger *logger;
+    QString path;
+};
+
+static inline int loadAcquire(QAtomicInt &value)
+{
+#if QT_VERSION >= 0x050000
+    return value.loadAcquire();
+#else
+    return value.fetchAndAddAcquire(0);
+#endif
+}
+
+static inline void storeRelease(QAtomicInt &value, int newValue)
+{
+#if QT_VERSION >= 0x050000
+    value.storeRelease(newValue);
+#else
+    value.fetchAndStoreRelease(newValue);
+#endif
+}
+
+// Positions wrap around, only their differences are meaningful
+static inline int advance(int position, int steps)
+{
+    return (int)((unsigned int)position + (unsigned int)steps);
+}
+
+static inline int distance(int from, int to)
+{
+    return (int)((unsigned int)to - (unsigned int)from);
+}
+
 MegaSyncLogger::MegaSyncLogger(QObject *parent) : QObject(parent), MegaLogger()
 {
-    xmlWriter = NULL;
-    connected = true;
+    connected = false;
+    headerSent = false;
     logToStdout = false;
     logToFile = false;
     client = NULL;
     megaServer = NULL;
 
+    ring = new RingSlot[RING_SIZE];
+    for (int i = 0; i < RING_SIZE; i++)
+    {
+        storeRelease(ring[i].sequence, i);
+    }
+    storeRelease(pushPosition, 0);
+    storeRelease(numDroppedLines, 0);
+    storeRelease(overflowing, 0);
+    popPosition = 0;
+    writerStopping = false;
+    wakeRequested = false;
+    flushRequests = 0;
+    flushedRequests = 0;
+
+    logFilePath = getLogFilePath();
+    segmentSize = DEFAULT_SEGMENT_SIZE;
+    numSegments = DEFAULT_NUM_SEGMENTS;
+    if (getenv("MEGA_LOG_SEGMENT_SIZE_MB") && atoi(getenv("MEGA_LOG_SEGMENT_SIZE_MB")) > 0)
+    {
+        segmentSize = atoi(getenv("MEGA_LOG_SEGMENT_SIZE_MB")) * 1048576LL;
+    }
+    if (getenv("MEGA_LOG_SEGMENTS") && atoi(getenv("MEGA_LOG_SEGMENTS")) > 0)
+    {
+        numSegments = atoi(getenv("MEGA_LOG_SEGMENTS"));
+    }
+    compressorPool.setMaxThreadCount(1);
+    QMap<int, QString> segments = getSegments();
+    nextSegment = segments.size() ? segments.keys().last() + 1 : 1;
+    for (QMap<int, QString>::const_iterator it = segments.constBegin(); it != segments.constEnd(); ++it)
+    {
+        // Compressions interrupted by the previous execution
+        if (!it.value().endsWith(QString::fromAscii(".gz")))
+        {
+            compressorPool.start(new CompressTask(this, it.value()));
+        }
+    }
+
+    writer = new WriterThread(this);
+    writer->start(QThread::LowPriority);
+
 #ifdef LOG_TO_LOGGER
     QLocalServer::removeServer(ENABLE_MEGASYNC_LOGS);
     client = new QLocalSocket();
     megaServer = new QLocalServer(this);
 
     connect(megaServer,SIGNAL(newConnection()),this,SLOT(clientConnected()));
-    connect(this, SIGNAL(sendLog(QString,int,QString)),
-            this, SLOT(onLogAvailable(QString,int,QString)), Qt::QueuedConnection);
+    connect(this, SIGNAL(sendLogBatch(QByteArray)),
+            this, SLOT(onLogBatchAvailable(QByteArray)), Qt::QueuedConnection);
     connect(client, SIGNAL(disconnected()), this, SLOT(disconnected()));
     connect(client, SIGNAL(error(QLocalSocket::LocalSocketError)), SLOT(disconnected()));
 
     megaServer->listen(ENABLE_MEGASYNC_LOGS);
     client->connectToServer(MEGA_LOGGER);
+    connected = true;
 #endif
 }
 
 MegaSyncLogger::~MegaSyncLogger()
 {
+    writerMutex.lock();
+    writerStopping = true;
+    writerCondition.wakeOne();
+    writerMutex.unlock();
+    writer->wait();
+    delete writer;
+    delete [] ring;
+    compressorPool.waitForDone();
+
     disconnected();
 
     if (megaServer)
@@ -53,111 +202,135 @@ MegaSyncLogger::~MegaSyncLogger()
 
 void MegaSyncLogger::log(const char *time, int loglevel, const char *source, const char *message)
 {
+    bool toLogger = false;
 #ifdef LOG_TO_LOGGER
-    if (connected)
+    toLogger = connected;
+#endif
+    if (!logToFile && !logToStdout && !toLogger)
     {
-        QString m = QString::fromUtf8(message);
-        if (m.size() > MAX_MESSAGE_SIZE)
-        {
-            m = m.left(MAX_MESSAGE_SIZE - 3).append(QString::fromUtf8("..."));
-        }
+        return;
+    }
 
-#ifdef DEBUG
-        QString fileName;
-        QFileInfo info(QString::fromUtf8(source));
-        fileName = info.fileName();
-        if (fileName.size())
+    const char *fileName = source ? source : "";
+    for (const char *c = fileName; *c; c++)
+    {
+        if (*c == '/' || *c == '\\')
         {
-            m.append(QString::fromUtf8(" (%1)").arg(fileName));
+            fileName = c + 1;
         }
-#endif
-
-        emit sendLog(QString::fromUtf8(time), loglevel, m);
     }
-#endif
 
+    QByteArray line;
     if (logToFile || logToStdout)
     {
-        QString fileName;
-        QFileInfo info(QString::fromUtf8(source));
-        fileName = info.fileName();
-
-        ostringstream oss;
-        oss << time;
+        const char *levelTag;
         switch(loglevel)
         {
             case MegaApi::LOG_LEVEL_DEBUG:
-                oss << " (debug): ";
+                levelTag = " (debug): ";
                 break;
             case MegaApi::LOG_LEVEL_ERROR:
-                oss << " (error): ";
+                levelTag = " (error): ";
                 break;
             case MegaApi::LOG_LEVEL_FATAL:
-                oss << " (fatal): ";
+                levelTag = " (fatal): ";
                 break;
             case MegaApi::LOG_LEVEL_INFO:
-                oss << " (info):  ";
+                levelTag = " (info):  ";
                 break;
             case MegaApi::LOG_LEVEL_MAX:
-                oss << " (verb):  ";
+                levelTag = " (verb):  ";
                 break;
             case MegaApi::LOG_LEVEL_WARNING:
-                oss << " (warn):  ";
+                levelTag = " (warn):  ";
+                break;
+            default:
+                levelTag = "";
                 break;
         }
 
-        oss << message;
-        if (fileName.size())
-        {
-            oss << " ("<< fileName.toUtf8().constData() << ")";
-        }
-
-        if (logToStdout)
+        line.reserve(int(strlen(time) + strlen(message) + strlen(fileName)) + 16);
+        line.append(time).append(levelTag).append(message);
+        if (*fileName)
         {
-            cout << oss.str() << endl;
+            line.append(" (").append(fileName).append(')');
         }
+        line.append('\n');
+    }
 
-        if (logToFile)
-        {
-            static QString filePath;
-            if (filePath.isEmpty())
-            {
-                QString dataPath;
-#if QT_VERSION < 0x050000
-                dataPath = QDesktopServices::storageLocation(QDesktopServices::DesktopLocation);
+    QByteArray record;
+    if (toLogger)
+    {
+#ifdef DEBUG
+        appendRecord(&record, loglevel, time, message, fileName);
 #else
-                QStringList desktopPaths = QStandardPaths::standardLocations(QStandardPaths::DesktopLocation);
-                if (desktopPaths.size())
-                {
-                    dataPath = desktopPaths.at(0);
-                }
-                else
-                {
-                    dataPath = Utilities::getDefaultBasePath();
-                }
+        appendRecord(&record, loglevel, time, message, "");
 #endif
-                filePath = dataPath + QDir::separator() + QString::fromAscii("MEGAsync.log");
-            }
+    }
 
-            QFile file(filePath);
-            if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
-            {
-                QTextStream out(&file);
-                out.setCodec("UTF-8");
-                out << QString::fromUtf8(oss.str().c_str()) << endl;
-            }
+    bool queued = push(line, record);
+    if (queued && loglevel > MegaApi::LOG_LEVEL_ERROR)
+    {
+        return;
+    }
+
+    if (!queued && !overflowing.testAndSetOrdered(0, 1))
+    {
+        // The writer was already woken by the first line dropped in this overflow
+        return;
+    }
+
+    // Errors are written as soon as possible, and so is a full buffer
+    wakeWriter();
+}
+
+void MegaSyncLogger::appendRecord(QByteArray *record, int loglevel, const char *time, const char *message, const char *fileName)
+{
+    // Messages are cut at a character boundary so they stay valid UTF-8
+    int timeSize = qMin((int)strlen(time), 255);
+    int messageSize = (int)strlen(message);
+    bool truncated = messageSize > MAX_MESSAGE_SIZE;
+    if (truncated)
+    {
+        messageSize = MAX_MESSAGE_SIZE - 3;
+        while (messageSize && (message[messageSize] & 0xC0) == 0x80)
+        {
+            messageSize--;
         }
     }
+
+    int fileNameSize = (int)strlen(fileName);
+    int totalSize = messageSize + (truncated ? 3 : 0) + (fileNameSize ? fileNameSize + 3 : 0);
+
+    char header[RECORD_HEADER_SIZE];
+    header[0] = (char)loglevel;
+    header[1] = (char)timeSize;
+    qToBigEndian<quint32>(totalSize, (uchar *)header + 2);
+
+    record->reserve(record->size() + RECORD_HEADER_SIZE + timeSize + totalSize);
+    record->append(header, RECORD_HEADER_SIZE);
+    record->append(time, timeSize);
+    record->append(message, messageSize);
+    if (truncated)
+    {
+        record->append("...");
+    }
+    if (fileNameSize)
+    {
+        record->append(" (").append(fileName).append(')');
+    }
 }
 
 void MegaSyncLogger::sendLogsToStdout(bool enable)
 {
     this->logToStdout = enable;
+    wakeWriter();
 }
 
 void MegaSyncLogger::sendLogsToFile(bool enable)
 {
     this->logToFile = enable;
+    wakeWriter();
 }
 
 bool MegaSyncLogger::isLogToStdoutEnabled()
@@ -170,67 +343,451 @@ bool MegaSyncLogger::isLogToFileEnabled()
     return logToFile;
 }
 
-void MegaSyncLogger::onLogAvailable(QString time, int loglevel, QString message)
+void MegaSyncLogger::flush()
 {
-    if (!connected)
+    QMutexLocker locker(&writerMutex);
+    long long request = ++flushRequests;
+    writerCondition.wakeOne();
+    while (flushedRequests < request && !writerStopping)
     {
-        return;
+        flushedCondition.wait(&writerMutex);
+    }
+}
+
+bool MegaSyncLogger::flushBeforeCrash(int timeoutMs)
+{
+    // The crashed thread could be holding the mutex or be the writer itself
+    if (!writerMutex.tryLock(timeoutMs))
+    {
+        return false;
+    }
+
+    long long request = ++flushRequests;
+    writerCondition.wakeOne();
+    bool waiting = true;
+    while (flushedRequests < request && !writerStopping && waiting)
+    {
+        waiting = flushedCondition.wait(&writerMutex, timeoutMs);
     }
+    bool flushed = flushedRequests >= request;
+    writerMutex.unlock();
+    return flushed;
+}
 
-    if (!xmlWriter)
+int MegaSyncLogger::getNumDroppedLines()
+{
+    return loadAcquire(numDroppedLines);
+}
+
+bool MegaSyncLogger::push(QByteArray &line, QByteArray &record)
+{
+    // Bounded multi-producer queue: each slot has a sequence number that tells
+    // producers when it's free and the writer when its line is ready
+    int position = loadAcquire(pushPosition);
+    RingSlot *slot;
+    forever
     {
-        xmlWriter = new QXmlStreamWriter(client);
-        xmlWriter->writeStartDocument();
-        xmlWriter->writeStartElement(QString::fromUtf8("MEGA"));
+        slot = &ring[position & (RING_SIZE - 1)];
+        int difference = distance(position, loadAcquire(slot->sequence));
+        if (!difference)
+        {
+            if (pushPosition.testAndSetRelaxed(position, advance(position, 1)))
+            {
+                break;
+            }
+            position = loadAcquire(pushPosition);
+        }
+        else if (difference < 0)
+        {
+            numDroppedLines.ref();
+            return false;
+        }
+        else
+        {
+            position = loadAcquire(pushPosition);
+        }
+    }
+
+    slot->line = line;
+    slot->record = record;
+    storeRelease(slot->sequence, advance(position, 1));
 
-        xmlWriter->writeStartElement(QString::fromUtf8("log"));
-        xmlWriter->writeAttribute(QString::fromUtf8("timestamp"), time);
-        xmlWriter->writeAttribute(QString::fromUtf8("type"), QString::fromUtf8("info"));
-        xmlWriter->writeAttribute(QString::fromUtf8("content"), QString::fromUtf8("LOG START"));
-        xmlWriter->writeEndElement();
+    if (!(position & (RING_SIZE / 4 - 1)))
+    {
+        // Don't wait for the next periodic flush if lines come faster than that
+        wakeWriter();
     }
+    return true;
+}
 
-    if (xmlWriter->hasError())
+bool MegaSyncLogger::pop(QByteArray *line, QByteArray *record)
+{
+    RingSlot *slot = &ring[popPosition & (RING_SIZE - 1)];
+    if (distance(advance(popPosition, 1), loadAcquire(slot->sequence)) < 0)
     {
-        connected = false;
-        delete xmlWriter;
-        xmlWriter = NULL;
-        client->deleteLater();
-        client = NULL;
-        return;
+        return false;
     }
 
-    QString level;
-    switch(loglevel)
+    *line = slot->line;
+    *record = slot->record;
+    slot->line = QByteArray();
+    slot->record = QByteArray();
+    storeRelease(slot->sequence, advance(popPosition, RING_SIZE));
+    popPosition = advance(popPosition, 1);
+    return true;
+}
+
+void MegaSyncLogger::wakeWriter()
+{
+    writerMutex.lock();
+    wakeRequested = true;
+    writerCondition.wakeOne();
+    writerMutex.unlock();
+}
+
+void MegaSyncLogger::writerLoop()
+{
+    QFile file(logFilePath);
+    int reportedDrops = 0;
+    bool stopping = false;
+    while (!stopping)
     {
-        case MegaApi::LOG_LEVEL_DEBUG:
-            level = QString::fromUtf8("debug");
-            break;
-        case MegaApi::LOG_LEVEL_ERROR:
-            level = QString::fromUtf8("error");
-            break;
-        case MegaApi::LOG_LEVEL_FATAL:
-            level = QString::fromUtf8("fatal");
-            break;
-        case MegaApi::LOG_LEVEL_INFO:
-            level = QString::fromUtf8("info");
-            break;
-        case MegaApi::LOG_LEVEL_MAX:
-            level = QString::fromUtf8("verbose");
-            break;
-        case MegaApi::LOG_LEVEL_WARNING:
-            level = QString::fromUtf8("warning");
-            break;
-        default:
-            level = QString::fromUtf8("unknown");
+        writerMutex.lock();
+        if (!wakeRequested && !writerStopping && flushRequests == flushedRequests)
+        {
+            writerCondition.wait(&writerMutex, (logToFile || logToStdout || connected) ? FLUSH_INTERVAL_MS : ULONG_MAX);
+        }
+        wakeRequested = false;
+        stopping = writerStopping;
+        long long requests = flushRequests;
+        writerMutex.unlock();
+
+        if (logToFile && !file.isOpen())
+        {
+            file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+        }
+        else if (!logToFile && file.isOpen())
+        {
+            file.close();
+        }
+
+        writeLines(&file, logToStdout, &reportedDrops);
+        storeRelease(overflowing, 0);
+
+        writerMutex.lock();
+        flushedRequests = requests;
+        flushedCondition.wakeAll();
+        writerMutex.unlock();
+    }
+}
+
+void MegaSyncLogger::writeLines(QFile *file, bool toStdout, int *reportedDrops)
+{
+    static const int MAX_BATCH_SIZE = 65536;
+
+    // Lines queued before this point are written even if their producers are still copying them
+    int end = loadAcquire(pushPosition);
+    int droppedLines = loadAcquire(numDroppedLines);
+
+    QByteArray batch;
+    QByteArray records;
+    QByteArray line;
+    QByteArray record;
+    while (distance(popPosition, end) > 0)
+    {
+        if (!pop(&line, &record))
+        {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        batch.append(line);
+        records.append(record);
+        bool last = distance(popPosition, end) <= 0;
+        if (batch.size() >= MAX_BATCH_SIZE || (last && batch.size()))
+        {
+            if (droppedLines != *reportedDrops)
+            {
+                batch.append(QString::fromUtf8("%1 log lines dropped\n").arg(droppedLines - *reportedDrops).toUtf8());
+                *reportedDrops = droppedLines;
+            }
+
+            if (file->isOpen())
+            {
+                writeToFile(file, batch);
+            }
+
+            if (toStdout)
+            {
+                cout.write(batch.constData(), batch.size());
+            }
+            batch.clear();
+        }
+
+        if (records.size() >= MAX_BATCH_SIZE || (last && records.size()))
+        {
+            // One frame per batch: payload size and the records as they were queued
+            QByteArray frame(FRAME_HEADER_SIZE, 0);
+            qToBigEndian<quint32>(records.size(), (uchar *)frame.data());
+            frame.append(records);
+            emit sendLogBatch(frame);
+            records.clear();
+        }
+    }
+
+    if (file->isOpen())
+    {
+        file->flush();
+    }
+    if (toStdout)
+    {
+        cout.flush();
+    }
+}
+
+void MegaSyncLogger::setRotation(long long segmentSize, int numSegments)
+{
+    QMutexLocker locker(&writerMutex);
+    this->segmentSize = segmentSize;
+    this->numSegments = numSegments;
+}
+
+void MegaSyncLogger::exportLogs(QString path)
+{
+    flush();
+    // Compressions are queued in the same thread, so no segment changes while it's read
+    compressorPool.start(new ExportTask(this, path));
+}
+
+void MegaSyncLogger::writeToFile(QFile *file, const QByteArray &data)
+{
+    writerMutex.lock();
+    long long maxSize = segmentSize;
+    writerMutex.unlock();
+
+    if (file->size() && file->size() + data.size() > maxSize)
+    {
+        rotate(file);
+        if (!file->isOpen())
+        {
+            return;
+        }
+    }
+    file->write(data);
+}
+
+void MegaSyncLogger::rotate(QFile *file)
+{
+    QString segmentPath = logFilePath + QString::fromAscii(".%1").arg(nextSegment);
+    file->close();
+    if (QFile::rename(logFilePath, segmentPath))
+    {
+        nextSegment++;
+        compressorPool.start(new CompressTask(this, segmentPath));
+    }
+
+    // If the file couldn't be renamed (it can be in use in Windows), it keeps growing until the next try
+    file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
+
+void MegaSyncLogger::compressSegment(const QString &segmentPath)
+{
+    QString compressedPath = segmentPath + QString::fromAscii(".gz");
+    QString temporaryPath = compressedPath + QString::fromAscii(".tmp");
+    QFile segment(segmentPath);
+    QFile compressed(temporaryPath);
+    if (segment.open(QIODevice::ReadOnly) && compressed.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        bool success = gzip(&segment, segment.size(), &compressed);
+        segment.close();
+        if (!compressed.flush())
+        {
+            success = false;
+        }
+        compressed.close();
+
+        if (success)
+        {
+            QFile::remove(compressedPath);
+            if (QFile::rename(temporaryPath, compressedPath))
+            {
+                QFile::remove(segmentPath);
+            }
+        }
+        else
+        {
+            QFile::remove(temporaryPath);
+        }
+    }
+
+    writerMutex.lock();
+    int maxSegments = numSegments;
+    writerMutex.unlock();
+
+    QMap<int, QString> segments = getSegments();
+    QMap<int, QString>::iterator it = segments.begin();
+    while (segments.size() > maxSegments && it != segments.end())
+    {
+        QFile::remove(it.value());
+        it = segments.erase(it);
+    }
+}
+
+bool MegaSyncLogger::writeExport(const QString &path)
+{
+    QFile output(path);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    // Concatenated gzip members are a valid gzip file, so compressed segments are copied as they are
+    QStringList paths = getSegments().values();
+    paths.append(logFilePath);
+    QByteArray buffer(IO_CHUNK_SIZE, 0);
+    bool success = true;
+    for (int i = 0; i < paths.size() && success; i++)
+    {
+        QFile input(paths.at(i));
+        if (!input.open(QIODevice::ReadOnly))
+        {
+            continue;
+        }
+
+        if (!paths.at(i).endsWith(QString::fromAscii(".gz")))
+        {
+            success = gzip(&input, input.size(), &output);
+            continue;
+        }
+
+        qint64 size;
+        while (success && (size = input.read(buffer.data(), IO_CHUNK_SIZE)) > 0)
+        {
+            success = (output.write(buffer.constData(), size) == size);
+        }
+    }
+
+    if (!output.flush())
+    {
+        success = false;
+    }
+    output.close();
+    if (!success)
+    {
+        QFile::remove(path);
+    }
+    return success;
+}
+
+QMap<int, QString> MegaSyncLogger::getSegments()
+{
+    // Segments are named after the log file plus an increasing number, oldest first
+    QMap<int, QString> segments;
+    QFileInfo logFile(logFilePath);
+    QString prefix = logFile.fileName() + QString::fromAscii(".");
+    QDir dir = logFile.absoluteDir();
+    QStringList names = dir.entryList(QStringList(prefix + QString::fromAscii("*")), QDir::Files);
+    for (int i = 0; i < names.size(); i++)
+    {
+        QString suffix = names.at(i).mid(prefix.size());
+        bool compressed = suffix.endsWith(QString::fromAscii(".gz"));
+        if (compressed)
+        {
+            suffix.chop(3);
+        }
+
+        bool ok;
+        int index = suffix.toInt(&ok);
+        if (ok && index > 0 && (compressed || !segments.contains(index)))
+        {
+            segments.insert(index, dir.filePath(names.at(i)));
+        }
+    }
+    return segments;
+}
+
+bool MegaSyncLogger::gzip(QIODevice *source, qint64 size, QIODevice *destination)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 more window bits to get a gzip header and trailer
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    QByteArray input(IO_CHUNK_SIZE, 0);
+    QByteArray output(IO_CHUNK_SIZE, 0);
+    bool success = true;
+    int flush = Z_NO_FLUSH;
+    while (success && flush != Z_FINISH)
+    {
+        qint64 read = size > 0 ? source->read(input.data(), qMin((qint64)IO_CHUNK_SIZE, size)) : 0;
+        if (read < 0)
+        {
+            success = false;
             break;
+        }
+
+        size -= read;
+        flush = (size <= 0 || !read) ? Z_FINISH : Z_NO_FLUSH;
+        stream.next_in = (Bytef *)input.data();
+        stream.avail_in = (uInt)read;
+        do
+        {
+            stream.next_out = (Bytef *)output.data();
+            stream.avail_out = IO_CHUNK_SIZE;
+            deflate(&stream, flush);
+            qint64 available = IO_CHUNK_SIZE - stream.avail_out;
+            if (available && destination->write(output.constData(), available) != available)
+            {
+                success = false;
+                break;
+            }
+        } while (!stream.avail_out);
+    }
+
+    deflateEnd(&stream);
+    return success;
+}
+
+QString MegaSyncLogger::getLogFilePath()
+{
+    QString dataPath;
+#if QT_VERSION < 0x050000
+    dataPath = QDesktopServices::storageLocation(QDesktopServices::DesktopLocation);
+#else
+    QStringList desktopPaths = QStandardPaths::standardLocations(QStandardPaths::DesktopLocation);
+    if (desktopPaths.size())
+    {
+        dataPath = desktopPaths.at(0);
+    }
+    else
+    {
+        dataPath = Utilities::getDefaultBasePath();
+    }
+#endif
+    return dataPath + QDir::separator() + QString::fromAscii("MEGAsync.log");
+}
+
+void MegaSyncLogger::onLogBatchAvailable(QByteArray frame)
+{
+    if (!connected || !client)
+    {
+        return;
     }
 
-    xmlWriter->writeStartElement(QString::fromUtf8("log"));
-    xmlWriter->writeAttribute(QString::fromUtf8("timestamp"), time);
-    xmlWriter->writeAttribute(QString::fromUtf8("type"),level);
-    xmlWriter->writeAttribute(QString::fromUtf8("content"), message);
-    xmlWriter->writeEndElement();
+    if (!headerSent)
+    {
+        client->write(LOG_STREAM_HEADER, LOG_STREAM_HEADER_SIZE);
+        headerSent = true;
+    }
+
+    if (client->write(frame) != frame.size())
+    {
+        disconnected();
+        return;
+    }
     client->flush();
 }
 
@@ -255,11 +812,7 @@ void MegaSyncLogger::clientConnected()
 void MegaSyncLogger::disconnected()
 {
     connected = false;
-    if (xmlWriter)
-    {
-        delete xmlWriter;
-        xmlWriter = NULL;
-    }
+    headerSent = false;
 
     if (client)
     {
@@ -3,10 +3,25 @@
 
 #include <QLocalSocket>
 #include <QLocalServer>
-#include <QXmlStreamWriter>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QThreadPool>
+#include <QFile>
+#include <QMap>
 
 #include "megaapi.h"
 
+// Lines for the log file and stdout are formatted by the threads that log them and
+// queued in a lock-free ring buffer. A writer thread takes them in batches and
+// writes them through a file that stays open, so logging never waits for the disk.
+// If the buffer is full, lines are dropped and counted, and the writer is woken
+// once per overflow.
+// Binary records for MEGAlogger travel in the same buffer and are sent in batches.
+// The log file is rotated when it grows too much. Closed segments are gzipped
+// in a low priority thread and only the newest ones are kept.
 class MegaSyncLogger : public QObject, public mega::MegaLogger
 {
     Q_OBJECT
@@ -19,22 +34,88 @@ public:
     void sendLogsToFile(bool enable);
     bool isLogToStdoutEnabled();
     bool isLogToFileEnabled();
+    // Blocks until the lines queued so far have been written
+    void flush();
+    // Same as flush(), for the breakpad filter: it gives up after the timeout.
+    // Not async-signal-safe, so it must not be called from a signal handler
+    bool flushBeforeCrash(int timeoutMs);
+    // Lines dropped because the buffer was full
+    int getNumDroppedLines();
+    void setRotation(long long segmentSize, int numSegments);
+    // Writes all the segments to a single gzip file, without loading them in memory.
+    // logsExported is emitted when it finishes
+    void exportLogs(QString path);
+
+    static const int RING_SIZE;
+    static const int FLUSH_INTERVAL_MS;
+    static const long long DEFAULT_SEGMENT_SIZE;
+    static const int DEFAULT_NUM_SEGMENTS;
+    static const int IO_CHUNK_SIZE;
 
 signals:
-    void sendLog(QString time, int loglevel, QString message);
+    // Frames of binary records for MEGAlogger
+    void sendLogBatch(QByteArray frame);
+    void logsExported(QString path, bool success);
 
 public slots:
-    void onLogAvailable(QString time, int loglevel, QString message);
+    void onLogBatchAvailable(QByteArray frame);
     void clientConnected();
     void disconnected();
 
 protected:
+    class WriterThread;
+    class CompressTask;
+    class ExportTask;
+
+    struct RingSlot
+    {
+        QAtomicInt sequence;
+        QByteArray line;
+        QByteArray record;
+    };
+
+    bool push(QByteArray &line, QByteArray &record);
+    bool pop(QByteArray *line, QByteArray *record);
+    static void appendRecord(QByteArray *record, int loglevel, const char *time, const char *message, const char *fileName);
+    void wakeWriter();
+    void writerLoop();
+    void writeLines(QFile *file, bool toStdout, int *reportedDrops);
+    void writeToFile(QFile *file, const QByteArray &data);
+    void rotate(QFile *file);
+    void compressSegment(const QString &segmentPath);
+    bool writeExport(const QString &path);
+    QMap<int, QString> getSegments();
+    static bool gzip(QIODevice *source, qint64 size, QIODevice *destination);
+    static QString getLogFilePath();
+
     QLocalSocket* client;
     QLocalServer* megaServer;
-    QXmlStreamWriter *xmlWriter;
-    bool connected;
-    bool logToStdout;
-    bool logToFile;
+    volatile bool connected;
+    bool headerSent;
+    volatile bool logToStdout;
+    volatile bool logToFile;
+
+    RingSlot *ring;
+    QAtomicInt pushPosition;
+    int popPosition;
+    QAtomicInt numDroppedLines;
+    // Set when a line is dropped, until the writer empties the buffer again
+    QAtomicInt overflowing;
+
+    WriterThread *writer;
+    QMutex writerMutex;
+    QWaitCondition writerCondition;
+    QWaitCondition flushedCondition;
+    bool writerStopping;
+    bool wakeRequested;
+    long long flushRequests;
+    long long flushedRequests;
+
+    QString logFilePath;
+    long long segmentSize;
+    int numSegments;
+    int nextSegment;
+    QThreadPool compressorPool;
 };
 
 #endif // MEGASYNCLOGGER_H
@@ -13,64 +13,151 @@
 using namespace mega;
 using namespace std;
 
+const int MegaUploader::BATCH_SIZE = 1000;
+
+class MegaUploader::PlanTask : public QRunnable
+{
+public:
+    PlanTask(MegaUploader *uploader, const QStringList &paths, MegaNode *parent, unsigned long long appDataID)
+        : uploader(uploader), paths(paths), parent(parent), appDataID(appDataID) {}
+
+    virtual void run()
+    {
+        uploader->plan(paths, parent, appDataID);
+        delete parent;
+    }
+
+private:
+    MegaUploader *uploader;
+    QStringList paths;
+    MegaNode *parent;
+    unsigned long long appDataID;
+};
+
 MegaUploader::MegaUploader(MegaApi *megaApi)
 {
     this->megaApi = megaApi;
+    stopping = false;
+    plannerPool.setMaxThreadCount(1);
 
+    copyEngine = new LocalCopyEngine(this);
+    connect(copyEngine, SIGNAL(progress(long long, long long, int, int)), this, SIGNAL(copyProgress(long long, long long, int, int)));
+    connect(copyEngine, SIGNAL(finished(bool)), this, SIGNAL(copyFinished(bool)));
 }
 
 MegaUploader::~MegaUploader()
 {
+    stopMutex.lock();
+    stopping = true;
+    stopMutex.unlock();
+    plannerPool.waitForDone();
+    delete copyEngine;
+}
 
+void MegaUploader::cancelCopies()
+{
+    copyEngine->cancel();
 }
 
 void MegaUploader::upload(QString path, MegaNode *parent, unsigned long long appDataID)
 {
-    return upload(QFileInfo(path), parent, appDataID);
+    upload(QStringList() << path, parent, appDataID);
 }
 
-void MegaUploader::upload(QFileInfo info, MegaNode *parent, unsigned long long appDataID)
+void MegaUploader::upload(QStringList paths, MegaNode *parent, unsigned long long appDataID)
 {
-    QPointer<MegaUploader> safePointer = this;
-    QApplication::processEvents();
-    if (!safePointer)
+    if (paths.isEmpty())
     {
         return;
     }
 
-    QString fileName = info.fileName();
-    if (fileName.isEmpty() && info.isRoot())
+    plannerPool.start(new PlanTask(this, paths, parent->copy(), appDataID));
+}
+
+bool MegaUploader::isStopping()
+{
+    QMutexLocker locker(&stopMutex);
+    return stopping;
+}
+
+MegaUploader::UploadEntry MegaUploader::getUploadEntry(const QString &path)
+{
+    QFileInfo info(path);
+    UploadEntry entry;
+    entry.path = QDir::toNativeSeparators(info.absoluteFilePath());
+    entry.fileName = info.fileName();
+    entry.isFile = info.isFile();
+    entry.isDir = !entry.isFile && info.isDir();
+    entry.size = entry.isFile ? info.size() : 0;
+
+    if (entry.fileName.isEmpty() && info.isRoot())
     {
-        fileName = QDir::toNativeSeparators(info.absoluteFilePath())
+        entry.fileName = entry.path
                 .replace(QString::fromUtf8("\\"), QString::fromUtf8(""))
                 .replace(QString::fromUtf8("/"), QString::fromUtf8(""))
                 .replace(QString::fromUtf8(":"), QString::fromUtf8(""));
+        entry.path = QDir::toNativeSeparators(info.absoluteFilePath());
 
-        if (fileName.isEmpty())
+        if (entry.fileName.isEmpty())
         {
-            fileName = QString::fromUtf8("Drive");
+            entry.fileName = QString::fromUtf8("Drive");
         }
     }
+    return entry;
+}
 
-    QString currentPath = QDir::toNativeSeparators(info.absoluteFilePath());
+void MegaUploader::plan(const QStringList &paths, MegaNode *parent, unsigned long long appDataID)
+{
     string localPath = megaApi->getLocalPath(parent);
+    for (int first = 0; first < paths.size() && !isStopping(); first += BATCH_SIZE)
+    {
+        // Paths of a batch are checked in parallel, then their uploads are started in order
+        QList<UploadEntry> entries = QtConcurrent::blockingMapped(paths.mid(first, BATCH_SIZE), getUploadEntry);
+
+        int numFiles = 0;
+        int numFolders = 0;
+        int numSkipped = 0;
+        for (int i = 0; i < entries.size(); i++)
+        {
+            const UploadEntry &entry = entries.at(i);
+            entry.isDir ? numFolders++ : numFiles++;
+            if (!upload(entry, parent, localPath, appDataID))
+            {
+                numSkipped++;
+            }
+        }
+
+        emit uploadBatchPlanned(appDataID, numFiles, numFolders, numSkipped);
+    }
+}
+
+bool MegaUploader::upload(const UploadEntry &entry, MegaNode *parent, const string &localPath, unsigned long long appDataID)
+{
+    if (localPath.size())
+    {
 #ifdef WIN32
-        QString destPath = QDir::toNativeSeparators(QString::fromWCharArray((const wchar_t *)localPath.data()) + QDir::separator() + fileName);
+        QString destPath = QDir::toNativeSeparators(QString::fromWCharArray((const wchar_t *)localPath.data()) + QDir::separator() + entry.fileName);
         if (destPath.startsWith(QString::fromAscii("\\\\?\\")))
         {
             destPath = destPath.mid(4);
         }
 #else
-        QString destPath = QDir::toNativeSeparators(QString::fromUtf8(localPath.data()) + QDir::separator() + fileName);
+        QString destPath = QDir::toNativeSeparators(QString::fromUtf8(localPath.data()) + QDir::separator() + entry.fileName);
 #endif
 
-    if (localPath.size() && currentPath != destPath && megaApi->isSyncable(destPath.toUtf8().constData(), info.size()))
-    {
-        megaApi->moveToLocalDebris(destPath.toUtf8().constData());
-        QtConcurrent::run(Utilities::copyRecursively, currentPath, destPath);
+        // Uploads into a synced folder are copies that the sync engine will upload
+        if (entry.path != destPath && megaApi->isSyncable(destPath.toUtf8().constData(), entry.size))
+        {
+            megaApi->moveToLocalDebris(destPath.toUtf8().constData());
+            copyEngine->copy(entry.path, destPath);
+            return false;
+        }
     }
-    else if (info.isFile() || info.isDir())
+
+    if (entry.isFile || entry.isDir)
     {
-        megaApi->startUploadWithData(currentPath.toUtf8().constData(), parent, (QString::number(appDataID) + QString::fromUtf8("*")).toUtf8().constData());
+        megaApi->startUploadWithData(entry.path.toUtf8().constData(), parent, (QString::number(appDataID) + QString::fromUtf8("*")).toUtf8().constData());
+        return true;
     }
+    return false;
 }
@@ -2,12 +2,16 @@
 #define MEGAUPLOADER_H
 
 #include <QString>
+#include <QStringList>
 #include <QFileInfo>
 #include <QDir>
 #include <QQueue>
+#include <QMutex>
+#include <QThreadPool>
 #include "Preferences.h"
 #include "megaapi.h"
 #include "QTMegaRequestListener.h"
+#include "LocalCopyEngine.h"
 
 class MegaUploader : public QObject
 {
@@ -16,12 +20,50 @@ class MegaUploader : public QObject
 public:
     MegaUploader(mega::MegaApi *megaApi);
     virtual ~MegaUploader();
+
+    // Paths are checked and their uploads started from a worker thread,
+    // in the same order as requested
+    void upload(QStringList paths, mega::MegaNode *parent, unsigned long long appDataID);
     void upload(QString path, mega::MegaNode *parent, unsigned long long appDataID);
 
+    static const int BATCH_SIZE;
+
+public slots:
+    void cancelCopies();
+
+signals:
+    // Emitted from the worker thread after each batch, with the counts of that batch.
+    // Skipped paths won't produce any transfer.
+    void uploadBatchPlanned(unsigned long long appDataID, int numFiles, int numFolders, int numSkipped);
+
+    // Progress of the copies into synced folders
+    void copyProgress(long long copiedBytes, long long totalBytes, int copiedFiles, int totalFiles);
+    void copyFinished(bool cancelled);
+
 protected:
-    void upload(QFileInfo info, mega::MegaNode *parent, unsigned long long appDataID);
+    struct UploadEntry
+    {
+        QString path;
+        QString fileName;
+        long long size;
+        bool isFile;
+        bool isDir;
+    };
+
+    class PlanTask;
+
+    static UploadEntry getUploadEntry(const QString &path);
+    void plan(const QStringList &paths, mega::MegaNode *parent, unsigned long long appDataID);
+    bool upload(const UploadEntry &entry, mega::MegaNode *parent, const std::string &localPath, unsigned long long appDataID);
+    bool isStopping();
 
     mega::MegaApi *megaApi;
+    LocalCopyEngine *copyEngine;
+
+    // A single thread, so plans run one after another
+    QThreadPool plannerPool;
+    QMutex stopMutex;
+    bool stopping;
 };
 
 #endif // MEGAUPLOADER_H
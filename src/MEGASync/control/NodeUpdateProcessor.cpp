@@ -0,0 +1,145 @@
+#include "NodeUpdateProcessor.h"
+
+using namespace mega;
+
+class NodeUpdateProcessor::ProcessTask : public QRunnable
+{
+public:
+    ProcessTask(NodeUpdateProcessor *processor, MegaNodeList *nodes, QSharedPointer<const SyncRegistry> syncs,
+                bool nodesCurrent, long long lastExit, QString account, int storageEpoch)
+        : processor(processor), nodes(nodes), syncs(syncs),
+          nodesCurrent(nodesCurrent), lastExit(lastExit), account(account), storageEpoch(storageEpoch) {}
+
+    virtual void run()
+    {
+        processor->processNodes(nodes, syncs.data(), nodesCurrent, lastExit, account, storageEpoch);
+        delete nodes;
+    }
+
+private:
+    NodeUpdateProcessor *processor;
+    MegaNodeList *nodes;
+    QSharedPointer<const SyncRegistry> syncs;
+    bool nodesCurrent;
+    long long lastExit;
+    QString account;
+    int storageEpoch;
+};
+
+NodeUpdateSummary::NodeUpdateSummary()
+{
+    storageEpoch = 0;
+    usedStorageDelta = 0;
+    cloudDriveDelta = 0;
+    inShareDelta = 0;
+    newNodes = false;
+    nodesRemoved = false;
+    externalNodes = false;
+    numNoKeyNodes = 0;
+}
+
+NodeUpdateProcessor::NodeUpdateProcessor(MegaApi *megaApi, QObject *parent) : QObject(parent)
+{
+    this->megaApi = megaApi;
+    stopping = false;
+    processorPool.setMaxThreadCount(1);
+    qRegisterMetaType<NodeUpdateSummary>("NodeUpdateSummary");
+}
+
+NodeUpdateProcessor::~NodeUpdateProcessor()
+{
+    stopMutex.lock();
+    stopping = true;
+    stopMutex.unlock();
+    processorPool.waitForDone();
+}
+
+void NodeUpdateProcessor::process(MegaNodeList *nodes, QSharedPointer<const SyncRegistry> syncs,
+                                  bool nodesCurrent, long long lastExit, QString account, int storageEpoch)
+{
+    processorPool.start(new ProcessTask(this, nodes, syncs, nodesCurrent, lastExit, account, storageEpoch));
+}
+
+void NodeUpdateProcessor::processNodes(MegaNodeList *nodes, const SyncRegistry *syncs, bool nodesCurrent,
+                                       long long lastExit, const QString &account, int storageEpoch)
+{
+    NodeUpdateSummary summary;
+    summary.account = account;
+    summary.storageEpoch = storageEpoch;
+    for (int i = 0; i < nodes->size() && !isStopping(); i++)
+    {
+        MegaNode *node = nodes->get(i);
+        int syncIndex = (node->getType() == MegaNode::TYPE_FOLDER) ? syncs->indexOfHandle(node->getHandle()) : -1;
+        if (syncIndex >= 0 && syncs->at(syncIndex).active)
+        {
+            const SyncEntry &sync = syncs->at(syncIndex);
+            MegaNode *nodeByHandle = megaApi->getNodeByHandle(sync.handle);
+            const char *nodePath = megaApi->getNodePath(nodeByHandle);
+            if (!nodePath || sync.megaPath.compare(QString::fromUtf8(nodePath)))
+            {
+                DisabledSync disabledSync;
+                disabledSync.syncID = sync.syncID;
+                disabledSync.name = sync.name;
+                disabledSync.localPath = sync.localPath;
+                disabledSync.handle = sync.handle;
+                disabledSync.inRubbishBin = nodePath && QString::fromUtf8(nodePath).startsWith(QString::fromUtf8("//bin"));
+                summary.disabledSyncs.append(disabledSync);
+            }
+            delete nodeByHandle;
+            delete [] nodePath;
+        }
+
+        if (node->getType() != MegaNode::TYPE_FILE)
+        {
+            continue;
+        }
+
+        if (nodesCurrent && node->isRemoved() && node->getSize())
+        {
+            summary.usedStorageDelta -= node->getSize();
+            summary.nodesRemoved = true;
+        }
+
+        if (nodesCurrent && !node->isRemoved() && !node->isSyncDeleted()
+                && node->getSize() && node->hasChanged(MegaNode::CHANGE_TYPE_NEW))
+        {
+            long long bytes = node->getSize();
+            if (!megaApi->isInCloud(node))
+            {
+                summary.inShareDelta += bytes;
+            }
+            else
+            {
+                summary.cloudDriveDelta += bytes;
+            }
+
+            summary.usedStorageDelta += bytes;
+            summary.newNodes = true;
+
+            if (!summary.externalNodes && !node->getTag()
+                    && ((lastExit / 1000) < node->getCreationTime())
+                    && megaApi->isInsideSync(node))
+            {
+                summary.externalNodes = true;
+            }
+        }
+
+        if (!node->isRemoved() && node->getTag()
+                && !node->isSyncDeleted()
+                && node->getAttrString()->size())
+        {
+            summary.numNoKeyNodes++;
+        }
+    }
+
+    if (!isStopping())
+    {
+        emit nodesProcessed(summary);
+    }
+}
+
+bool NodeUpdateProcessor::isStopping()
+{
+    QMutexLocker locker(&stopMutex);
+    return stopping;
+}
@@ -0,0 +1,77 @@
+#ifndef NODEUPDATEPROCESSOR_H
+#define NODEUPDATEPROCESSOR_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QMetaType>
+
+#include "SyncRegistry.h"
+#include "megaapi.h"
+
+// Sync that has to be disabled because its remote folder is gone
+struct DisabledSync
+{
+    QString syncID;
+    QString name;
+    QString localPath;
+    mega::MegaHandle handle;
+    bool inRubbishBin;
+};
+
+// Result of processing a list of updated nodes
+struct NodeUpdateSummary
+{
+    NodeUpdateSummary();
+
+    // Deltas only apply to the storage values of this account and epoch
+    QString account;
+    int storageEpoch;
+    long long usedStorageDelta;
+    long long cloudDriveDelta;
+    long long inShareDelta;
+    bool newNodes;
+    bool nodesRemoved;
+    bool externalNodes;
+    // Files created by this client without a key
+    int numNoKeyNodes;
+    QList<DisabledSync> disabledSyncs;
+};
+
+Q_DECLARE_METATYPE(NodeUpdateSummary)
+
+// Walks the lists of updated nodes received from the SDK in a worker thread.
+// Lists are processed one at a time, in the order they were received.
+class NodeUpdateProcessor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NodeUpdateProcessor(mega::MegaApi *megaApi, QObject *parent = 0);
+    virtual ~NodeUpdateProcessor();
+
+    // Takes the ownership of the list. Storage is only accounted when nodesCurrent is true.
+    // The account and the storage epoch are copied to the summary
+    void process(mega::MegaNodeList *nodes, QSharedPointer<const SyncRegistry> syncs,
+                 bool nodesCurrent, long long lastExit, QString account, int storageEpoch);
+
+signals:
+    void nodesProcessed(NodeUpdateSummary summary);
+
+private:
+    class ProcessTask;
+
+    void processNodes(mega::MegaNodeList *nodes, const SyncRegistry *syncs, bool nodesCurrent,
+                      long long lastExit, const QString &account, int storageEpoch);
+    bool isStopping();
+
+    mega::MegaApi *megaApi;
+    QThreadPool processorPool;
+    QMutex stopMutex;
+    bool stopping;
+};
+
+#endif // NODEUPDATEPROCESSOR_H
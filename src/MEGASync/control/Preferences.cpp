@@ -1,5 +1,6 @@
 #include "Preferences.h"
 #include "platform/Platform.h"
+#include "Tracer.h"
 
 #include <QDesktopServices>
 #include <assert.h>
@@ -459,6 +460,9 @@ void Preferences::initialize(QString dataPath)
     {
         clearAll();
     }
+
+    // Settings are replaced atomically now, so old backups are no longer needed
+    QFile::remove(bakSettingsFile);
 }
 
 Preferences::Preferences() : QObject(), mutex(QMutex::Recursive)
@@ -475,11 +479,8 @@ Preferences::Preferences() : QObject(), mutex(QMutex::Recursive)
 
 QString Preferences::email()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(emailKey).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(emailKey).toString();
 }
 
 void Preferences::setEmail(QString email)
@@ -494,11 +495,8 @@ void Preferences::setEmail(QString email)
 
 QString Preferences::firstName()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(firstNameKey, QString()).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(firstNameKey, QString()).toString();
 }
 
 void Preferences::setFirstName(QString firstName)
@@ -511,11 +509,8 @@ void Preferences::setFirstName(QString firstName)
 
 QString Preferences::lastName()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(lastNameKey, QString()).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastNameKey, QString()).toString();
 }
 
 void Preferences::setLastName(QString lastName)
@@ -528,20 +523,14 @@ void Preferences::setLastName(QString lastName)
 
 QString Preferences::emailHash()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(emailHashKey).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(emailHashKey).toString();
 }
 
 QString Preferences::privatePw()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(privatePwKey).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(privatePwKey).toString();
 }
 
 void Preferences::setSession(QString session)
@@ -557,11 +546,8 @@ void Preferences::setSession(QString session)
 
 QString Preferences::getSession()
 {
-    mutex.lock();
     assert(logged());
-    QString value = settings->value(sessionKey).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(sessionKey).toString();
 }
 
 unsigned long long Preferences::transferIdentifier()
@@ -586,11 +572,8 @@ void Preferences::setLastTransferNotificationTimestamp()
 
 long long Preferences::totalStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(totalStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(totalStorageKey).toLongLong();
 }
 
 void Preferences::setTotalStorage(long long value)
@@ -603,12 +586,8 @@ void Preferences::setTotalStorage(long long value)
 
 long long Preferences::usedStorage()
 {
-    mutex.lock();
     assert(logged());
-
-    long long value = settings->value(usedStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(usedStorageKey).toLongLong();
 }
 
 void Preferences::setUsedStorage(long long value)
@@ -625,22 +604,18 @@ void Preferences::setUsedStorage(long long value)
 
 long long Preferences::availableStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long total = settings->value(totalStorageKey).toLongLong();
-    long long used = settings->value(usedStorageKey).toLongLong();
-    mutex.unlock();
+    QVariantList values = settings->snapshotValues(QStringList() << totalStorageKey << usedStorageKey);
+    long long total = values.at(0).toLongLong();
+    long long used = values.at(1).toLongLong();
     long long available = total - used;
     return available >= 0 ? available : 0;
 }
 
 long long Preferences::cloudDriveStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(cloudDriveStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(cloudDriveStorageKey).toLongLong();
 }
 
 void Preferences::setCloudDriveStorage(long long value)
@@ -653,11 +628,8 @@ void Preferences::setCloudDriveStorage(long long value)
 
 long long Preferences::inboxStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inboxStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inboxStorageKey).toLongLong();
 }
 
 void Preferences::setInboxStorage(long long value)
@@ -670,11 +642,8 @@ void Preferences::setInboxStorage(long long value)
 
 long long Preferences::rubbishStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(rubbishStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(rubbishStorageKey).toLongLong();
 }
 
 void Preferences::setRubbishStorage(long long value)
@@ -687,11 +656,8 @@ void Preferences::setRubbishStorage(long long value)
 
 long long Preferences::inShareStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inShareStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inShareStorageKey).toLongLong();
 }
 
 void Preferences::setInShareStorage(long long value)
@@ -704,11 +670,8 @@ void Preferences::setInShareStorage(long long value)
 
 long long Preferences::versionsStorage()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(versionsStorageKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(versionsStorageKey).toLongLong();
 }
 
 void Preferences::setVersionsStorage(long long value)
@@ -721,11 +684,8 @@ void Preferences::setVersionsStorage(long long value)
 
 long long Preferences::cloudDriveFiles()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(cloudDriveFilesKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(cloudDriveFilesKey).toLongLong();
 }
 
 void Preferences::setCloudDriveFiles(long long value)
@@ -738,11 +698,8 @@ void Preferences::setCloudDriveFiles(long long value)
 
 long long Preferences::inboxFiles()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inboxFilesKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inboxFilesKey).toLongLong();
 }
 
 void Preferences::setInboxFiles(long long value)
@@ -755,11 +712,8 @@ void Preferences::setInboxFiles(long long value)
 
 long long Preferences::rubbishFiles()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(rubbishFilesKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(rubbishFilesKey).toLongLong();
 }
 
 void Preferences::setRubbishFiles(long long value)
@@ -772,11 +726,8 @@ void Preferences::setRubbishFiles(long long value)
 
 long long Preferences::inShareFiles()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inShareFilesKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inShareFilesKey).toLongLong();
 }
 
 void Preferences::setInShareFiles(long long value)
@@ -789,11 +740,8 @@ void Preferences::setInShareFiles(long long value)
 
 long long Preferences::cloudDriveFolders()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(cloudDriveFoldersKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(cloudDriveFoldersKey).toLongLong();
 }
 
 void Preferences::setCloudDriveFolders(long long value)
@@ -806,11 +754,8 @@ void Preferences::setCloudDriveFolders(long long value)
 
 long long Preferences::inboxFolders()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inboxFoldersKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inboxFoldersKey).toLongLong();
 }
 
 void Preferences::setInboxFolders(long long value)
@@ -823,11 +768,8 @@ void Preferences::setInboxFolders(long long value)
 
 long long Preferences::rubbishFolders()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(rubbishFoldersKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(rubbishFoldersKey).toLongLong();
 }
 
 void Preferences::setRubbishFolders(long long value)
@@ -840,11 +782,8 @@ void Preferences::setRubbishFolders(long long value)
 
 long long Preferences::inShareFolders()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(inShareFoldersKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(inShareFoldersKey).toLongLong();
 }
 
 void Preferences::setInShareFolders(long long value)
@@ -857,11 +796,8 @@ void Preferences::setInShareFolders(long long value)
 
 long long Preferences::totalBandwidth()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(totalBandwidthKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(totalBandwidthKey).toLongLong();
 }
 
 void Preferences::setTotalBandwidth(long long value)
@@ -874,11 +810,8 @@ void Preferences::setTotalBandwidth(long long value)
 
 int Preferences::bandwidthInterval()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(usedBandwidthIntervalKey).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(usedBandwidthIntervalKey).toInt();
 }
 
 void Preferences::setBandwidthInterval(int value)
@@ -1046,11 +979,8 @@ void Preferences::setTemporalBandwidthInterval(int value)
 
 long long Preferences::usedBandwidth()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(usedBandwidthKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(usedBandwidthKey).toLongLong();
 }
 
 void Preferences::setUsedBandwidth(long long value)
@@ -1063,11 +993,8 @@ void Preferences::setUsedBandwidth(long long value)
 
 int Preferences::accountType()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(accountTypeKey).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(accountTypeKey).toInt();
 }
 
 void Preferences::setAccountType(int value)
@@ -1080,10 +1007,7 @@ void Preferences::setAccountType(int value)
 
 bool Preferences::showNotifications()
 {
-    mutex.lock();
-    bool value = settings->value(showNotificationsKey, defaultShowNotifications).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(showNotificationsKey, defaultShowNotifications).toBool();
 }
 
 void Preferences::setShowNotifications(bool value)
@@ -1097,10 +1021,7 @@ void Preferences::setShowNotifications(bool value)
 
 bool Preferences::startOnStartup()
 {
-    mutex.lock();
-    bool value = settings->value(startOnStartupKey, defaultStartOnStartup).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(startOnStartupKey, defaultStartOnStartup).toBool();
 }
 
 void Preferences::setStartOnStartup(bool value)
@@ -1113,10 +1034,7 @@ void Preferences::setStartOnStartup(bool value)
 
 bool Preferences::usingHttpsOnly()
 {
-    mutex.lock();
-    bool value = settings->value(useHttpsOnlyKey, defaultUseHttpsOnly).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(useHttpsOnlyKey, defaultUseHttpsOnly).toBool();
 }
 
 void Preferences::setUseHttpsOnly(bool value)
@@ -1165,42 +1083,39 @@ void Preferences::setSSLcertificateException(bool value)
 
 int Preferences::transferDownloadMethod()
 {
-    mutex.lock();
-    int value = settings->value(transferDownloadMethodKey, defaultTransferDownloadMethod).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(transferDownloadMethodKey, defaultTransferDownloadMethod).toInt();
 }
 
 void Preferences::setTransferDownloadMethod(int value)
 {
     mutex.lock();
-    settings->setValue(transferDownloadMethodKey, value);
-    settings->sync();
+    if (settings->value(transferDownloadMethodKey, defaultTransferDownloadMethod).toInt() != value)
+    {
+        settings->setValue(transferDownloadMethodKey, value);
+        settings->sync();
+    }
     mutex.unlock();
 }
 
 int Preferences::transferUploadMethod()
 {
-    mutex.lock();
-    int value = settings->value(transferUploadMethodKey, defaultTransferUploadMethod).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(transferUploadMethodKey, defaultTransferUploadMethod).toInt();
 }
 
 void Preferences::setTransferUploadMethod(int value)
 {
     mutex.lock();
-    settings->setValue(transferUploadMethodKey, value);
-    settings->sync();
+    if (settings->value(transferUploadMethodKey, defaultTransferUploadMethod).toInt() != value)
+    {
+        settings->setValue(transferUploadMethodKey, value);
+        settings->sync();
+    }
     mutex.unlock();
 }
 
 QString Preferences::language()
 {
-    mutex.lock();
-    QString value = settings->value(languageKey, QLocale::system().name()).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(languageKey, QLocale::system().name()).toString();
 }
 
 void Preferences::setLanguage(QString &value)
@@ -1213,10 +1128,7 @@ void Preferences::setLanguage(QString &value)
 
 bool Preferences::updateAutomatically()
 {
-    mutex.lock();
-    bool value = settings->value(updateAutomaticallyKey, defaultUpdateAutomatically).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(updateAutomaticallyKey, defaultUpdateAutomatically).toBool();
 }
 
 void Preferences::setUpdateAutomatically(bool value)
@@ -1229,26 +1141,17 @@ void Preferences::setUpdateAutomatically(bool value)
 
 bool Preferences::hasDefaultUploadFolder()
 {
-    mutex.lock();
-    bool value = settings->value(hasDefaultUploadFolderKey, uploadFolder() != 0).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(hasDefaultUploadFolderKey, uploadFolder() != 0).toBool();
 }
 
 bool Preferences::hasDefaultDownloadFolder()
 {
-    mutex.lock();
-    bool value = settings->value(hasDefaultDownloadFolderKey, !downloadFolder().isEmpty()).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(hasDefaultDownloadFolderKey, !downloadFolder().isEmpty()).toBool();
 }
 
 bool Preferences::hasDefaultImportFolder()
 {
-    mutex.lock();
-    bool value = settings->value(hasDefaultImportFolderKey, importFolder() != 0).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(hasDefaultImportFolderKey, importFolder() != 0).toBool();
 }
 
 void Preferences::setHasDefaultUploadFolder(bool value)
@@ -1299,11 +1202,8 @@ bool Preferences::canUpdate(QString filePath)
 
 int Preferences::uploadLimitKB()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(uploadLimitKBKey, defaultUploadLimitKB).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(uploadLimitKBKey, defaultUploadLimitKB).toInt();
 }
 
 void Preferences::setUploadLimitKB(int value)
@@ -1317,27 +1217,18 @@ void Preferences::setUploadLimitKB(int value)
 
 int Preferences::downloadLimitKB()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(downloadLimitKBKey, defaultDownloadLimitKB).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(downloadLimitKBKey, defaultDownloadLimitKB).toInt();
 }
 
 int Preferences::parallelUploadConnections()
 {
-    mutex.lock();
-    int value = settings->value(parallelUploadConnectionsKey, defaultParallelUploadConnections).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(parallelUploadConnectionsKey, defaultParallelUploadConnections).toInt();
 }
 
 int Preferences::parallelDownloadConnections()
 {
-    mutex.lock();
-    int value = settings->value(parallelDownloadConnectionsKey, defaultParallelDownloadConnections).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(parallelDownloadConnectionsKey, defaultParallelDownloadConnections).toInt();
 }
 
 void Preferences::setParallelUploadConnections(int value)
@@ -1377,10 +1268,7 @@ void Preferences::setDownloadLimitKB(int value)
 
 bool Preferences::upperSizeLimit()
 {
-    mutex.lock();
-    bool value = settings->value(upperSizeLimitKey, defaultUpperSizeLimit).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(upperSizeLimitKey, defaultUpperSizeLimit).toBool();
 }
 
 void Preferences::setUpperSizeLimit(bool value)
@@ -1393,11 +1281,8 @@ void Preferences::setUpperSizeLimit(bool value)
 
 long long Preferences::upperSizeLimitValue()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(upperSizeLimitValueKey, defaultUpperSizeLimitValue).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(upperSizeLimitValueKey, defaultUpperSizeLimitValue).toLongLong();
 }
 void Preferences::setUpperSizeLimitValue(long long value)
 {
@@ -1410,10 +1295,7 @@ void Preferences::setUpperSizeLimitValue(long long value)
 
 bool Preferences::cleanerDaysLimit()
 {
-    mutex.lock();
-    bool value = settings->value(cleanerDaysLimitKey, defaultCleanerDaysLimit).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(cleanerDaysLimitKey, defaultCleanerDaysLimit).toBool();
 }
 
 void Preferences::setCleanerDaysLimit(bool value)
@@ -1426,11 +1308,8 @@ void Preferences::setCleanerDaysLimit(bool value)
 
 int Preferences::cleanerDaysLimitValue()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(cleanerDaysLimitValueKey, defaultCleanerDaysLimitValue).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(cleanerDaysLimitValueKey, defaultCleanerDaysLimitValue).toInt();
 }
 void Preferences::setCleanerDaysLimitValue(int value)
 {
@@ -1443,11 +1322,8 @@ void Preferences::setCleanerDaysLimitValue(int value)
 
 int Preferences::upperSizeLimitUnit()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(upperSizeLimitUnitKey, defaultUpperSizeLimitUnit).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(upperSizeLimitUnitKey, defaultUpperSizeLimitUnit).toInt();
 }
 void Preferences::setUpperSizeLimitUnit(int value)
 {
@@ -1460,10 +1336,7 @@ void Preferences::setUpperSizeLimitUnit(int value)
 
 bool Preferences::lowerSizeLimit()
 {
-    mutex.lock();
-    bool value = settings->value(lowerSizeLimitKey, defaultLowerSizeLimit).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lowerSizeLimitKey, defaultLowerSizeLimit).toBool();
 }
 
 void Preferences::setLowerSizeLimit(bool value)
@@ -1476,11 +1349,8 @@ void Preferences::setLowerSizeLimit(bool value)
 
 long long Preferences::lowerSizeLimitValue()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(lowerSizeLimitValueKey, defaultLowerSizeLimitValue).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lowerSizeLimitValueKey, defaultLowerSizeLimitValue).toLongLong();
 }
 void Preferences::setLowerSizeLimitValue(long long value)
 {
@@ -1493,11 +1363,8 @@ void Preferences::setLowerSizeLimitValue(long long value)
 
 int Preferences::lowerSizeLimitUnit()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(lowerSizeLimitUnitKey, defaultLowerSizeLimitUnit).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lowerSizeLimitUnitKey, defaultLowerSizeLimitUnit).toInt();
 }
 void Preferences::setLowerSizeLimitUnit(int value)
 {
@@ -1542,10 +1409,7 @@ void Preferences::setFilePermissionsValue(int permissions)
 
 int Preferences::proxyType()
 {
-    mutex.lock();
-    int value = settings->value(proxyTypeKey, defaultProxyType).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyTypeKey, defaultProxyType).toInt();
 }
 
 void Preferences::setProxyType(int value)
@@ -1558,10 +1422,7 @@ void Preferences::setProxyType(int value)
 
 int Preferences::proxyProtocol()
 {
-    mutex.lock();
-    int value = settings->value(proxyProtocolKey, defaultProxyProtocol).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyProtocolKey, defaultProxyProtocol).toInt();
 }
 
 void Preferences::setProxyProtocol(int value)
@@ -1574,10 +1435,7 @@ void Preferences::setProxyProtocol(int value)
 
 QString Preferences::proxyServer()
 {
-    mutex.lock();
-    QString value = settings->value(proxyServerKey, defaultProxyServer).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyServerKey, defaultProxyServer).toString();
 }
 
 void Preferences::setProxyServer(const QString &value)
@@ -1590,10 +1448,7 @@ void Preferences::setProxyServer(const QString &value)
 
 int Preferences::proxyPort()
 {
-    mutex.lock();
-    int value = settings->value(proxyPortKey, defaultProxyPort).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyPortKey, defaultProxyPort).toInt();
 }
 
 void Preferences::setProxyPort(int value)
@@ -1606,10 +1461,7 @@ void Preferences::setProxyPort(int value)
 
 bool Preferences::proxyRequiresAuth()
 {
-    mutex.lock();
-    bool value = settings->value(proxyRequiresAuthKey, defaultProxyRequiresAuth).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyRequiresAuthKey, defaultProxyRequiresAuth).toBool();
 }
 
 void Preferences::setProxyRequiresAuth(bool value)
@@ -1622,10 +1474,7 @@ void Preferences::setProxyRequiresAuth(bool value)
 
 QString Preferences::getProxyUsername()
 {
-    mutex.lock();
-    QString value = settings->value(proxyUsernameKey, defaultProxyUsername).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyUsernameKey, defaultProxyUsername).toString();
 }
 
 void Preferences::setProxyUsername(const QString &value)
@@ -1638,10 +1487,7 @@ void Preferences::setProxyUsername(const QString &value)
 
 QString Preferences::getProxyPassword()
 {
-    mutex.lock();
-    QString value = settings->value(proxyPasswordKey, defaultProxyPassword).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(proxyPasswordKey, defaultProxyPassword).toString();
 }
 
 void Preferences::setProxyPassword(const QString &value)
@@ -1674,17 +1520,11 @@ QString Preferences::proxyHostAndPort()
 
 long long Preferences::lastExecutionTime()
 {
-    mutex.lock();
-    long long value = settings->value(lastExecutionTimeKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastExecutionTimeKey, 0).toLongLong();
 }
 long long Preferences::installationTime()
 {
-    mutex.lock();
-    long long value = settings->value(installationTimeKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(installationTimeKey, 0).toLongLong();
 }
 void Preferences::setInstallationTime(long long time)
 {
@@ -1695,10 +1535,7 @@ void Preferences::setInstallationTime(long long time)
 }
 long long Preferences::accountCreationTime()
 {
-    mutex.lock();
-    long long value = settings->value(accountCreationTimeKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(accountCreationTimeKey, 0).toLongLong();
 }
 void Preferences::setAccountCreationTime(long long time)
 {
@@ -1710,10 +1547,7 @@ void Preferences::setAccountCreationTime(long long time)
 }
 long long Preferences::hasLoggedIn()
 {
-    mutex.lock();
-    long long value = settings->value(hasLoggedInKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(hasLoggedInKey, 0).toLongLong();
 }
 void Preferences::setHasLoggedIn(long long time)
 {
@@ -1725,10 +1559,7 @@ void Preferences::setHasLoggedIn(long long time)
 
 bool Preferences::isFirstStartDone()
 {
-    mutex.lock();
-    bool value = settings->value(firstStartDoneKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(firstStartDoneKey, false).toBool();
 }
 
 void Preferences::setFirstStartDone(bool value)
@@ -1741,10 +1572,7 @@ void Preferences::setFirstStartDone(bool value)
 
 bool Preferences::isFirstSyncDone()
 {
-    mutex.lock();
-    bool value = settings->value(firstSyncDoneKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(firstSyncDoneKey, false).toBool();
 }
 
 void Preferences::setFirstSyncDone(bool value)
@@ -1757,10 +1585,7 @@ void Preferences::setFirstSyncDone(bool value)
 
 bool Preferences::isFirstFileSynced()
 {
-    mutex.lock();
-    bool value = settings->value(firstFileSyncedKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(firstFileSyncedKey, false).toBool();
 }
 
 void Preferences::setFirstFileSynced(bool value)
@@ -1773,10 +1598,7 @@ void Preferences::setFirstFileSynced(bool value)
 
 bool Preferences::isFirstWebDownloadDone()
 {
-    mutex.lock();
-    bool value = settings->value(firstWebDownloadKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(firstWebDownloadKey, false).toBool();
 }
 
 void Preferences::setFirstWebDownloadDone(bool value)
@@ -1789,10 +1611,7 @@ void Preferences::setFirstWebDownloadDone(bool value)
 
 bool Preferences::isFatWarningShown()
 {
-    mutex.lock();
-    bool value = settings->value(fatWarningShownKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(fatWarningShownKey, false).toBool();
 }
 
 void Preferences::setFatWarningShown(bool value)
@@ -1805,10 +1624,7 @@ void Preferences::setFatWarningShown(bool value)
 
 QString Preferences::lastCustomStreamingApp()
 {
-    mutex.lock();
-    QString value = settings->value(lastCustomStreamingAppKey).toString();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastCustomStreamingAppKey).toString();
 }
 
 void Preferences::setLastCustomStreamingApp(const QString &value)
@@ -1821,10 +1637,7 @@ void Preferences::setLastCustomStreamingApp(const QString &value)
 
 long long Preferences::getMaxMemoryUsage()
 {
-    mutex.lock();
-    long long value = settings->value(maxMemoryUsageKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(maxMemoryUsageKey, 0).toLongLong();
 }
 
 void Preferences::setMaxMemoryUsage(long long value)
@@ -1837,10 +1650,7 @@ void Preferences::setMaxMemoryUsage(long long value)
 
 long long Preferences::getMaxMemoryReportTime()
 {
-    mutex.lock();
-    long long value = settings->value(maxMemoryReportTimeKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(maxMemoryReportTimeKey, 0).toLongLong();
 }
 
 void Preferences::setMaxMemoryReportTime(long long timestamp)
@@ -1861,11 +1671,8 @@ void Preferences::setLastExecutionTime(qint64 time)
 
 long long Preferences::lastUpdateTime()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(lastUpdateTimeKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastUpdateTimeKey, 0).toLongLong();
 }
 
 void Preferences::setLastUpdateTime(long long time)
@@ -1879,11 +1686,8 @@ void Preferences::setLastUpdateTime(long long time)
 
 int Preferences::lastUpdateVersion()
 {
-    mutex.lock();
     assert(logged());
-    int value = settings->value(lastUpdateVersionKey, 0).toInt();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastUpdateVersionKey, 0).toInt();
 }
 
 void Preferences::setLastUpdateVersion(int version)
@@ -1913,11 +1717,8 @@ void Preferences::setDownloadFolder(QString value)
 
 long long Preferences::uploadFolder()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(uploadFolderKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(uploadFolderKey).toLongLong();
 }
 
 void Preferences::setUploadFolder(long long value)
@@ -1931,11 +1732,8 @@ void Preferences::setUploadFolder(long long value)
 
 long long Preferences::importFolder()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(importFolderKey).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(importFolderKey).toLongLong();
 }
 
 void Preferences::setImportFolder(long long value)
@@ -1949,6 +1747,7 @@ void Preferences::setImportFolder(long long value)
 
 int Preferences::getNumSyncedFolders()
 {
+    TRACE_SPAN("Preferences::getNumSyncedFolders");
     mutex.lock();
     int value = localFolders.length();
     mutex.unlock();
@@ -1985,23 +1784,14 @@ QString Preferences::getSyncID(int num)
 
 QString Preferences::getLocalFolder(int num)
 {
-    mutex.lock();
-    assert(logged() && (localFolders.size()>num));
-    if (num >= localFolders.size())
+    TRACE_SPAN("Preferences::getLocalFolder");
+    QSharedPointer<const SyncRegistry> registry = getSyncRegistry();
+    assert(logged() && (registry->size() > num));
+    if (num >= registry->size())
     {
-        mutex.unlock();
         return QString();
     }
-
-    QFileInfo fileInfo(localFolders.at(num));
-    QString value = QDir::toNativeSeparators(fileInfo.canonicalFilePath());
-    if (value.isEmpty())
-    {
-        value = QDir::toNativeSeparators(localFolders.at(num));
-    }
-
-    mutex.unlock();
-    return value;
+    return registry->at(num).localPath;
 }
 
 QString Preferences::getMegaFolder(int num)
@@ -2095,6 +1885,7 @@ void Preferences::setSyncState(int num, bool enabled, bool temporaryDisabled)
     }
     activeFolders[num] = enabled;
     temporaryInactiveFolders[num] = temporaryDisabled;
+    syncRegistry.clear();
     writeFolders();
     mutex.unlock();
 
@@ -2184,6 +1975,30 @@ QList<long long> Preferences::getMegaFolderHandles()
     return value;
 }
 
+QSharedPointer<const SyncRegistry> Preferences::getSyncRegistry()
+{
+    TRACE_SPAN("Preferences::getSyncRegistry");
+    QMutexLocker locker(&mutex);
+    if (!syncRegistry)
+    {
+        SyncRegistry *registry = new SyncRegistry();
+        for (int i = 0; i < localFolders.size(); i++)
+        {
+            SyncEntry entry;
+            entry.name = syncNames.at(i);
+            entry.syncID = syncIDs.at(i);
+            entry.localPath = localFolders.at(i);
+            entry.megaPath = megaFolders.at(i);
+            entry.handle = megaFolderHandles.at(i);
+            entry.active = activeFolders.at(i);
+            entry.temporaryInactive = temporaryInactiveFolders.at(i);
+            registry->addSync(entry);
+        }
+        syncRegistry = QSharedPointer<const SyncRegistry>(registry);
+    }
+    return syncRegistry;
+}
+
 void Preferences::addSyncedFolder(QString localFolder, QString megaFolder, mega::MegaHandle megaFolderHandle, QString syncName,  bool active)
 {
     mutex.lock();
@@ -2212,6 +2027,7 @@ void Preferences::addSyncedFolder(QString localFolder, QString megaFolder, mega:
     activeFolders.append(active);
     temporaryInactiveFolders.append(false);
     localFingerprints.append(0);
+    syncRegistry.clear();
     writeFolders();
     mutex.unlock();
     Platform::syncFolderAdded(localFolder, syncName, syncID);
@@ -2226,6 +2042,7 @@ void Preferences::setMegaFolderHandle(int num, MegaHandle handle)
         return;
     }
     megaFolderHandles[num] = handle;
+    syncRegistry.clear();
     writeFolders();
     mutex.unlock();
 }
@@ -2242,6 +2059,7 @@ void Preferences::removeSyncedFolder(int num)
     activeFolders.removeAt(num);
     temporaryInactiveFolders.removeAt(num);
     localFingerprints.removeAt(num);
+    syncRegistry.clear();
     writeFolders();
     mutex.unlock();
 }
@@ -2256,14 +2074,7 @@ void Preferences::removeAllFolders()
         Platform::syncFolderRemoved(localFolders[i], syncNames[i], syncIDs[i]);
     }
 
-    syncNames.clear();
-    syncIDs.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     writeFolders();
     mutex.unlock();
 }
@@ -2616,20 +2427,14 @@ void Preferences::setHttpsCertExpiration(long long expiration)
 
 long long Preferences::lastPublicHandleTimestamp()
 {
-    mutex.lock();
     assert(logged());
-    long long value = settings->value(lastPublicHandleTimestampKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastPublicHandleTimestampKey, 0).toLongLong();
 }
 
 MegaHandle Preferences::lastPublicHandle()
 {
-    mutex.lock();
     assert(logged());
-    MegaHandle value = settings->value(lastPublicHandleKey, (unsigned long long) mega::INVALID_HANDLE).toULongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastPublicHandleKey, (unsigned long long) mega::INVALID_HANDLE).toULongLong();
 }
 
 void Preferences::setLastPublicHandle(MegaHandle handle)
@@ -2659,6 +2464,8 @@ void Preferences::enterUser(int i)
     if (i < settings->numChildGroups())
     {
         settings->beginGroup(i);
+        settings->publishGroup();
+        preloadValues();
     }
 
     readFolders();
@@ -2671,16 +2478,10 @@ void Preferences::leaveUser()
     mutex.lock();
     assert(logged());
     settings->endGroup();
+    settings->publishGroup();
 
     clearTemporalBandwidth();
-    syncNames.clear();
-    syncIDs.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     mutex.unlock();
 }
 
@@ -2692,17 +2493,11 @@ void Preferences::unlink()
     settings->remove(privatePwKey);
     settings->remove(sessionKey);
     settings->endGroup();
+    settings->publishGroup();
 
     settings->remove(currentAccountKey);
     clearTemporalBandwidth();
-    syncNames.clear();
-    syncIDs.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     settings->sync();
     mutex.unlock();
     emit stateChanged();
@@ -2710,10 +2505,7 @@ void Preferences::unlink()
 
 bool Preferences::isCrashed()
 {
-    mutex.lock();
-    bool value = settings->value(isCrashedKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(isCrashedKey, false).toBool();
 }
 
 void Preferences::setCrashed(bool value)
@@ -2726,10 +2518,7 @@ void Preferences::setCrashed(bool value)
 
 bool Preferences::getGlobalPaused()
 {
-    mutex.lock();
-    bool value = settings->value(wasPausedKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(wasPausedKey, false).toBool();
 }
 
 void Preferences::setGlobalPaused(bool value)
@@ -2742,10 +2531,7 @@ void Preferences::setGlobalPaused(bool value)
 
 bool Preferences::getUploadsPaused()
 {
-    mutex.lock();
-    bool value = settings->value(wasUploadsPausedKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(wasUploadsPausedKey, false).toBool();
 }
 
 void Preferences::setUploadsPaused(bool value)
@@ -2758,10 +2544,7 @@ void Preferences::setUploadsPaused(bool value)
 
 bool Preferences::getDownloadsPaused()
 {
-    mutex.lock();
-    bool value = settings->value(wasDownloadsPausedKey, false).toBool();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(wasDownloadsPausedKey, false).toBool();
 }
 
 void Preferences::setDownloadsPaused(bool value)
@@ -2774,10 +2557,7 @@ void Preferences::setDownloadsPaused(bool value)
 
 long long Preferences::lastStatsRequest()
 {
-    mutex.lock();
-    long long value = settings->value(lastStatsRequestKey, 0).toLongLong();
-    mutex.unlock();
-    return value;
+    return settings->snapshotValue(lastStatsRequestKey, 0).toLongLong();
 }
 
 void Preferences::setLastStatsRequest(long long value)
@@ -2876,12 +2656,29 @@ void Preferences::sync()
     settings->sync();
 }
 
+void Preferences::waitForSync()
+{
+    settings->waitForSync();
+}
+
+void Preferences::beginTransaction()
+{
+    settings->beginTransaction();
+}
+
+void Preferences::commitTransaction()
+{
+    settings->commitTransaction();
+}
+
 void Preferences::login(QString account)
 {
     mutex.lock();
     logout();
     settings->setValue(currentAccountKey, account);
     settings->beginGroup(account);
+    settings->publishGroup();
+    preloadValues();
     readFolders();
     loadExcludedSyncNames();
     int lastVersion = settings->value(lastVersionKey).toInt();
@@ -2899,10 +2696,7 @@ void Preferences::login(QString account)
 
 bool Preferences::logged()
 {
-    mutex.lock();
-    bool value = !settings->isGroupEmpty();
-    mutex.unlock();
-    return value;
+    return !settings->isPublishedGroupEmpty();
 }
 
 bool Preferences::hasEmail(QString email)
@@ -2931,16 +2725,10 @@ void Preferences::logout()
     if (logged())
     {
         settings->endGroup();
+        settings->publishGroup();
     }
     clearTemporalBandwidth();
-    syncNames.clear();
-    syncIDs.clear();
-    localFolders.clear();
-    megaFolders.clear();
-    megaFolderHandles.clear();
-    activeFolders.clear();
-    temporaryInactiveFolders.clear();
-    localFingerprints.clear();
+    clearFolders();
     mutex.unlock();
 }
 
@@ -2999,10 +2787,9 @@ void Preferences::loadExcludedSyncNames()
     mutex.unlock();
 }
 
-void Preferences::readFolders()
+void Preferences::clearFolders()
 {
     mutex.lock();
-    assert(logged());
     syncNames.clear();
     syncIDs.clear();
     localFolders.clear();
@@ -3011,6 +2798,44 @@ void Preferences::readFolders()
     activeFolders.clear();
     temporaryInactiveFolders.clear();
     localFingerprints.clear();
+    syncRegistry.clear();
+    mutex.unlock();
+}
+
+void Preferences::preloadValues()
+{
+    // Keys read through snapshots, so their first reads don't need the lock
+    QStringList keys;
+    keys << accountCreationTimeKey << accountTypeKey << cleanerDaysLimitKey
+         << cleanerDaysLimitValueKey << cloudDriveFilesKey << cloudDriveFoldersKey
+         << cloudDriveStorageKey << downloadLimitKBKey << emailHashKey << emailKey
+         << fatWarningShownKey << firstFileSyncedKey << firstNameKey << firstStartDoneKey
+         << firstSyncDoneKey << firstWebDownloadKey << hasDefaultDownloadFolderKey
+         << hasDefaultImportFolderKey << hasDefaultUploadFolderKey << hasLoggedInKey
+         << importFolderKey << inShareFilesKey << inShareFoldersKey << inShareStorageKey
+         << inboxFilesKey << inboxFoldersKey << inboxStorageKey << installationTimeKey
+         << isCrashedKey << languageKey << lastCustomStreamingAppKey << lastExecutionTimeKey
+         << lastNameKey << lastPublicHandleKey << lastPublicHandleTimestampKey
+         << lastStatsRequestKey << lastUpdateTimeKey << lastUpdateVersionKey << lowerSizeLimitKey
+         << lowerSizeLimitUnitKey << lowerSizeLimitValueKey << maxMemoryReportTimeKey
+         << maxMemoryUsageKey << parallelDownloadConnectionsKey << parallelUploadConnectionsKey
+         << privatePwKey << proxyPasswordKey << proxyPortKey << proxyProtocolKey
+         << proxyRequiresAuthKey << proxyServerKey << proxyTypeKey << proxyUsernameKey
+         << rubbishFilesKey << rubbishFoldersKey << rubbishStorageKey << sessionKey
+         << showNotificationsKey << startOnStartupKey << totalBandwidthKey << totalStorageKey
+         << transferDownloadMethodKey << transferUploadMethodKey << updateAutomaticallyKey
+         << uploadFolderKey << uploadLimitKBKey << upperSizeLimitKey << upperSizeLimitUnitKey
+         << upperSizeLimitValueKey << useHttpsOnlyKey << usedBandwidthIntervalKey
+         << usedBandwidthKey << usedStorageKey << versionsStorageKey << wasDownloadsPausedKey
+         << wasPausedKey << wasUploadsPausedKey;
+    settings->preload(keys);
+}
+
+void Preferences::readFolders()
+{
+    mutex.lock();
+    assert(logged());
+    clearFolders();
 
     settings->beginGroup(syncsGroupKey);
     int numSyncs = settings->numChildGroups();
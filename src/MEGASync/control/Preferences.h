@@ -6,8 +6,10 @@
 #include <QLocale>
 #include <QStringList>
 #include <QMutex>
+#include <QSharedPointer>
 
 #include "control/EncryptedSettings.h"
+#include "control/SyncRegistry.h"
 #include "megaapi.h"
 
 Q_DECLARE_METATYPE(QList<long long>)
@@ -233,6 +235,9 @@ public:
     QStringList getMegaFolders();
     QStringList getLocalFolders();
     QList<long long> getMegaFolderHandles();
+    // Rebuilt only when the syncs change. The registry can be kept and used
+    // from any thread, it doesn't change afterwards
+    QSharedPointer<const SyncRegistry> getSyncRegistry();
 
     void addSyncedFolder(QString localFolder, QString megaFolder, mega::MegaHandle megaFolderHandle, QString syncName = QString(), bool active = true);
     void setMegaFolderHandle(int num, mega::MegaHandle handle);
@@ -294,6 +299,10 @@ public:
     void clearTemporalBandwidth();
     void clearAll();
     void sync();
+    void waitForSync();
+    // Settings changed between these calls are saved together
+    void beginTransaction();
+    void commitTransaction();
 
     enum {
         PROXY_TYPE_NONE = 0,
@@ -385,13 +394,17 @@ public:
     static const QString FINDER_EXT_BUNDLE_ID;
 
 protected:
+    // Serializes writers and group changes. Simple getters read
+    // the published settings snapshot and don't take it
     QMutex mutex;
     void login(QString account);
     void logout();
 
     void loadExcludedSyncNames();
+    void preloadValues();
     void readFolders();
     void writeFolders();
+    void clearFolders();
 
     EncryptedSettings *settings;
     QStringList syncNames;
@@ -402,6 +415,7 @@ protected:
     QList<long long> localFingerprints;
     QList<bool> activeFolders;
     QList<bool> temporaryInactiveFolders;
+    QSharedPointer<const SyncRegistry> syncRegistry;
     QStringList excludedSyncNames;
     QStringList excludedSyncPaths;
     bool errorFlag;
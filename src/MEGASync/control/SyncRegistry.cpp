@@ -0,0 +1,37 @@
+#include "SyncRegistry.h"
+#include <QFileInfo>
+#include <QDir>
+
+using namespace mega;
+
+SyncRegistry::SyncRegistry()
+{
+}
+
+void SyncRegistry::addSync(SyncEntry entry)
+{
+    QString canonicalPath = QFileInfo(entry.localPath).canonicalFilePath();
+    entry.exists = !canonicalPath.isEmpty();
+    entry.localPath = QDir::toNativeSeparators(entry.exists ? canonicalPath : entry.localPath);
+
+    if (!handles.contains(entry.handle))
+    {
+        handles.insert(entry.handle, syncs.size());
+    }
+    syncs.append(entry);
+}
+
+int SyncRegistry::size() const
+{
+    return syncs.size();
+}
+
+const SyncEntry &SyncRegistry::at(int num) const
+{
+    return syncs.at(num);
+}
+
+int SyncRegistry::indexOfHandle(MegaHandle handle) const
+{
+    return handles.value(handle, -1);
+}
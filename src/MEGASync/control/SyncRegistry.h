@@ -0,0 +1,45 @@
+#ifndef SYNCREGISTRY_H
+#define SYNCREGISTRY_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+
+#include "megaapi.h"
+
+struct SyncEntry
+{
+    QString name;
+    QString syncID;
+    // Canonical path with native separators, or the stored path if it doesn't exist
+    QString localPath;
+    bool exists;
+    QString megaPath;
+    mega::MegaHandle handle;
+    bool active;
+    bool temporaryInactive;
+};
+
+// In-memory view of the synced folders. It is built once each time the syncs
+// change and never modified later, so it can be shared between threads.
+// Lookups by handle don't touch the filesystem.
+class SyncRegistry
+{
+public:
+    SyncRegistry();
+
+    // The local path of the entry is canonicalized here
+    void addSync(SyncEntry entry);
+
+    int size() const;
+    const SyncEntry &at(int num) const;
+
+    // Index of the sync with that remote handle, or -1
+    int indexOfHandle(mega::MegaHandle handle) const;
+
+private:
+    QList<SyncEntry> syncs;
+    QHash<mega::MegaHandle, int> handles;
+};
+
+#endif // SYNCREGISTRY_H
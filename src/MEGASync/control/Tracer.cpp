@@ -0,0 +1,186 @@
+#include "Tracer.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+
+const int Tracer::MAX_EVENTS = 16384;
+
+QElapsedTimer Tracer::clock;
+QMutex Tracer::buffersMutex;
+QList<Tracer::Buffer *> Tracer::buffers;
+QList<QString> Tracer::threadNames;
+QThreadStorage<Tracer::BufferRef *> Tracer::threadBuffers;
+
+// Owned by the thread storage, it releases the buffer when the thread finishes
+class Tracer::BufferRef
+{
+public:
+    BufferRef(Buffer *buffer) : buffer(buffer) {}
+
+    ~BufferRef()
+    {
+        QMutexLocker locker(&Tracer::buffersMutex);
+        buffer->inUse = false;
+    }
+
+    Buffer *buffer;
+};
+
+void Tracer::initialize()
+{
+    if (!clock.isValid())
+    {
+        clock.start();
+    }
+}
+
+qint64 Tracer::now()
+{
+    return clock.nsecsElapsed();
+}
+
+void Tracer::addSpan(const char *name, qint64 start, qint64 end)
+{
+    if (!clock.isValid())
+    {
+        return;
+    }
+
+    Buffer *buffer = threadBuffer();
+    Event event;
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    event.tid = buffer->tid;
+
+    // Only contended while the trace is being saved
+    buffer->mutex.lock();
+    if (buffer->events.size() < MAX_EVENTS)
+    {
+        buffer->events.append(event);
+    }
+    else
+    {
+        buffer->events[buffer->next] = event;
+        buffer->next = (buffer->next + 1) % MAX_EVENTS;
+    }
+    buffer->mutex.unlock();
+}
+
+bool Tracer::save(const QString &path)
+{
+    buffersMutex.lock();
+    QList<Buffer *> currentBuffers = buffers;
+    QList<QString> names = threadNames;
+    buffersMutex.unlock();
+
+    // Events are implicitly shared, threads only copy them when they record the next span
+    QList<QVector<Event> > events;
+    for (int i = 0; i < currentBuffers.size(); i++)
+    {
+        Buffer *buffer = currentBuffers.at(i);
+        buffer->mutex.lock();
+        events.append(buffer->events);
+        buffer->mutex.unlock();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray data("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    bool success = true;
+    for (int i = 0; i < names.size(); i++)
+    {
+        QByteArray name = names.at(i).toUtf8();
+        name.replace('\\', "\\\\").replace('"', "\\\"");
+        data.append(first ? "\n" : ",\n");
+        data.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid)
+            .append(",\"tid\":").append(QByteArray::number(i))
+            .append(",\"args\":{\"name\":\"").append(name).append("\"}}");
+        first = false;
+    }
+
+    for (int i = 0; i < events.size() && success; i++)
+    {
+        const QVector<Event> &bufferEvents = events.at(i);
+        for (int j = 0; j < bufferEvents.size(); j++)
+        {
+            // Timestamps are in microseconds
+            const Event &event = bufferEvents.at(j);
+            data.append(first ? "\n" : ",\n");
+            data.append("{\"name\":\"").append(event.name)
+                .append("\",\"cat\":\"MEGAsync\",\"ph\":\"X\",\"pid\":").append(pid)
+                .append(",\"tid\":").append(QByteArray::number(event.tid))
+                .append(",\"ts\":").append(QByteArray::number(event.start / 1000.0, 'f', 3))
+                .append(",\"dur\":").append(QByteArray::number(event.duration / 1000.0, 'f', 3))
+                .append('}');
+            first = false;
+
+            if (data.size() >= 65536)
+            {
+                success = file.write(data) == data.size();
+                data.clear();
+                if (!success)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    data.append("\n]}\n");
+    success = success && file.write(data) == data.size();
+    file.close();
+    if (!success)
+    {
+        QFile::remove(path);
+    }
+    return success;
+}
+
+Tracer::Buffer *Tracer::threadBuffer()
+{
+    BufferRef *ref = threadBuffers.localData();
+    if (ref)
+    {
+        return ref->buffer;
+    }
+
+    QMutexLocker locker(&buffersMutex);
+    Buffer *buffer = NULL;
+    for (int i = 0; i < buffers.size(); i++)
+    {
+        if (!buffers.at(i)->inUse)
+        {
+            buffer = buffers.at(i);
+            break;
+        }
+    }
+
+    if (!buffer)
+    {
+        buffer = new Buffer();
+        buffer->next = 0;
+        buffers.append(buffer);
+    }
+    buffer->inUse = true;
+    buffer->tid = threadNames.size();
+
+    QThread *thread = QThread::currentThread();
+    QString name = thread->objectName();
+    if (name.isEmpty())
+    {
+        name = (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+                ? QString::fromUtf8("Main thread")
+                : QString::fromUtf8("Thread %1").arg(buffer->tid);
+    }
+    threadNames.append(name);
+
+    threadBuffers.setLocalData(new BufferRef(buffer));
+    return buffer;
+}
@@ -0,0 +1,85 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QThreadStorage>
+
+// Spans of time spent in hot paths. Each thread records them in its own buffer,
+// that keeps the latest MAX_EVENTS spans, using a monotonic clock.
+// They are saved in the Chrome trace format (chrome://tracing, Perfetto).
+// The TRACE_SPAN macros are empty in builds without ENABLE_TRACING
+class Tracer
+{
+public:
+    // Starts the clock, it must be called before recording spans
+    static void initialize();
+    static qint64 now();
+    static void addSpan(const char *name, qint64 start, qint64 end);
+    static bool save(const QString &path);
+
+    static const int MAX_EVENTS;
+
+protected:
+    struct Event
+    {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        int tid;
+    };
+
+    // Buffers are reused by new threads when their threads finish
+    struct Buffer
+    {
+        QMutex mutex;
+        QVector<Event> events;
+        int next;
+        int tid;
+        bool inUse;
+    };
+
+    class BufferRef;
+
+    static Buffer *threadBuffer();
+
+    static QElapsedTimer clock;
+    static QMutex buffersMutex;
+    static QList<Buffer *> buffers;
+    static QList<QString> threadNames;
+    static QThreadStorage<BufferRef *> threadBuffers;
+};
+
+// Records the time from its creation to its destruction.
+// The name must be a string literal
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+    {
+        this->name = name;
+        start = Tracer::now();
+    }
+
+    ~TraceSpan()
+    {
+        Tracer::addSpan(name, start, Tracer::now());
+    }
+
+private:
+    const char *name;
+    qint64 start;
+};
+
+#ifdef ENABLE_TRACING
+    #define TRACE_SPAN_CONCAT2(a, b) a##b
+    #define TRACE_SPAN_CONCAT(a, b) TRACE_SPAN_CONCAT2(a, b)
+    #define TRACE_SPAN(name) TraceSpan TRACE_SPAN_CONCAT(traceSpan, __LINE__)(name)
+#else
+    #define TRACE_SPAN(name)
+#endif
+
+#endif // TRACER_H
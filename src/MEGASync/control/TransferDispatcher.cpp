@@ -0,0 +1,139 @@
+#include "TransferDispatcher.h"
+
+using namespace mega;
+
+const int TransferDispatcher::DEFAULT_INTERVAL_MS = 200;
+
+TransferDispatcher::TransferDispatcher(MegaApi *megaApi, MegaTransferListener *listener, int intervalMs, QObject *parent)
+    : QObject(parent)
+{
+    this->megaApi = megaApi;
+    this->listener = listener;
+    this->flushing = false;
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(intervalMs);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+TransferDispatcher::~TransferDispatcher()
+{
+    clear();
+}
+
+void TransferDispatcher::onTransferStart(MegaTransfer *transfer)
+{
+    enqueue(EVENT_START, transfer, NULL);
+}
+
+void TransferDispatcher::onTransferUpdate(MegaTransfer *transfer)
+{
+    enqueue(EVENT_UPDATE, transfer, NULL);
+}
+
+void TransferDispatcher::onTransferFinish(MegaTransfer *transfer, MegaError *e)
+{
+    enqueue(EVENT_FINISH, transfer, e);
+}
+
+void TransferDispatcher::clear()
+{
+    flushTimer->stop();
+    for (int i = 0; i < pendingEvents.size(); i++)
+    {
+        delete pendingEvents[i].transfer;
+        delete pendingEvents[i].error;
+    }
+    pendingEvents.clear();
+    pendingUpdates.clear();
+}
+
+void TransferDispatcher::enqueue(int type, MegaTransfer *transfer, MegaError *e)
+{
+    int tag = transfer->getTag();
+    if (type == EVENT_UPDATE)
+    {
+        QHash<int, int>::iterator it = pendingUpdates.find(tag);
+        if (it != pendingUpdates.end())
+        {
+            // Keep the position of the first update, but with the latest state
+            PendingEvent &event = pendingEvents[it.value()];
+            delete event.transfer;
+            event.transfer = transfer->copy();
+            return;
+        }
+    }
+
+    PendingEvent event;
+    event.type = type;
+    event.transfer = transfer->copy();
+    event.error = e ? e->copy() : NULL;
+    pendingEvents.append(event);
+
+    if (type == EVENT_UPDATE)
+    {
+        pendingUpdates.insert(tag, pendingEvents.size() - 1);
+    }
+    else
+    {
+        // Later updates must be delivered after this event
+        pendingUpdates.remove(tag);
+    }
+
+    if (!flushTimer->isActive() && !flushing)
+    {
+        flushTimer->start();
+    }
+}
+
+void TransferDispatcher::flush()
+{
+    if (flushing)
+    {
+        return;
+    }
+
+    flushTimer->stop();
+    if (pendingEvents.isEmpty())
+    {
+        return;
+    }
+
+    // Listeners can process events, so new callbacks go to a fresh batch
+    QList<PendingEvent> events;
+    events.swap(pendingEvents);
+    pendingUpdates.clear();
+
+    flushing = true;
+    for (int i = 0; i < events.size(); i++)
+    {
+        PendingEvent &event = events[i];
+        if (listener)
+        {
+            switch (event.type)
+            {
+                case EVENT_START:
+                    listener->onTransferStart(megaApi, event.transfer);
+                    break;
+                case EVENT_UPDATE:
+                    listener->onTransferUpdate(megaApi, event.transfer);
+                    break;
+                case EVENT_FINISH:
+                    listener->onTransferFinish(megaApi, event.transfer, event.error);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        delete event.transfer;
+        delete event.error;
+    }
+    flushing = false;
+
+    if (!pendingEvents.isEmpty())
+    {
+        flushTimer->start();
+    }
+}
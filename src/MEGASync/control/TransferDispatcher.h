@@ -0,0 +1,59 @@
+#ifndef TRANSFERDISPATCHER_H
+#define TRANSFERDISPATCHER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include "megaapi.h"
+
+// Collapses transfer callbacks from the SDK and delivers them to a listener
+// on a fixed tick. Only the latest update for each transfer tag survives
+// between ticks, while start and finish events keep their relative order.
+class TransferDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TransferDispatcher(mega::MegaApi *megaApi, mega::MegaTransferListener *listener,
+                                int intervalMs = DEFAULT_INTERVAL_MS, QObject *parent = 0);
+    virtual ~TransferDispatcher();
+
+    void onTransferStart(mega::MegaTransfer *transfer);
+    void onTransferUpdate(mega::MegaTransfer *transfer);
+    void onTransferFinish(mega::MegaTransfer *transfer, mega::MegaError *e);
+
+    void clear();
+
+    static const int DEFAULT_INTERVAL_MS;
+
+public slots:
+    void flush();
+
+protected:
+    enum {
+        EVENT_START = 0,
+        EVENT_UPDATE,
+        EVENT_FINISH
+    };
+
+    struct PendingEvent
+    {
+        int type;
+        mega::MegaTransfer *transfer;
+        mega::MegaError *error;
+    };
+
+    void enqueue(int type, mega::MegaTransfer *transfer, mega::MegaError *e);
+
+    mega::MegaApi *megaApi;
+    mega::MegaTransferListener *listener;
+    QTimer *flushTimer;
+    QList<PendingEvent> pendingEvents;
+
+    // Position in pendingEvents of the update that can still absorb newer updates
+    QHash<int, int> pendingUpdates;
+    bool flushing;
+};
+
+#endif // TRANSFERDISPATCHER_H
@@ -11,7 +11,6 @@
 
 #ifndef WIN32
 #include "megaapi.h"
-#include <utime.h>
 #endif
 
 using namespace std;
@@ -283,57 +282,6 @@ bool Utilities::removeRecursively(QString path)
     return success;
 }
 
-void Utilities::copyRecursively(QString srcPath, QString dstPath)
-{
-    if (!srcPath.size() || !dstPath.size())
-    {
-        return;
-    }
-
-    QFileInfo source(srcPath);
-    if (!source.exists())
-    {
-        return;
-    }
-
-    if (srcPath == dstPath)
-    {
-        return;
-    }
-
-    QFile dst(dstPath);
-    if (dst.exists())
-    {
-        return;
-    }
-
-    if (source.isFile())
-    {
-        QFile src(srcPath);
-        src.copy(dstPath);
-#ifndef _WIN32
-       QFileInfo info(src);
-       time_t t = info.lastModified().toTime_t();
-       struct utimbuf times = { t, t };
-       utime(dstPath.toUtf8().constData(), &times);
-#endif
-    }
-    else if (source.isDir())
-    {
-        QDir dstDir(dstPath);
-        dstDir.mkpath(QString::fromAscii("."));
-        QDirIterator di(srcPath, QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
-        while (di.hasNext())
-        {
-            di.next();
-            if (!di.fileInfo().isSymLink())
-            {
-                copyRecursively(di.filePath(), dstPath + QDir::separator() + di.fileName());
-            }
-        }
-    }
-}
-
 bool Utilities::verifySyncedFolderLimits(QString path)
 {
 #ifdef WIN32
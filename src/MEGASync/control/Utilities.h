@@ -48,7 +48,6 @@ public:
     static QString getExtensionPixmapMedium(QString fileName);
     static QString getAvatarPath(QString email);
     static bool removeRecursively(QString path);
-    static void copyRecursively(QString srcPath, QString dstPath);
     static void getFolderSize(QString folderPath, long long *size);
     static qreal getDevicePixelRatio();
 };
@@ -14,7 +14,13 @@ SOURCES += $$PWD/HTTPServer.cpp \
     $$PWD/Utilities.cpp \
     $$PWD/MegaDownloader.cpp \
     $$PWD/MegaSyncLogger.cpp \
-    $$PWD/ConnectivityChecker.cpp
+    $$PWD/ConnectivityChecker.cpp \
+    $$PWD/TransferDispatcher.cpp \
+    $$PWD/LocalCopyEngine.cpp \
+    $$PWD/SyncRegistry.cpp \
+    $$PWD/NodeUpdateProcessor.cpp \
+    $$PWD/Tracer.cpp \
+    $$PWD/JSONReader.cpp
 
 HEADERS  +=  $$PWD/HTTPServer.h \
     $$PWD/Preferences.h \
@@ -27,5 +33,11 @@ HEADERS  +=  $$PWD/HTTPServer.h \
     $$PWD/Utilities.h \
     $$PWD/MegaDownloader.h \
     $$PWD/MegaSyncLogger.h \
-    $$PWD/ConnectivityChecker.h
+    $$PWD/ConnectivityChecker.h \
+    $$PWD/TransferDispatcher.h \
+    $$PWD/LocalCopyEngine.h \
+    $$PWD/SyncRegistry.h \
+    $$PWD/NodeUpdateProcessor.h \
+    $$PWD/Tracer.h \
+    $$PWD/JSONReader.h
 
@@ -0,0 +1,141 @@
+#include "BulkTransferOperation.h"
+#include <QTimer>
+
+using namespace mega;
+
+const int BulkTransferOperation::CHUNK_SIZE = 500;
+const int BulkTransferOperation::PROGRESS_THRESHOLD = 1000;
+
+BulkTransferOperation::BulkTransferOperation(MegaApi *megaApi, int action, const QList<int> &tags, QWidget *progressParent)
+    : QObject()
+{
+    this->megaApi = megaApi;
+    this->action = action;
+    this->tags = tags;
+    this->progressParent = progressParent;
+    numIssued = 0;
+    numFinished = 0;
+    lastProgress = -1;
+    cancelled = false;
+    delegateListener = new QTMegaRequestListener(megaApi, this);
+}
+
+BulkTransferOperation::~BulkTransferOperation()
+{
+    delete delegateListener;
+    delete progressDialog;
+}
+
+void BulkTransferOperation::start()
+{
+    if (tags.size() >= PROGRESS_THRESHOLD)
+    {
+        progressDialog = new QProgressDialog(tr("Updating transfers..."), tr("Cancel"), 0, tags.size(), progressParent);
+        progressDialog->setMinimumDuration(500);
+        progressDialog->setAutoClose(false);
+        progressDialog->setAutoReset(false);
+        connect(progressDialog, SIGNAL(canceled()), this, SLOT(cancel()));
+    }
+
+    issueNextChunk();
+}
+
+void BulkTransferOperation::issueNextChunk()
+{
+    if (cancelled)
+    {
+        return;
+    }
+
+    int end = qMin(numIssued + CHUNK_SIZE, tags.size());
+    while (numIssued < end)
+    {
+        issueRequest(tags.at(numIssued));
+        numIssued++;
+    }
+
+    if (numIssued < tags.size())
+    {
+        QTimer::singleShot(0, this, SLOT(issueNextChunk()));
+    }
+    else
+    {
+        checkFinished();
+    }
+}
+
+void BulkTransferOperation::issueRequest(int tag)
+{
+    switch (action)
+    {
+        case ACTION_PAUSE:
+            megaApi->pauseTransferByTag(tag, true, delegateListener);
+            break;
+        case ACTION_RESUME:
+            megaApi->pauseTransferByTag(tag, false, delegateListener);
+            break;
+        case ACTION_MOVE_TO_TOP:
+            megaApi->moveTransferToFirstByTag(tag, delegateListener);
+            break;
+        case ACTION_MOVE_UP:
+            megaApi->moveTransferUpByTag(tag, delegateListener);
+            break;
+        case ACTION_MOVE_DOWN:
+            megaApi->moveTransferDownByTag(tag, delegateListener);
+            break;
+        case ACTION_MOVE_TO_BOTTOM:
+            megaApi->moveTransferToLastByTag(tag, delegateListener);
+            break;
+        case ACTION_CANCEL:
+            megaApi->cancelTransferByTag(tag, delegateListener);
+            break;
+    }
+}
+
+void BulkTransferOperation::onRequestFinish(MegaApi *, MegaRequest *, MegaError *)
+{
+    numFinished++;
+    updateProgress();
+    checkFinished();
+}
+
+void BulkTransferOperation::cancel()
+{
+    // Requests already issued can't be taken back, only the remaining ones are skipped
+    cancelled = true;
+    checkFinished();
+}
+
+void BulkTransferOperation::updateProgress()
+{
+    if (!progressDialog)
+    {
+        return;
+    }
+
+    // Only whole percents, the dialog repaints on every change
+    int progress = (long long)numFinished * 100 / tags.size();
+    if (progress != lastProgress)
+    {
+        lastProgress = progress;
+        progressDialog->setValue(numFinished);
+    }
+}
+
+void BulkTransferOperation::checkFinished()
+{
+    if (numFinished < numIssued || (!cancelled && numIssued < tags.size()))
+    {
+        return;
+    }
+
+    if (progressDialog)
+    {
+        // Closing the dialog would report it as cancelled
+        progressDialog->disconnect(this);
+        progressDialog->close();
+    }
+
+    emit finished();
+    deleteLater();
+}
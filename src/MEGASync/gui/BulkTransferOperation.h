@@ -0,0 +1,63 @@
+#ifndef BULKTRANSFEROPERATION_H
+#define BULKTRANSFEROPERATION_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QProgressDialog>
+#include "megaapi.h"
+#include "QTMegaRequestListener.h"
+
+// Applies one action to many transfers. Requests are issued in chunks from the
+// event loop and counted as they finish, so large selections don't block the
+// interface, and the ones that take a while show their progress.
+class BulkTransferOperation : public QObject, public mega::MegaRequestListener
+{
+    Q_OBJECT
+
+public:
+    enum {
+        ACTION_PAUSE = 0,
+        ACTION_RESUME,
+        ACTION_MOVE_TO_TOP,
+        ACTION_MOVE_UP,
+        ACTION_MOVE_DOWN,
+        ACTION_MOVE_TO_BOTTOM,
+        ACTION_CANCEL
+    };
+
+    // Tags are processed in the given order. The operation deletes itself once finished.
+    BulkTransferOperation(mega::MegaApi *megaApi, int action, const QList<int> &tags, QWidget *progressParent = 0);
+    virtual ~BulkTransferOperation();
+    void start();
+
+    virtual void onRequestFinish(mega::MegaApi *api, mega::MegaRequest *request, mega::MegaError *e);
+
+    static const int CHUNK_SIZE;
+    static const int PROGRESS_THRESHOLD;
+
+signals:
+    void finished();
+
+private slots:
+    void issueNextChunk();
+    void cancel();
+
+private:
+    void issueRequest(int tag);
+    void updateProgress();
+    void checkFinished();
+
+    mega::MegaApi *megaApi;
+    mega::QTMegaRequestListener *delegateListener;
+    int action;
+    QList<int> tags;
+    int numIssued;
+    int numFinished;
+    int lastProgress;
+    bool cancelled;
+    QPointer<QWidget> progressParent;
+    QPointer<QProgressDialog> progressDialog;
+};
+
+#endif // BULKTRANSFEROPERATION_H
@@ -4,6 +4,10 @@
 #include <QMouseEvent>
 #include <QMessageBox>
 #include <QToolTip>
+#include <QIcon>
+#include <QDateTime>
+#include <QFontMetrics>
+#include <climits>
 #include "control/Utilities.h"
 #include "Preferences.h"
 #include "gui/QMegaMessageBox.h"
@@ -14,10 +18,79 @@
 
 using namespace mega;
 
+const int MegaTransferDelegate::MAX_CACHED_LAYOUTS = 256;
+
+namespace {
+
+void setStaticText(QStaticText &text, const QString &value, const QFont &font)
+{
+    if (text.text() != value)
+    {
+        text.setText(value);
+        text.prepare(QTransform(), font);
+    }
+}
+
+}
+
 MegaTransferDelegate::MegaTransferDelegate(QTransfersModel *model, QObject *parent)
     : QStyledItemDelegate(parent)
 {
     this->model = model;
+    this->modelType = model->getModelType();
+    this->hoveredTag = 0;
+    this->layouts.setMaxCost(MAX_CACHED_LAYOUTS);
+
+    bool custom = modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS;
+    nameFont = QFont(QString::fromUtf8("Source Sans Pro"));
+    nameFont.setPixelSize(custom ? 13 : 16);
+    infoFont = QFont(QString::fromUtf8("Source Sans Pro"));
+    infoFont.setPixelSize(custom ? 12 : 13);
+    timeFont = QFont(QString::fromUtf8("Source Sans Pro"));
+    timeFont.setPixelSize(custom ? 12 : 10);
+
+    uploadIcon = loadPixmap(QString::fromUtf8(":/images/upload_item_ico.png"), 12);
+    downloadIcon = loadPixmap(QString::fromUtf8(":/images/download_item_ico.png"), 12);
+    uploadedIcon = loadPixmap(QString::fromUtf8(":/images/uploaded_item_ico.png"), 12);
+    downloadedIcon = loadPixmap(QString::fromUtf8(":/images/downloaded_item_ico.png"), 12);
+    completedIcon = loadPixmap(QString::fromUtf8(":/images/completed_item_ico.png"), 12);
+    failedIcon = loadPixmap(QString::fromUtf8(":/images/import_error_ico.png"), 12);
+    cancelIcon = loadPixmap(QString::fromUtf8(":/images/clear_item_ico.png"), 12);
+    cloudIcon = loadPixmap(QString::fromUtf8(":/images/cloud_item_ico.png"), 32);
+    syncIcon = loadPixmap(QString::fromUtf8(":/images/sync_item_ico.png"), 32);
+    clockIcon = loadPixmap(QString::fromUtf8(":/images/clock_ico.png"), 24);
+    linkIcon = loadPixmap(QString::fromUtf8(":/images/ico_item_link.png"), 24);
+    retryIcon = loadPixmap(QString::fromUtf8(":/images/ico_item_retry.png"), 24);
+
+    bool hdpi = Utilities::getDevicePixelRatio() >= 2;
+    uploadAnimation = new QMovie(hdpi ? QString::fromUtf8(":/images/uploading@2x.gif")
+                                      : QString::fromUtf8(":/images/uploading.gif"), QByteArray(), this);
+    downloadAnimation = new QMovie(hdpi ? QString::fromUtf8(":/images/downloading@2x.gif")
+                                        : QString::fromUtf8(":/images/downloading.gif"), QByteArray(), this);
+    syncAnimation = new QMovie(hdpi ? QString::fromUtf8(":/images/synching@2x.gif")
+                                    : QString::fromUtf8(":/images/synching.gif"), QByteArray(), this);
+    connect(uploadAnimation, SIGNAL(frameChanged(int)), this, SLOT(onAnimationFrame()));
+    connect(downloadAnimation, SIGNAL(frameChanged(int)), this, SLOT(onAnimationFrame()));
+    connect(syncAnimation, SIGNAL(frameChanged(int)), this, SLOT(onAnimationFrame()));
+
+    connect(this, SIGNAL(refreshTransfer(int)), model, SLOT(refreshTransferItem(int)));
+}
+
+MegaTransferDelegate::~MegaTransferDelegate()
+{
+}
+
+MegaTransferDelegate::RowLayout::RowLayout()
+{
+    revision = 0;
+    paused = false;
+    nameElided = false;
+    nameWidth = -1;
+    finishedTextExpiry = 0;
+    name.setTextFormat(Qt::PlainText);
+    status.setTextFormat(Qt::PlainText);
+    details.setTextFormat(Qt::RichText);
+    remaining.setTextFormat(Qt::RichText);
 }
 
 void MegaTransferDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -29,112 +102,21 @@ void MegaTransferDelegate::paint(QPainter *painter, const QStyleOptionViewItem &
             painter->fillRect(option.rect, QColor(247, 247, 247));
         }
 
-        int tag = index.internalId();
-        int modelType = model->getModelType();
-        TransferItem *ti = model->transferItems[tag];
-        if (!ti)
+        TransferRowData *row = model->getTransferRowData(index.internalId());
+        if (!row)
         {
-            if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
-            {
-                ti = new CustomTransferItem();
-            }
-            else
-            {
-                ti = new TransferManagerItem();
-            }
-
-            ti->setTransferTag(tag);
-            connect(ti, SIGNAL(refreshTransfer(int)), model, SLOT(refreshTransferItem(int)));
-            model->transferItems.insert(tag, ti);
-            MegaTransfer *transfer = model->getTransferByTag(tag);
-
-            if (transfer)
-            {
-                ti->setType(transfer->getType(), transfer->isSyncTransfer());
-                ti->setFileName(QString::fromUtf8(transfer->getFileName()));
-                ti->setTotalSize(transfer->getTotalBytes());
-                ti->setSpeed(transfer->getSpeed(), transfer->getMeanSpeed());
-                ti->setTransferredBytes(transfer->getTransferredBytes(), !transfer->isSyncTransfer());           
-                ti->setPriority(transfer->getPriority());
-
-                int tError = transfer->getLastError().getErrorCode();
-                if (tError != MegaError::API_OK)
-                {
-                    ti->setTransferError(tError);
-                }
-
-                ti->setTransferState(transfer->getState());
-
-                if (ti->isTransferFinished())
-                {
-                    ti->setFinishedTime(transfer->getUpdateTime());
-                    ti->updateFinishedTime();
-                }
-
-                delete transfer;
-            }            
-        }
-        else
-        {
-            if (!ti->isTransferFinished())
-            {
-                ti->updateTransfer();
-            }
-            else
-            {
-                ti->updateFinishedTime();
-            }
+            return;
         }
 
-        Preferences *preferences = Preferences::instance();
-        if (ti->getType() == MegaTransfer::TYPE_DOWNLOAD)
+        painter->save();
+        if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
         {
-            if (preferences->getDownloadsPaused())
-            {
-                if (modelType == QTransfersModel::TYPE_DOWNLOAD)
-                {
-                    ti->setStateLabel(tr("paused"));
-                    ti->loadDefaultTransferIcon();
-                }
-                else if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
-                {
-                    ti->setStateLabel(tr("PAUSED"));
-                }
-            }
-            else
-            {
-                ti->updateAnimation();
-            }
+            paintCustomRow(painter, option.rect, *row);
         }
-        else if (ti->getType() == MegaTransfer::TYPE_UPLOAD)
-        {
-            if (preferences->getUploadsPaused())
-            {
-               if (modelType == QTransfersModel::TYPE_UPLOAD)
-               {
-                   ti->setStateLabel(tr("paused"));
-                   ti->loadDefaultTransferIcon();
-               }
-               else if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
-               {
-                   ti->setStateLabel(tr("PAUSED"));
-               }
-            }
-            else
-            {
-                ti->updateAnimation();
-            }
-        }
-
-        painter->save();
-        painter->translate(option.rect.topLeft());
-
-        if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS) //If custom transfer model, we should adjust width in case of vertical scrollbar is shown
+        else
         {
-            ti->resize(option.rect.width(), option.rect.height());
+            paintManagerRow(painter, option.rect, *row);
         }
-
-        ti->render(painter, QPoint(0, 0), QRegion(0, 0, option.rect.width(), option.rect.height()));
         painter->restore();
     }
     else
@@ -147,7 +129,6 @@ QSize MegaTransferDelegate::sizeHint(const QStyleOptionViewItem &option, const Q
 {
     if (index.isValid())
     {
-        int modelType = model->getModelType();
         if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
         {
             return QSize(400, 60);
@@ -166,15 +147,16 @@ bool MegaTransferDelegate::editorEvent(QEvent *event, QAbstractItemModel *, cons
     if (QEvent::MouseButtonPress ==  event->type())
     {
         int tag = index.internalId();
-        TransferItem *item = model->transferItems[tag];
-        if (!item)
+        TransferRowData *row = model->getTransferRowData(tag);
+        if (!row)
         {
             return true;
         }
 
-        if (item->cancelButtonClicked(((QMouseEvent *)event)->pos() - option.rect.topLeft()))
+        QPoint pos = ((QMouseEvent *)event)->pos();
+        if (cancelButtonRect(option.rect, *row).contains(pos))
         {
-            if (model->getModelType() == QTransfersModel::TYPE_FINISHED)
+            if (modelType == QTransfersModel::TYPE_FINISHED)
             {
                 model->removeTransferByTag(tag);
             }
@@ -195,90 +177,40 @@ bool MegaTransferDelegate::editorEvent(QEvent *event, QAbstractItemModel *, cons
                 }
             }
         }
-        else if (item && item->getLinkButtonClicked(((QMouseEvent *)event)->pos() - option.rect.topLeft()))
+        else if (linkButtonRect(option.rect, *row).contains(pos))
         {
-            QList<MegaHandle> exportList;
-            QStringList linkList;
-
-            int modelType = model->getModelType();
-            if (modelType == QTransfersModel::TYPE_FINISHED
-                    || modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+            if (row->error >= 0)
             {
-                MegaTransfer *transfer = model->getTransferByTag(tag);
-                if (transfer)
+                QList<MegaHandle> exportList;
+                QStringList linkList;
+                if (!row->publicLink.isEmpty())
                 {
-                    if (!transfer->getLastError().getErrorCode())
-                    {
-                        MegaNode *node = transfer->getPublicMegaNode();
-                        if (!node || !node->isPublic())
-                        {
-                            exportList.push_back(transfer->getNodeHandle());
-                        }
-                        else
-                        {
-                            char *handle = node->getBase64Handle();
-                            char *key = node->getBase64Key();
-                            if (handle && key)
-                            {
-                                QString link = QString::fromUtf8("https://mega.nz/#!%1!%2")
-                                        .arg(QString::fromUtf8(handle)).arg(QString::fromUtf8(key));
-                                linkList.append(link);
-                            }
-                            delete [] handle;
-                            delete [] key;
-                        }
-                        delete node;
-
-                        if (exportList.size() || linkList.size())
-                        {
-                            ((MegaApplication*)qApp)->exportNodes(exportList, linkList);
-                        }
-                    }
-                    else
-                    {
-                        ((MegaApplication*)qApp)->getMegaApi()->retryTransfer(transfer);
-                    }
-
-                    delete transfer;
+                    linkList.append(row->publicLink);
                 }
-             }
-        }
-        else if (model->getModelType() == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
-        {
-            MegaTransfer *transfer = NULL;
-            transfer = model->getTransferByTag(tag);
-            if (transfer && transfer->isFinished() && transfer->getPath())
-            {
-                QString localPath = QString::fromUtf8(transfer->getPath());
-                #ifdef WIN32
-                if (localPath.startsWith(QString::fromAscii("\\\\?\\")))
+                else
                 {
-                    localPath = localPath.mid(4);
+                    exportList.push_back(row->nodeHandle);
                 }
-                #endif
-                Platform::showInFolder(localPath);
+                ((MegaApplication*)qApp)->exportNodes(exportList, linkList);
+            }
+            else
+            {
+                model->retryTransfer(tag);
             }
-            delete transfer;
+        }
+        else if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+        {
+            showInFolder(*row);
         }
         return true;
     }
-    else if (QEvent::MouseButtonDblClick == event->type() && model->getModelType() == QTransfersModel::TYPE_FINISHED)
+    else if (QEvent::MouseButtonDblClick == event->type() && modelType == QTransfersModel::TYPE_FINISHED)
     {
-        MegaTransfer *transfer = NULL;
-        int tag = index.internalId();
-        transfer = model->getTransferByTag(tag);
-        if (transfer && transfer->isFinished() && transfer->getPath())
+        TransferRowData *row = model->getTransferRowData(index.internalId());
+        if (row)
         {
-            QString localPath = QString::fromUtf8(transfer->getPath());
-            #ifdef WIN32
-            if (localPath.startsWith(QString::fromAscii("\\\\?\\")))
-            {
-                localPath = localPath.mid(4);
-            }
-            #endif
-            Platform::showInFolder(localPath);
+            showInFolder(*row);
         }
-        delete transfer;
         return true;
     }
 
@@ -289,39 +221,538 @@ bool MegaTransferDelegate::helpEvent(QHelpEvent *event, QAbstractItemView *view,
 {
     if (event->type() == QEvent::ToolTip)
     {
-        int tag = index.internalId();
-        TransferItem *item = model->transferItems[tag];
-        if (item)
+        TransferRowData *row = model->getTransferRowData(index.internalId());
+        if (row)
         {
-            if (item->getLinkButtonClicked(event->pos() - option.rect.topLeft()))
+            if (linkButtonRect(option.rect, *row).contains(event->pos()))
             {
-                int modelType = model->getModelType();
-                if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+                if (row->error >= 0)
+                {
+                    QToolTip::showText(event->globalPos(), tr("Get link"));
+                }
+                else
                 {
-                    MegaTransfer *transfer = model->getTransferByTag(tag);
-                    if (transfer)
-                    {
-                        if (!transfer->getLastError().getErrorCode())
-                        {
-                            QToolTip::showText(event->globalPos(), tr("Get link"));
-                        }
-                        else
-                        {
-                            QToolTip::showText(event->globalPos(), tr("Retry"));
-                        }
-                        delete transfer;
-                        return true;
-                    }
+                    QToolTip::showText(event->globalPos(), tr("Retry"));
                 }
+                return true;
             }
 
-            QString fileName = item->getFileName();
-            if (fileName != item->getTransferName())
+            RowLayout *layout = layouts.object(row->tag);
+            if (layout && layout->nameElided)
             {
-                QToolTip::showText(event->globalPos(), fileName);
+                QToolTip::showText(event->globalPos(), row->fileName);
                 return true;
             }
         }
     }
     return QStyledItemDelegate::helpEvent(event, view, option, index);
 }
+
+void MegaTransferDelegate::setHoveredTag(int tag)
+{
+    if (tag == hoveredTag)
+    {
+        return;
+    }
+
+    int previousTag = hoveredTag;
+    hoveredTag = tag;
+    if (previousTag)
+    {
+        emit refreshTransfer(previousTag);
+    }
+    if (tag)
+    {
+        emit refreshTransfer(tag);
+    }
+}
+
+void MegaTransferDelegate::onAnimationFrame()
+{
+    QMovie *animation = (QMovie *)sender();
+    QSet<int> &tags = animatedTags[animation];
+
+    QSet<int>::iterator it = tags.begin();
+    while (it != tags.end())
+    {
+        if (model->getRowByTag(*it) < 0)
+        {
+            it = tags.erase(it);
+            continue;
+        }
+
+        emit refreshTransfer(*it);
+        ++it;
+    }
+
+    if (tags.isEmpty())
+    {
+        animation->stop();
+    }
+}
+
+MegaTransferDelegate::RowLayout *MegaTransferDelegate::getLayout(const TransferRowData &row) const
+{
+    RowLayout *layout = layouts.object(row.tag);
+    if (!layout)
+    {
+        layout = new RowLayout();
+        layouts.insert(row.tag, layout);
+    }
+    return layout;
+}
+
+bool MegaTransferDelegate::isPaused(const TransferRowData &row) const
+{
+    if (modelType == QTransfersModel::TYPE_FINISHED || row.isFinished())
+    {
+        return false;
+    }
+
+    Preferences *preferences = Preferences::instance();
+    if (row.type == MegaTransfer::TYPE_DOWNLOAD)
+    {
+        return preferences->getDownloadsPaused();
+    }
+    else if (row.type == MegaTransfer::TYPE_UPLOAD)
+    {
+        return preferences->getUploadsPaused();
+    }
+    return false;
+}
+
+void MegaTransferDelegate::prepareLayout(const TransferRowData &row, RowLayout &layout, int width, bool paused) const
+{
+    bool textDirty = layout.revision != row.revision;
+    if (layout.paused != paused)
+    {
+        layout.paused = paused;
+        textDirty = true;
+    }
+
+    if (layout.nameWidth != width)
+    {
+        QFontMetrics fm(nameFont);
+        QString elidedName = fm.elidedText(row.fileName, Qt::ElideMiddle, width);
+        layout.nameElided = elidedName != row.fileName;
+        setStaticText(layout.name, elidedName, nameFont);
+        layout.fileIcon = getFileIcon(row.fileName);
+        layout.nameWidth = width;
+    }
+
+    if (textDirty)
+    {
+        if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+        {
+            prepareCustomText(row, layout);
+        }
+        else
+        {
+            prepareManagerText(row, layout);
+        }
+        layout.revision = row.revision;
+        layout.finishedTextExpiry = 0;
+    }
+
+    if (row.isFinished() && QDateTime::currentMSecsSinceEpoch() >= layout.finishedTextExpiry)
+    {
+        prepareFinishedText(row, layout);
+    }
+}
+
+void MegaTransferDelegate::prepareManagerText(const TransferRowData &row, RowLayout &layout) const
+{
+    if (row.isFinished())
+    {
+        setStaticText(layout.details, Utilities::getSizeString(row.totalSize), infoFont);
+        return;
+    }
+
+    QString status;
+    QString remainingTime;
+    switch (row.state)
+    {
+        case MegaTransfer::STATE_ACTIVE:
+        {
+            long long remainingBytes = row.totalSize - row.transferredBytes;
+            int totalRemainingSeconds = row.meanSpeed ? remainingBytes / row.meanSpeed : 0;
+            if (totalRemainingSeconds)
+            {
+                if (totalRemainingSeconds < 60)
+                {
+                    remainingTime = QString::fromUtf8("%1 <span style=\"color:#777777; text-decoration:none;\">m</span>").arg(QString::fromUtf8("&lt; 1"));
+                }
+                else
+                {
+                    remainingTime = Utilities::getTimeString(totalRemainingSeconds, false);
+                }
+            }
+
+            if (!row.transferredBytes)
+            {
+                status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "starting"));
+            }
+            else
+            {
+                status = QString::fromUtf8("(%1/s)").arg(Utilities::getSizeString(row.speed));
+            }
+            break;
+        }
+        case MegaTransfer::STATE_PAUSED:
+            status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "paused"));
+            break;
+        case MegaTransfer::STATE_QUEUED:
+            status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "queued"));
+            break;
+        case MegaTransfer::STATE_RETRYING:
+            if (row.error == MegaError::API_EOVERQUOTA)
+            {
+                status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "Out of storage space"));
+            }
+            else
+            {
+                status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "retrying"));
+            }
+            break;
+        case MegaTransfer::STATE_COMPLETING:
+            status = QString::fromUtf8("(%1)").arg(QCoreApplication::translate("TransferManagerItem", "completing"));
+            break;
+        default:
+            break;
+    }
+
+    if (layout.paused)
+    {
+        status = QString::fromUtf8("(%1)").arg(tr("paused"));
+        remainingTime = QString();
+    }
+
+    setStaticText(layout.status, status, infoFont);
+    setStaticText(layout.remaining, remainingTime, infoFont);
+    setStaticText(layout.details, QString::fromUtf8("%1%2").arg(!row.transferredBytes ? QString::fromUtf8("")
+                            : QString::fromUtf8("%1<span style=\"color:#777777; text-decoration:none;\">&nbsp;&nbsp;of&nbsp;&nbsp;</span>")
+                                    .arg(Utilities::getSizeString(row.transferredBytes)))
+                      .arg(Utilities::getSizeString(row.totalSize)), infoFont);
+}
+
+void MegaTransferDelegate::prepareCustomText(const TransferRowData &row, RowLayout &layout) const
+{
+    if (row.isFinished())
+    {
+        return;
+    }
+
+    QString formattedValue(QString::fromUtf8("<span style=\"color:#333333; text-decoration:none;\">&nbsp;%1&nbsp;</span>"));
+    QString nTransfersPattern(QCoreApplication::translate("CustomTransferItem", "%1 of %2"));
+    setStaticText(layout.details, nTransfersPattern.arg(formattedValue.arg(row.transferNumber))
+                                                .arg(formattedValue.arg(row.numTransfers)), infoFont);
+
+    QString status;
+    QString remainingTime;
+    switch (row.state)
+    {
+        case MegaTransfer::STATE_ACTIVE:
+        {
+            long long remainingBytes = row.totalSize - row.transferredBytes;
+            int totalRemainingSeconds = row.meanSpeed ? remainingBytes / row.meanSpeed : 0;
+            if (totalRemainingSeconds)
+            {
+                if (totalRemainingSeconds < 60)
+                {
+                    remainingTime = QString::fromUtf8("%1 <span style=\"color:#777777; text-decoration:none;\">m</span>").arg(QString::fromUtf8("&lt; 1"));
+                }
+                else
+                {
+                    remainingTime = Utilities::getTimeString(totalRemainingSeconds, false);
+                }
+            }
+
+            if (!row.transferredBytes)
+            {
+                status = QCoreApplication::translate("CustomTransferItem", "starting...");
+            }
+            else
+            {
+                status = QString::fromUtf8("(%1/s)").arg(Utilities::getSizeString(row.speed));
+            }
+            break;
+        }
+        case MegaTransfer::STATE_PAUSED:
+            status = QCoreApplication::translate("CustomTransferItem", "PAUSED");
+            break;
+        case MegaTransfer::STATE_QUEUED:
+            status = QCoreApplication::translate("CustomTransferItem", "queued");
+            break;
+        case MegaTransfer::STATE_RETRYING:
+            if (row.error == MegaError::API_EOVERQUOTA)
+            {
+                status = QCoreApplication::translate("CustomTransferItem", "Out of storage space");
+            }
+            else
+            {
+                status = QCoreApplication::translate("CustomTransferItem", "retrying...");
+            }
+            break;
+        case MegaTransfer::STATE_COMPLETING:
+            status = QCoreApplication::translate("CustomTransferItem", "completing...");
+            break;
+        default:
+            break;
+    }
+
+    if (layout.paused)
+    {
+        status = tr("PAUSED");
+        remainingTime = QString();
+    }
+
+    setStaticText(layout.status, status, infoFont);
+    setStaticText(layout.remaining, remainingTime, infoFont);
+}
+
+void MegaTransferDelegate::prepareFinishedText(const TransferRowData &row, RowLayout &layout) const
+{
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS && row.error < 0)
+    {
+        setStaticText(layout.remaining, QCoreApplication::translate("CustomTransferItem", "failed:") + QString::fromUtf8(" ")
+                      + QCoreApplication::translate("MegaError", MegaError::getErrorString(row.error)), timeFont);
+        layout.finishedTextExpiry = LLONG_MAX;
+        return;
+    }
+
+    if (!row.finishedTime)
+    {
+        setStaticText(layout.remaining, QString(), timeFont);
+        layout.finishedTextExpiry = LLONG_MAX;
+        return;
+    }
+
+    Preferences *preferences = Preferences::instance();
+    long long secs = (now / 100 - (preferences->getMsDiffTimeWithSDK() + row.finishedTime)) / 10;
+    QString finishedTime = Utilities::getFinishedTimeString(secs);
+    if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+    {
+        finishedTime = QCoreApplication::translate("CustomTransferItem", "Added [A]").replace(QString::fromUtf8("[A]"), finishedTime);
+    }
+    setStaticText(layout.remaining, finishedTime, timeFont);
+
+    // The text only changes every second during the first minute
+    layout.finishedTextExpiry = now + (secs < 60 ? 1000 : 30000);
+}
+
+void MegaTransferDelegate::paintManagerRow(QPainter *painter, const QRect &rect, const TransferRowData &row) const
+{
+    int x = rect.left();
+    int y = rect.top();
+    bool finished = row.isFinished();
+    bool paused = isPaused(row);
+    RowLayout &layout = *getLayout(row);
+    prepareLayout(row, layout, finished ? 375 : 298, paused);
+
+    const QPixmap &typeIcon = row.type == MegaTransfer::TYPE_UPLOAD ? uploadIcon : downloadIcon;
+    const QPixmap &actionIcon = row.isSyncTransfer ? syncIcon : cloudIcon;
+    QMovie *animation = getAnimation(row);
+    if (!finished)
+    {
+        painter->drawPixmap(QRect(x + 25, y + 12, 12, 12), typeIcon);
+        painter->drawPixmap(QRect(x + 39, y + 6, 24, 24), layout.fileIcon);
+        drawText(painter, layout.name, nameFont, QColor(0x33, 0x33, 0x33), x + 65, y + 18);
+        drawText(painter, layout.details, infoFont, QColor(0x33, 0x33, 0x33), x + 523, y + 18, true);
+        drawText(painter, layout.status, infoFont, QColor(0xaa, 0xaa, 0xaa), x + 633, y + 18, true);
+        drawProgress(painter, QRect(x + 25, y + 36, 608, 2), row);
+
+        if (animation && row.state == MegaTransfer::STATE_ACTIVE && !paused)
+        {
+            if (animation->state() != QMovie::Running)
+            {
+                animation->start();
+            }
+            painter->drawPixmap(QRect(x + 638, y + 8, 32, 32), animation->currentPixmap());
+            animatedTags[animation].insert(row.tag);
+        }
+        else
+        {
+            painter->drawPixmap(QRect(x + 638, y + 8, 32, 32), actionIcon);
+        }
+        drawText(painter, layout.remaining, infoFont, QColor(0x33, 0x33, 0x33), x + 672, y + 24);
+    }
+    else
+    {
+        painter->drawPixmap(QRect(x + 22, y + 18, 12, 12), typeIcon);
+        painter->drawPixmap(QRect(x + 34, y + 12, 24, 24), layout.fileIcon);
+        drawText(painter, layout.name, nameFont, QColor(0x33, 0x33, 0x33), x + 60, y + 24);
+        painter->drawPixmap(QRect(x + 461, y + 18, 12, 12), row.state == MegaTransfer::STATE_COMPLETED ? completedIcon : failedIcon);
+        drawText(painter, layout.details, infoFont, QColor(0x33, 0x33, 0x33), x + 482, y + 24);
+        painter->drawPixmap(QRect(x + 585, y + 8, 32, 32), actionIcon);
+        drawText(painter, layout.remaining, timeFont, QColor(0x33, 0x33, 0x33), x + 626, y + 24);
+    }
+
+    if (animation && (finished || row.state != MegaTransfer::STATE_ACTIVE || paused))
+    {
+        animatedTags[animation].remove(row.tag);
+    }
+
+    QRect cancelRect = cancelButtonRect(rect, row);
+    if (cancelRect.isValid())
+    {
+        painter->drawPixmap(cancelRect, cancelIcon);
+    }
+}
+
+void MegaTransferDelegate::paintCustomRow(QPainter *painter, const QRect &rect, const TransferRowData &row) const
+{
+    int x = rect.left();
+    int y = rect.top();
+    int width = rect.width();
+    bool finished = row.isFinished();
+    RowLayout &layout = *getLayout(row);
+    prepareLayout(row, layout, finished ? width - 108 : width - 185, isPaused(row));
+
+    painter->drawPixmap(QRect(x + 6, y + 6, 48, 48), layout.fileIcon);
+    if (!finished)
+    {
+        drawText(painter, layout.name, nameFont, QColor(0x33, 0x33, 0x33), x + 63, y + 16);
+        painter->drawPixmap(QRect(x + 63, y + 27, 12, 12), row.type == MegaTransfer::TYPE_UPLOAD ? uploadIcon : downloadIcon);
+        drawText(painter, layout.details, infoFont, QColor(0x66, 0x66, 0x66), x + 80, y + 33);
+        drawText(painter, layout.status, infoFont, QColor(0x66, 0x66, 0x66), x + 85 + layout.details.size().width(), y + 33);
+
+        if (!layout.remaining.text().isEmpty())
+        {
+            painter->drawPixmap(QRect(x + width - 113, y + 17, 24, 24), clockIcon);
+            drawText(painter, layout.remaining, infoFont, QColor(0x33, 0x33, 0x33), x + width - 80, y + 29);
+        }
+        drawProgress(painter, QRect(x, y + 58, width, 2), row);
+    }
+    else
+    {
+        drawText(painter, layout.name, nameFont, QColor(0x33, 0x33, 0x33), x + 63, y + 20);
+        painter->drawPixmap(QRect(x + 63, y + 33, 12, 12), row.type == MegaTransfer::TYPE_UPLOAD ? uploadedIcon : downloadedIcon);
+        drawText(painter, layout.remaining, timeFont, row.error < 0 ? QColor(0xF0, 0x37, 0x3A) : QColor(0x99, 0x99, 0x99), x + 83, y + 39);
+
+        QRect linkRect = linkButtonRect(rect, row);
+        if (linkRect.isValid())
+        {
+            painter->drawPixmap(linkRect, row.error < 0 ? retryIcon : linkIcon);
+        }
+    }
+}
+
+void MegaTransferDelegate::drawText(QPainter *painter, const QStaticText &text, const QFont &font, const QColor &color,
+                                    int x, int centerY, bool alignRight) const
+{
+    QSizeF size = text.size();
+    if (size.isEmpty())
+    {
+        return;
+    }
+
+    painter->setFont(font);
+    painter->setPen(color);
+    painter->drawStaticText(QPointF(alignRight ? x - size.width() : x, centerY - size.height() / 2), text);
+}
+
+void MegaTransferDelegate::drawProgress(QPainter *painter, const QRect &rect, const TransferRowData &row) const
+{
+    painter->fillRect(rect, QColor(0xec, 0xec, 0xec));
+
+    int permil = (row.totalSize > 0) ? ((1000 * row.transferredBytes) / row.totalSize) : 0;
+    int chunkWidth = (rect.width() * permil) / 1000;
+    if (chunkWidth > 0)
+    {
+        painter->fillRect(QRect(rect.left(), rect.top(), chunkWidth, rect.height()),
+                          row.type == MegaTransfer::TYPE_UPLOAD ? QColor(0x2b, 0xa6, 0xde) : QColor(0x31, 0xb5, 0x00));
+    }
+}
+
+QMovie *MegaTransferDelegate::getAnimation(const TransferRowData &row) const
+{
+    if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS)
+    {
+        return NULL;
+    }
+
+    if (row.isSyncTransfer)
+    {
+        return syncAnimation;
+    }
+
+    switch (row.type)
+    {
+        case MegaTransfer::TYPE_UPLOAD:
+            return uploadAnimation;
+        case MegaTransfer::TYPE_DOWNLOAD:
+            return downloadAnimation;
+        default:
+            return NULL;
+    }
+}
+
+QPixmap MegaTransferDelegate::getFileIcon(const QString &fileName) const
+{
+    bool custom = modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS;
+    QString path = custom ? Utilities::getExtensionPixmapMedium(fileName)
+                          : Utilities::getExtensionPixmapSmall(fileName);
+
+    QHash<QString, QPixmap>::const_iterator it = fileIcons.constFind(path);
+    if (it != fileIcons.constEnd())
+    {
+        return it.value();
+    }
+
+    QPixmap icon = loadPixmap(path, custom ? 48 : 24);
+    fileIcons.insert(path, icon);
+    return icon;
+}
+
+QPixmap MegaTransferDelegate::loadPixmap(QString path, int size) const
+{
+    return QIcon(path).pixmap(QSize(size, size));
+}
+
+QRect MegaTransferDelegate::cancelButtonRect(const QRect &rect, const TransferRowData &row) const
+{
+    if (modelType == QTransfersModel::TYPE_CUSTOM_TRANSFERS || row.tag != hoveredTag
+            || row.state == MegaTransfer::STATE_CANCELLED)
+    {
+        return QRect();
+    }
+
+    if (row.isFinished())
+    {
+        return QRect(rect.left() + 725, rect.top() + 18, 12, 12);
+    }
+
+    if (row.isSyncTransfer)
+    {
+        return QRect();
+    }
+    return QRect(rect.left() + 740, rect.top() + 18, 12, 12);
+}
+
+QRect MegaTransferDelegate::linkButtonRect(const QRect &rect, const TransferRowData &row) const
+{
+    if (modelType != QTransfersModel::TYPE_CUSTOM_TRANSFERS || row.tag != hoveredTag || !row.isFinished())
+    {
+        return QRect();
+    }
+
+    return QRect(rect.right() - 35, rect.top() + 18, 24, 24);
+}
+
+void MegaTransferDelegate::showInFolder(const TransferRowData &row)
+{
+    if (!row.isFinished() || row.path.isEmpty())
+    {
+        return;
+    }
+
+    QString localPath = row.path;
+    #ifdef WIN32
+    if (localPath.startsWith(QString::fromAscii("\\\\?\\")))
+    {
+        localPath = localPath.mid(4);
+    }
+    #endif
+    Platform::showInFolder(localPath);
+}
@@ -2,9 +2,14 @@
 #define MEGATRANSFERDELEGATE_H
 
 #include <QStyledItemDelegate>
-#include "TransferItem.h"
-#include "TransferManagerItem.h"
-#include "CustomTransferItem.h"
+#include <QFont>
+#include <QPixmap>
+#include <QMovie>
+#include <QHash>
+#include <QCache>
+#include <QStaticText>
+#include <QSet>
+#include "TransferRowData.h"
 #include "QTransfersModel.h"
 
 class MegaTransferDelegate : public QStyledItemDelegate
@@ -13,13 +18,86 @@ class MegaTransferDelegate : public QStyledItemDelegate
 
 public:
     MegaTransferDelegate(QTransfersModel *model, QObject *parent = 0);
+    virtual ~MegaTransferDelegate();
     void paint(QPainter *painter, const QStyleOptionViewItem &option,const QModelIndex &index) const;
     QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
     bool editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option, const QModelIndex &index);
     bool helpEvent(QHelpEvent *event, QAbstractItemView *view, const QStyleOptionViewItem &option, const QModelIndex &index);
+    void setHoveredTag(int tag);
+
+signals:
+    void refreshTransfer(int tag);
+
+private slots:
+    void onAnimationFrame();
 
 protected:
+    // Text and icons of a row laid out for painting, rebuilt when the row data changes
+    struct RowLayout
+    {
+        RowLayout();
+
+        unsigned int revision;
+        bool paused;
+        bool nameElided;
+        int nameWidth;
+        long long finishedTextExpiry;
+        QStaticText name;
+        QStaticText status;
+        QStaticText details;
+        QStaticText remaining;
+        QPixmap fileIcon;
+    };
+
+    RowLayout *getLayout(const TransferRowData &row) const;
+    bool isPaused(const TransferRowData &row) const;
+    void prepareLayout(const TransferRowData &row, RowLayout &layout, int width, bool paused) const;
+    void prepareManagerText(const TransferRowData &row, RowLayout &layout) const;
+    void prepareCustomText(const TransferRowData &row, RowLayout &layout) const;
+    void prepareFinishedText(const TransferRowData &row, RowLayout &layout) const;
+    void paintManagerRow(QPainter *painter, const QRect &rect, const TransferRowData &row) const;
+    void paintCustomRow(QPainter *painter, const QRect &rect, const TransferRowData &row) const;
+    void drawText(QPainter *painter, const QStaticText &text, const QFont &font, const QColor &color,
+                  int x, int centerY, bool alignRight = false) const;
+    void drawProgress(QPainter *painter, const QRect &rect, const TransferRowData &row) const;
+    QMovie *getAnimation(const TransferRowData &row) const;
+    QPixmap getFileIcon(const QString &fileName) const;
+    QPixmap loadPixmap(QString path, int size) const;
+    QRect cancelButtonRect(const QRect &rect, const TransferRowData &row) const;
+    QRect linkButtonRect(const QRect &rect, const TransferRowData &row) const;
+    void showInFolder(const TransferRowData &row);
+
+    static const int MAX_CACHED_LAYOUTS;
+
     QTransfersModel *model;
+    int modelType;
+    int hoveredTag;
+
+    QFont nameFont;
+    QFont infoFont;
+    QFont timeFont;
+
+    QPixmap uploadIcon;
+    QPixmap downloadIcon;
+    QPixmap uploadedIcon;
+    QPixmap downloadedIcon;
+    QPixmap completedIcon;
+    QPixmap failedIcon;
+    QPixmap cancelIcon;
+    QPixmap cloudIcon;
+    QPixmap syncIcon;
+    QPixmap clockIcon;
+    QPixmap linkIcon;
+    QPixmap retryIcon;
+
+    QMovie *uploadAnimation;
+    QMovie *downloadAnimation;
+    QMovie *syncAnimation;
+
+    // Rows drawn with each animation, refreshed on every frame of it
+    mutable QHash<QMovie *, QSet<int> > animatedTags;
+    mutable QHash<QString, QPixmap> fileIcons;
+    mutable QCache<int, RowLayout> layouts;
 };
 
 #endif // MEGATRANSFERDELEGATE_H
@@ -1,4 +1,6 @@
 #include "MegaTransferView.h"
+#include "MegaTransferDelegate.h"
+#include "BulkTransferOperation.h"
 #include "MegaApplication.h"
 #include "platform/Platform.h"
 #include "control/Utilities.h"
@@ -302,8 +304,8 @@ void MegaTransferView::customizeCompletedContextMenu(bool enableGetLink, bool en
 
 void MegaTransferView::mouseMoveEvent(QMouseEvent *event)
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
+    MegaTransferDelegate *delegate = qobject_cast<MegaTransferDelegate *>(itemDelegate());
+    if (delegate)
     {
         QModelIndex index = indexAt(event->pos());
         if (index.isValid())
@@ -311,39 +313,14 @@ void MegaTransferView::mouseMoveEvent(QMouseEvent *event)
             int tag = index.internalId();
             if (tag != lastItemHoveredTag)
             {
-                if (lastItemHoveredTag)
-                {
-                    TransferItem *lastItemHovered = model->transferItems[lastItemHoveredTag];
-                    if (lastItemHovered)
-                    {
-                        lastItemHovered->mouseHoverTransfer(false);
-                    }
-                }
-
-                TransferItem *item = model->transferItems[tag];
-                if (item)
-                {
-                    lastItemHoveredTag = item->getTransferTag();
-                    item->mouseHoverTransfer(true);
-                }
-                else
-                {
-                    lastItemHoveredTag = 0;
-                }
+                lastItemHoveredTag = tag;
+                delegate->setHoveredTag(tag);
             }
         }
-        else
+        else if (lastItemHoveredTag)
         {
-            if (lastItemHoveredTag)
-            {
-                TransferItem *lastItemHovered = model->transferItems[lastItemHoveredTag];
-                if (lastItemHovered)
-                {
-                    lastItemHovered->mouseHoverTransfer(false);
-                    update();
-                }
-                lastItemHoveredTag = 0;
-            }
+            lastItemHoveredTag = 0;
+            delegate->setHoveredTag(0);
         }
     }
     QTreeView::mouseMoveEvent(event);
@@ -365,19 +342,11 @@ void MegaTransferView::mouseReleaseEvent(QMouseEvent *event)
 
 void MegaTransferView::leaveEvent(QEvent *event)
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
+    MegaTransferDelegate *delegate = qobject_cast<MegaTransferDelegate *>(itemDelegate());
+    if (delegate && lastItemHoveredTag)
     {
-        if (lastItemHoveredTag)
-        {
-            TransferItem *lastItemHovered = model->transferItems[lastItemHoveredTag];
-            if (lastItemHovered)
-            {
-                lastItemHovered->mouseHoverTransfer(false);
-                update();
-            }
-            lastItemHoveredTag = 0;
-        }
+        lastItemHoveredTag = 0;
+        delegate->setHoveredTag(0);
     }
     QTreeView::leaveEvent(event);
 }
@@ -418,8 +387,8 @@ void MegaTransferView::onCustomContextMenu(const QPoint &point)
             transferTagSelected.append(indexes[i].internalId());
             if (!enablePause || !enableResume || !enableCancel)
             {
-                TransferItem *item = model->transferItems[indexes[i].internalId()];
-                if (!item)
+                TransferRowData *row = model->getTransferRowData(indexes[i].internalId());
+                if (!row)
                 {
                     enableResume = true;
                     enablePause = true;
@@ -427,12 +396,12 @@ void MegaTransferView::onCustomContextMenu(const QPoint &point)
                 }
                 else
                 {
-                    if (item->getRegular())
+                    if (row->regular)
                     {
                         enableCancel = true;
                     }
 
-                    if (item->getTransferState() == mega::MegaTransfer::STATE_PAUSED)
+                    if (row->state == mega::MegaTransfer::STATE_PAUSED)
                     {
                         enableResume = true;
                     }
@@ -450,24 +419,18 @@ void MegaTransferView::onCustomContextMenu(const QPoint &point)
             if (modelType == QTransfersModel::TYPE_FINISHED)
             {
                 bool failed = false;
-                MegaTransfer *transfer = NULL;
-                QTransfersModel *model = (QTransfersModel*)this->model();
-                if (model)
+                for (int i = 0; i < transferTagSelected.size(); i++)
                 {
-                    for (int i = 0; i < transferTagSelected.size(); i++)
+                    TransferRowData *row = model->getTransferRowData(transferTagSelected[i]);
+                    if (!row)
+                    {
+                        transferTagSelected.clear();
+                        return;
+                    }
+
+                    if (row->state == MegaTransfer::STATE_FAILED)
                     {
-                        transfer = model->getTransferByTag(transferTagSelected[i]);
-                        if (!transfer)
-                        {
-                            transferTagSelected.clear();
-                            return;
-                        }
-
-                        if (transfer->getState() == MegaTransfer::STATE_FAILED)
-                        {
-                            failed = true;
-                        }
-                        delete transfer;
+                        failed = true;
                     }
                 }
 
@@ -496,74 +459,44 @@ void MegaTransferView::onCustomContextMenu(const QPoint &point)
 
 void MegaTransferView::pauseTransferClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
-    {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->megaApi->pauseTransferByTag(transferTagSelected[i], true);
-        }
-    }
+    runBulkOperation(BulkTransferOperation::ACTION_PAUSE, transferTagSelected);
 }
 
 void MegaTransferView::resumeTransferClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
-    {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->megaApi->pauseTransferByTag(transferTagSelected[i], false);
-        }
-    }
+    runBulkOperation(BulkTransferOperation::ACTION_RESUME, transferTagSelected);
 }
 
 void MegaTransferView::moveToTopClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
+    QList<int> tags;
+    tags.reserve(transferTagSelected.size());
+    for (int i = transferTagSelected.size() - 1; i >= 0; i--)
     {
-        for (int i = transferTagSelected.size() - 1; i >= 0; i--)
-        {
-            model->megaApi->moveTransferToFirstByTag(transferTagSelected[i]);
-        }
+        tags.append(transferTagSelected[i]);
     }
+    runBulkOperation(BulkTransferOperation::ACTION_MOVE_TO_TOP, tags);
 }
 
 void MegaTransferView::moveUpClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
-    {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->megaApi->moveTransferUpByTag(transferTagSelected[i]);
-        }
-    }
+    runBulkOperation(BulkTransferOperation::ACTION_MOVE_UP, transferTagSelected);
 }
 
 void MegaTransferView::moveDownClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
+    QList<int> tags;
+    tags.reserve(transferTagSelected.size());
+    for (int i = transferTagSelected.size() - 1; i >= 0; i--)
     {
-        for (int i = transferTagSelected.size() - 1; i >= 0 ; i--)
-        {
-            model->megaApi->moveTransferDownByTag(transferTagSelected[i]);
-        }
+        tags.append(transferTagSelected[i]);
     }
+    runBulkOperation(BulkTransferOperation::ACTION_MOVE_DOWN, tags);
 }
 
 void MegaTransferView::moveToBottomClicked()
 {
-    QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
-    {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->megaApi->moveTransferToLastByTag(transferTagSelected[i]);
-        }
-    }
+    runBulkOperation(BulkTransferOperation::ACTION_MOVE_TO_BOTTOM, transferTagSelected);
 }
 
 void MegaTransferView::cancelTransferClicked()
@@ -579,12 +512,31 @@ void MegaTransferView::cancelTransferClicked()
     }
 
     QTransfersModel *model = (QTransfersModel*)this->model();
-    if (model)
+    if (!model)
     {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->megaApi->cancelTransferByTag(transferTagSelected[i]);
-        }
+        return;
+    }
+
+    // A whole queue is cancelled with a single request
+    int modelType = model->getModelType();
+    if ((modelType == QTransfersModel::TYPE_DOWNLOAD || modelType == QTransfersModel::TYPE_UPLOAD)
+            && !model->isFiltered() && transferTagSelected.size() == model->rowCount(QModelIndex()))
+    {
+        model->megaApi->cancelTransfers(modelType == QTransfersModel::TYPE_DOWNLOAD
+                                        ? MegaTransfer::TYPE_DOWNLOAD : MegaTransfer::TYPE_UPLOAD);
+        return;
+    }
+
+    runBulkOperation(BulkTransferOperation::ACTION_CANCEL, transferTagSelected);
+}
+
+void MegaTransferView::runBulkOperation(int action, const QList<int> &tags)
+{
+    QTransfersModel *model = (QTransfersModel*)this->model();
+    if (model && tags.size())
+    {
+        BulkTransferOperation *operation = new BulkTransferOperation(model->megaApi, action, tags, window());
+        operation->start();
     }
 }
 
@@ -595,7 +547,6 @@ void MegaTransferView::getLinkClicked()
         return;
     }
 
-    MegaTransfer *transfer = NULL;
     QTransfersModel *model = (QTransfersModel*)this->model();
     if (model)
     {
@@ -603,29 +554,17 @@ void MegaTransferView::getLinkClicked()
         QStringList linkList;
         for (int i = 0; i < transferTagSelected.size(); i++)
         {
-            transfer = model->getTransferByTag(transferTagSelected[i]);
-            if (transfer)
+            TransferRowData *row = model->getTransferRowData(transferTagSelected[i]);
+            if (row)
             {
-                MegaNode *node = transfer->getPublicMegaNode();
-                if (!node || !node->isPublic())
+                if (!row->publicLink.isEmpty())
                 {
-                    exportList.push_back(transfer->getNodeHandle());
+                    linkList.append(row->publicLink);
                 }
                 else
                 {
-                    char *handle = node->getBase64Handle();
-                    char *key = node->getBase64Key();
-                    if (handle && key)
-                    {
-                        QString link = QString::fromUtf8("https://mega.nz/#!%1!%2")
-                                .arg(QString::fromUtf8(handle)).arg(QString::fromUtf8(key));
-                        linkList.append(link);
-                    }
-                    delete [] handle;
-                    delete [] key;
+                    exportList.push_back(row->nodeHandle);
                 }
-                delete node;
-                delete transfer;
             }
         }
 
@@ -638,34 +577,31 @@ void MegaTransferView::getLinkClicked()
 
 void MegaTransferView::openItemClicked()
 {
-    MegaTransfer *transfer = NULL;
     QTransfersModel *model = (QTransfersModel*)this->model();
     if (model)
     {
         for (int i = 0; i < transferTagSelected.size(); i++)
         {
-            transfer = model->getTransferByTag(transferTagSelected[i]);
-            if (transfer && transfer->getPath())
+            TransferRowData *row = model->getTransferRowData(transferTagSelected[i]);
+            if (row && !row->path.isEmpty())
             {
-                QtConcurrent::run(QDesktopServices::openUrl, QUrl::fromLocalFile(QString::fromUtf8(transfer->getPath())));
+                QtConcurrent::run(QDesktopServices::openUrl, QUrl::fromLocalFile(row->path));
             }
-            delete transfer;
         }
     }
 }
 
 void MegaTransferView::showInFolderClicked()
 {
-    MegaTransfer *transfer = NULL;
     QTransfersModel *model = (QTransfersModel*)this->model();
     if (model)
     {
         for (int i = 0; i < transferTagSelected.size(); i++)
         {
-            transfer = model->getTransferByTag(transferTagSelected[i]);
-            if (transfer && transfer->getPath())
+            TransferRowData *row = model->getTransferRowData(transferTagSelected[i]);
+            if (row && !row->path.isEmpty())
             {
-                QString localPath = QString::fromUtf8(transfer->getPath());
+                QString localPath = row->path;
                 #ifdef WIN32
                 if (localPath.startsWith(QString::fromAscii("\\\\?\\")))
                 {
@@ -674,31 +610,24 @@ void MegaTransferView::showInFolderClicked()
                 #endif
                 Platform::showInFolder(localPath);
             }
-            delete transfer;
         }
     }
 }
 
 void MegaTransferView::showInMEGAClicked()
 {
-    MegaTransfer *transfer = NULL;
     QTransfersModel *model = (QTransfersModel*)this->model();
     if (model)
     {
         for (int i = 0; i < transferTagSelected.size(); i++)
         {
-            transfer = model->getTransferByTag(transferTagSelected[i]);
-            if (transfer)
+            TransferRowData *row = model->getTransferRowData(transferTagSelected[i]);
+            if (row && row->nodeHandle != INVALID_HANDLE)
             {
-                MegaHandle handle = transfer->getNodeHandle();
-                if (handle != INVALID_HANDLE)
-                {
-                    const char *b64handle = MegaApi::handleToBase64(handle);
-                    QString url = QString::fromAscii("https://mega.nz/fm/") + QString::fromUtf8(b64handle);
-                    QtConcurrent::run(QDesktopServices::openUrl, QUrl(url));
-                    delete [] b64handle;
-                }
-                delete transfer;
+                const char *b64handle = MegaApi::handleToBase64(row->nodeHandle);
+                QString url = QString::fromAscii("https://mega.nz/fm/") + QString::fromUtf8(b64handle);
+                QtConcurrent::run(QDesktopServices::openUrl, QUrl(url));
+                delete [] b64handle;
             }
         }
     }
@@ -709,10 +638,7 @@ void MegaTransferView::clearTransferClicked()
     QTransfersModel *model = (QTransfersModel*)this->model();
     if (model)
     {
-        for (int i = 0; i < transferTagSelected.size(); i++)
-        {
-            model->removeTransferByTag(transferTagSelected[i]);
-        }
+        model->removeTransfers(transferTagSelected);
     }
 }
 
@@ -4,7 +4,6 @@
 #include <QTreeView>
 #include <QMenu>
 #include <QMouseEvent>
-#include "TransferItem.h"
 #include "QTransfersModel.h"
 
 class MegaTransferView : public QTreeView
@@ -45,6 +44,7 @@ private:
     void createCompletedContextMenu();
     void customizeContextInProgressMenu(bool enablePause, bool enableResume, bool enableUpMoves, bool enableDownMoves, bool isCancellable);
     void customizeCompletedContextMenu(bool enableGetLink = true, bool enableOpen = true, bool enableShow = true, bool enableShowInMEGA = true);
+    void runBulkOperation(int action, const QList<int> &tags);
 
 protected:
     virtual void mouseMoveEvent(QMouseEvent *event);
@@ -1,43 +1,40 @@
 #include "QActiveTransfersModel.h"
 #include "MegaApplication.h"
 #include <assert.h>
+#include <algorithm>
 
 using namespace mega;
 
-bool priority_comparator(TransferItemData* i, TransferItemData *j)
-{
-    if (i->priority < j->priority)
-        return true;
-
-    if (i->priority > j->priority)
-        return false;
-
-    return i->tag < j->tag;
-}
+const int QActiveTransfersModel::MAX_REMOVED_RANGES = 32;
+const int QActiveTransfersModel::INDEX_CHUNK_SIZE = 1000;
 
 QActiveTransfersModel::QActiveTransfersModel(int type, MegaTransferData *transferData, QObject *parent) :
     QTransfersModel(type, parent)
 {
+    searchIndexed = false;
+
     if (!transferData)
     {
         return;
     }
 
-    TransferItemData *itemData = NULL;
+    bool duplicated = false;
     if (type == TYPE_DOWNLOAD)
     {
         int numDownloads = transferData->getNumDownloads();
         if (numDownloads)
         {
             beginInsertRows(QModelIndex(), 0, numDownloads - 1);
-            transferOrder.resize(numDownloads);
+            transfers.reserve(numDownloads);
             for (int i = 0; i < numDownloads; i++)
             {
-                itemData = new TransferItemData();
-                itemData->tag = transferData->getDownloadTag(i);
-                itemData->priority = transferData->getDownloadPriority(i);
-                transfers.insert(itemData->tag, itemData);
-                transferOrder[i] = itemData;
+                int tag = transferData->getDownloadTag(i);
+                if (transfers.contains(tag))
+                {
+                    duplicated = true;
+                    continue;
+                }
+                transfers.append(tag, transferData->getDownloadPriority(i));
             }
             endInsertRows();
         }
@@ -48,20 +45,22 @@ QActiveTransfersModel::QActiveTransfersModel(int type, MegaTransferData *transfe
         if (numUploads)
         {
             beginInsertRows(QModelIndex(), 0, numUploads - 1);
-            transferOrder.resize(numUploads);
+            transfers.reserve(numUploads);
             for (int i = 0; i < numUploads; i++)
             {
-                itemData = new TransferItemData();
-                itemData->tag = transferData->getUploadTag(i);
-                itemData->priority = transferData->getUploadPriority(i);
-                transfers.insert(itemData->tag, itemData);
-                transferOrder[i] = itemData;
+                int tag = transferData->getUploadTag(i);
+                if (transfers.contains(tag))
+                {
+                    duplicated = true;
+                    continue;
+                }
+                transfers.append(tag, transferData->getUploadPriority(i));
             }
             endInsertRows();
         }
     }
 
-    if (transferOrder.size() != transfers.size())
+    if (duplicated)
     {
         assert(false);
         megaApi->sendEvent(99513, QString::fromUtf8("Duplicated active transfer during initialization").toUtf8().constData());
@@ -70,26 +69,63 @@ QActiveTransfersModel::QActiveTransfersModel(int type, MegaTransferData *transfe
 
 void QActiveTransfersModel::removeTransferByTag(int transferTag)
 {
-    TransferItemData *item =  transfers.value(transferTag);
-    if (!item)
+    if (!transfers.contains(transferTag))
     {
         return;
     }
 
-    transfer_it it = std::lower_bound(transferOrder.begin(), transferOrder.end(), item, priority_comparator);
-    int row = std::distance(transferOrder.begin(), it);
-    assert(it != transferOrder.end() && (*it)->tag == transferTag);
-    if (it == transferOrder.end() || (*it)->tag != transferTag)
+    // Removals are applied in a single batch before the next refresh,
+    // so cancelling a large selection doesn't update the views per row
+    pendingRemovals.insert(transferTag);
+    pendingPriorities.remove(transferTag);
+    dirtyTags.remove(transferTag);
+    scheduleRefresh();
+}
+
+void QActiveTransfersModel::applyPendingRemovals()
+{
+    if (pendingRemovals.isEmpty())
     {
         return;
     }
 
-    beginRemoveRows(QModelIndex(), row, row);
-    transfers.remove(transferTag);
-    transferOrder.erase(it);
-    transferItems.remove(transferTag);
-    endRemoveRows();
-    delete item;
+    std::vector<int> rows;
+    std::vector<int> filteredRows;
+    rows.reserve(pendingRemovals.size());
+    for (QSet<int>::const_iterator it = pendingRemovals.constBegin(); it != pendingRemovals.constEnd(); ++it)
+    {
+        int tag = *it;
+        int row = transfers.rowOf(tag);
+        if (row >= 0)
+        {
+            rows.push_back(row);
+        }
+
+        if (isFiltered())
+        {
+            row = filteredTransfers.rowOf(tag);
+            if (row >= 0)
+            {
+                filteredRows.push_back(row);
+            }
+        }
+        transferRows.remove(tag);
+        searchIndex.remove(tag);
+    }
+    pendingRemovals.clear();
+    std::sort(rows.begin(), rows.end());
+
+    if (!isFiltered())
+    {
+        removeShownRows(transfers, rows);
+    }
+    else
+    {
+        // The full list isn't shown while filtering
+        transfers.removeRows(rows);
+        std::sort(filteredRows.begin(), filteredRows.end());
+        removeShownRows(filteredTransfers, filteredRows);
+    }
 
     if (transfers.isEmpty())
     {
@@ -97,6 +133,203 @@ void QActiveTransfersModel::removeTransferByTag(int transferTag)
     }
 }
 
+void QActiveTransfersModel::removeShownRows(TransferIndex &rows, const std::vector<int> &removedRows)
+{
+    QList<QPair<int, int> > ranges;
+    for (unsigned int i = 0; i < removedRows.size(); i++)
+    {
+        if (ranges.size() && ranges.last().second + 1 == removedRows[i])
+        {
+            ranges.last().second = removedRows[i];
+        }
+        else
+        {
+            ranges.append(qMakePair(removedRows[i], removedRows[i]));
+        }
+    }
+
+    if (ranges.size() > MAX_REMOVED_RANGES)
+    {
+        beginResetModel();
+        rows.removeRows(removedRows);
+        endResetModel();
+    }
+    else
+    {
+        // From the bottom, so the rows of the remaining ranges don't change
+        for (int i = ranges.size() - 1; i >= 0; i--)
+        {
+            beginRemoveRows(QModelIndex(), ranges.at(i).first, ranges.at(i).second);
+            rows.removeRange(ranges.at(i).first, ranges.at(i).second);
+            endRemoveRows();
+        }
+    }
+}
+
+bool QActiveTransfersModel::isFiltered() const
+{
+    return !filterText.isEmpty();
+}
+
+const TransferIndex &QActiveTransfersModel::shownTransfers() const
+{
+    return isFiltered() ? filteredTransfers : transfers;
+}
+
+QModelIndex QActiveTransfersModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent))
+    {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column, shownTransfers().tagAt(row));
+}
+
+int QActiveTransfersModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return shownTransfers().size();
+}
+
+void QActiveTransfersModel::setFilter(const QString &text)
+{
+    QString lowerText = text.trimmed().toLower();
+    if (lowerText == filterText)
+    {
+        return;
+    }
+
+    applyPendingChanges();
+    if (!lowerText.isEmpty())
+    {
+        indexAllRows();
+    }
+
+    TransferIndex matchingTransfers;
+    if (!lowerText.isEmpty())
+    {
+        if (isFiltered() && lowerText.contains(filterText))
+        {
+            // Typing more only narrows the current results, which are already sorted
+            for (int row = 0; row < filteredTransfers.size(); row++)
+            {
+                int tag = filteredTransfers.tagAt(row);
+                if (searchIndex.matches(tag, lowerText))
+                {
+                    matchingTransfers.append(tag, filteredTransfers.priorityAt(row));
+                }
+            }
+        }
+        else
+        {
+            QVector<int> tags = searchIndex.search(lowerText);
+            std::vector<int> rows;
+            rows.reserve(tags.size());
+            for (int i = 0; i < tags.size(); i++)
+            {
+                int row = transfers.rowOf(tags.at(i));
+                if (row >= 0)
+                {
+                    rows.push_back(row);
+                }
+            }
+
+            std::sort(rows.begin(), rows.end());
+            matchingTransfers.reserve(rows.size());
+            for (unsigned int i = 0; i < rows.size(); i++)
+            {
+                matchingTransfers.append(transfers.tagAt(rows[i]), transfers.priorityAt(rows[i]));
+            }
+        }
+    }
+
+    beginResetModel();
+    filterText = lowerText;
+    filteredTransfers = matchingTransfers;
+    endResetModel();
+}
+
+void QActiveTransfersModel::indexAllRows()
+{
+    if (searchIndexed)
+    {
+        return;
+    }
+    searchIndexed = true;
+
+    for (int row = 0; row < transfers.size(); row++)
+    {
+        int tag = transfers.tagAt(row);
+        QHash<int, TransferRowData>::const_iterator it = transferRows.constFind(tag);
+        if (it != transferRows.constEnd())
+        {
+            searchIndex.add(tag, it.value().fileName);
+        }
+        else
+        {
+            unindexedTags.append(tag);
+        }
+    }
+
+    if (!unindexedTags.isEmpty())
+    {
+        QTimer::singleShot(0, this, SLOT(indexNextChunk()));
+    }
+}
+
+void QActiveTransfersModel::indexNextChunk()
+{
+    // Names of the rows that existed before the model are loaded a chunk at a time
+    for (int i = 0; i < INDEX_CHUNK_SIZE && !unindexedTags.isEmpty(); i++)
+    {
+        int tag = unindexedTags.takeLast();
+        int row = transfers.rowOf(tag);
+        if (row < 0 || searchIndex.contains(tag))
+        {
+            continue;
+        }
+
+        if (!transferRows.contains(tag))
+        {
+            MegaTransfer *transfer = megaApi->getTransferByTag(tag);
+            if (!transfer)
+            {
+                continue;
+            }
+            updateTransferRowData(transfer);
+            delete transfer;
+        }
+
+        searchIndex.add(tag, transferRows.value(tag).fileName);
+        if (isFiltered())
+        {
+            insertIfMatching(tag, transfers.priorityAt(row));
+        }
+    }
+
+    if (!unindexedTags.isEmpty())
+    {
+        QTimer::singleShot(0, this, SLOT(indexNextChunk()));
+    }
+}
+
+void QActiveTransfersModel::insertIfMatching(int tag, unsigned long long priority)
+{
+    if (!searchIndex.matches(tag, filterText) || filteredTransfers.contains(tag))
+    {
+        return;
+    }
+
+    int row = filteredTransfers.lowerBound(priority, tag);
+    beginInsertRows(QModelIndex(), row, row);
+    filteredTransfers.insert(row, tag, priority);
+    endInsertRows();
+}
+
 void QActiveTransfersModel::removeAllTransfers()
 {
 }
@@ -139,28 +372,29 @@ bool QActiveTransfersModel::dropMimeData(const QMimeData *data, Qt::DropAction,
     QList<quintptr> selectedTags;
     stream >> selectedTags;
 
-    if (row < 0 || row > transferOrder.size() || !selectedTags.size())
+    applyPendingChanges();
+
+    const TransferIndex &rows = shownTransfers();
+    if (row < 0 || row > rows.size() || !selectedTags.size())
     {
         return false;
     }
 
-    TransferItemData *item = NULL;
-    if (row != transferOrder.size())
+    int targetTag = -1;
+    if (row != rows.size())
     {
-        item = transferOrder[row];
-        if (item->tag == selectedTags[0])
+        targetTag = rows.tagAt(row);
+        if (targetTag == (int)selectedTags[0])
         {
             return false;
         }
 
-        TransferItemData* itemData = transfers.value(selectedTags[0]);
-        if (!itemData)
+        int srcrow = rows.rowOf(selectedTags[0]);
+        if (srcrow < 0)
         {
             return false;
         }
 
-        std::deque<TransferItemData*>::iterator srcit = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-        int srcrow = std::distance(transferOrder.begin(), srcit);
         if (srcrow + selectedTags.size() == row)
         {
             return false;
@@ -169,9 +403,9 @@ bool QActiveTransfersModel::dropMimeData(const QMimeData *data, Qt::DropAction,
 
     for (int i = 0; i< selectedTags.size(); i++)
     {
-        if (item)
+        if (targetTag != -1)
         {
-            megaApi->moveTransferBeforeByTag(selectedTags[i], item->tag);
+            megaApi->moveTransferBeforeByTag(selectedTags[i], targetTag);
         }
         else
         {
@@ -190,26 +424,39 @@ void QActiveTransfersModel::onTransferStart(MegaApi *, MegaTransfer *transfer)
 {
     if (transfer->getType() == type)
     {
-        TransferItemData *item = new TransferItemData();
-        item->tag = transfer->getTag();
-        item->priority = transfer->getPriority();
+        applyPendingChanges();
 
-        transfer_it it = std::lower_bound(transferOrder.begin(), transferOrder.end(), item, priority_comparator);
-        int row = std::distance(transferOrder.begin(), it);
-        if (transfers.count(item->tag))
+        int tag = transfer->getTag();
+        if (transfers.contains(tag))
         {
             assert(false);
-            megaApi->sendEvent(99514, QString::fromUtf8("Duplicated active transfer during insertion: %1").arg(QString::number(item->tag)).toUtf8().constData());
-            delete item;
+            megaApi->sendEvent(99514, QString::fromUtf8("Duplicated active transfer during insertion: %1").arg(QString::number(tag)).toUtf8().constData());
             return;
         }
 
-        beginInsertRows(QModelIndex(), row, row);
-        transfers.insert(item->tag, item);
-        transferOrder.insert(it, item);
-        endInsertRows();
+        unsigned long long priority = transfer->getPriority();
+        int row = transfers.lowerBound(priority, tag);
+        if (!isFiltered())
+        {
+            beginInsertRows(QModelIndex(), row, row);
+        }
+        transfers.insert(row, tag, priority);
+        updateTransferRowData(transfer);
+        if (!isFiltered())
+        {
+            endInsertRows();
+        }
 
-        if (transferOrder.size() == 1)
+        if (searchIndexed)
+        {
+            searchIndex.add(tag, transferRows.value(tag).fileName);
+            if (isFiltered())
+            {
+                insertIfMatching(tag, priority);
+            }
+        }
+
+        if (transfers.size() == 1)
         {
             emit onTransferAdded();
         }
@@ -242,97 +489,80 @@ void QActiveTransfersModel::onTransferTemporaryError(MegaApi *, MegaTransfer *tr
 
 void QActiveTransfersModel::updateTransferInfo(MegaTransfer *transfer)
 {
-    TransferItemData *itemData = transfers.value(transfer->getTag());
-    if (!itemData)
+    int tag = transfer->getTag();
+    int row = transfers.rowOf(tag);
+    if (row < 0)
     {
         return;
     }
 
     unsigned long long newPriority = transfer->getPriority();
-    TransferItem *item = transferItems[transfer->getTag()];
-    if (item)
+    updateTransferRowData(transfer);
+
+    if (newPriority != transfers.priorityAt(row))
     {
-        if (item->getType() < 0)
-        {
-            item->setType(transfer->getType(), transfer->isSyncTransfer());
-            item->setFileName(QString::fromUtf8(transfer->getFileName()));
-            item->setTotalSize(transfer->getTotalBytes());
-        }
+        // Reorders are applied in a single batch before the next refresh
+        pendingPriorities.insert(tag, newPriority);
+    }
+    else
+    {
+        pendingPriorities.remove(tag);
+    }
+
+    refreshTransferItem(tag);
+}
 
-        item->setSpeed(transfer->getSpeed(), transfer->getMeanSpeed());
-        item->setTransferredBytes(transfer->getTransferredBytes(), !transfer->isSyncTransfer());
-        item->setTransferState(transfer->getState());
-        item->setPriority(newPriority);
+int QActiveTransfersModel::getRowByTag(int tag)
+{
+    return shownTransfers().rowOf(tag);
+}
 
-        int tError = transfer->getLastError().getErrorCode();
-        if (tError != MegaError::API_OK)
-        {
-            item->setTransferError(tError);
-        }
+void QActiveTransfersModel::applyPendingChanges()
+{
+    applyPendingRemovals();
+    if (pendingPriorities.isEmpty())
+    {
+        return;
     }
 
-    if (newPriority == itemData->priority)
+    emit layoutAboutToBeChanged();
+    QModelIndexList oldIndexes = persistentIndexList();
+    QList<int> persistentTags;
+    for (int i = 0; i < oldIndexes.size(); i++)
     {
-        //Update modified item
-        std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-        int row = std::distance(transferOrder.begin(), it);
-        assert(it != transferOrder.end() && (*it)->tag == itemData->tag);
-        if (row >= transferOrder.size())
-        {
-            return;
-        }
-        emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
+        persistentTags.append(oldIndexes.at(i).internalId());
     }
-    else
+
+    for (QHash<int, unsigned long long>::const_iterator it = pendingPriorities.constBegin(); it != pendingPriorities.constEnd(); ++it)
     {
-        //Move item to its new position
-        std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-        int row = std::distance(transferOrder.begin(), it);
-        assert(it != transferOrder.end() && (*it)->tag == itemData->tag);
-        if (it == transferOrder.end() || (*it)->tag != itemData->tag)
+        int row = transfers.rowOf(it.key());
+        if (row >= 0)
         {
-            return;
+            transfers.setPriority(row, it.value());
         }
 
-        TransferItemData testItem;
-        testItem.tag = itemData->tag;
-        testItem.priority = newPriority;
-        std::deque<TransferItemData*>::iterator newit = std::lower_bound(transferOrder.begin(), transferOrder.end(), &testItem, priority_comparator);
-        int newrow = std::distance(transferOrder.begin(), newit);
-
-        if (row == newrow || (row + 1) == newrow)
+        if (isFiltered())
         {
-            //Priorities are being adjusted, but there isn't an actual move operation
-            itemData->priority = newPriority;
-            emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
-        }
-        else
-        {
-            beginMoveRows(QModelIndex(), row, row, QModelIndex(), newrow);
-            transferOrder.erase(it);
-            itemData->priority = newPriority;
-            std::deque<TransferItemData*>::iterator finalit = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-            transferOrder.insert(finalit, itemData);
-            endMoveRows();
+            row = filteredTransfers.rowOf(it.key());
+            if (row >= 0)
+            {
+                filteredTransfers.setPriority(row, it.value());
+            }
         }
     }
-}
-
-void QActiveTransfersModel::refreshTransferItem(int tag)
-{
-    TransferItemData *itemData = transfers.value(tag);
-    if (!itemData)
+    pendingPriorities.clear();
+    transfers.sortByPriority();
+    if (isFiltered())
     {
-        return;
+        filteredTransfers.sortByPriority();
     }
 
-    std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-    int row = std::distance(transferOrder.begin(), it);
-    assert(it != transferOrder.end() && (*it)->tag == itemData->tag);
-    if (row >= transferOrder.size())
+    QModelIndexList newIndexes;
+    for (int i = 0; i < persistentTags.size(); i++)
     {
-        return;
+        int row = getRowByTag(persistentTags.at(i));
+        newIndexes.append(row >= 0 ? index(row, 0, QModelIndex()) : QModelIndex());
     }
-
-    emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
 }
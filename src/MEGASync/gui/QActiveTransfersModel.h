@@ -3,14 +3,10 @@
 
 #include <QAbstractItemModel>
 #include <QCache>
-#include "TransferItem.h"
 #include <megaapi.h>
 #include "QTMegaTransferListener.h"
-#include <deque>
 #include "QTransfersModel.h"
-
-typedef bool (*comparator_function)(TransferItemData* i, TransferItemData *j);
-typedef std::deque<TransferItemData*>::iterator transfer_it;
+#include "TransferSearchIndex.h"
 
 class QActiveTransfersModel : public QTransfersModel
 {
@@ -28,7 +24,12 @@ public:
     virtual Qt::DropActions supportedDropActions() const;
     virtual bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent);
 
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent) const;
+    virtual int rowCount(const QModelIndex &parent) const;
     virtual mega::MegaTransfer *getTransferByTag(int tag);
+    virtual int getRowByTag(int tag);
+    virtual void setFilter(const QString &text);
+    virtual bool isFiltered() const;
 
     // MegaApi callbacks
     virtual void onTransferStart(mega::MegaApi *api, mega::MegaTransfer *transfer);
@@ -36,11 +37,35 @@ public:
     virtual void onTransferUpdate(mega::MegaApi *api, mega::MegaTransfer *transfer);
     virtual void onTransferTemporaryError(mega::MegaApi *api, mega::MegaTransfer *transfer, mega::MegaError* e);
 
+    static const int MAX_REMOVED_RANGES;
+    static const int INDEX_CHUNK_SIZE;
+
 protected:
     void updateTransferInfo(mega::MegaTransfer *transfer);
+    virtual void applyPendingChanges();
+    void applyPendingRemovals();
+    void removeShownRows(TransferIndex &rows, const std::vector<int> &removedRows);
+    const TransferIndex &shownTransfers() const;
+    void indexAllRows();
+    void insertIfMatching(int tag, unsigned long long priority);
+
+    // New priorities not yet applied to the row order
+    QHash<int, unsigned long long> pendingPriorities;
+
+    // Finished or cancelled transfers whose rows are still shown
+    QSet<int> pendingRemovals;
+
+    // Names of the rows, indexed from the first search on
+    TransferSearchIndex searchIndex;
+    bool searchIndexed;
+    QList<int> unindexedTags;
+
+    // Rows matching the lowercase filter, in the same order as the full list
+    QString filterText;
+    TransferIndex filteredTransfers;
 
 private slots:
-    void refreshTransferItem(int tag);
+    void indexNextChunk();
 };
 
 #endif // QACTIVETRANSFERSMODEL_H
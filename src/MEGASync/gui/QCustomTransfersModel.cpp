@@ -14,40 +14,28 @@ QCustomTransfersModel::QCustomTransfersModel(int type, QObject *parent)
 
 void QCustomTransfersModel::refreshTransfers()
 {
-    if (transferOrder.size())
+    if (transfers.size())
     {
-        emit dataChanged(index(0, 0, QModelIndex()), index(transferOrder.size() - 1, 0, QModelIndex()));
+        emit dataChanged(index(0, 0, QModelIndex()), index(transfers.size() - 1, 0, QModelIndex()));
     }
 }
 
 MegaTransfer *QCustomTransfersModel::getTransferByTag(int tag)
 {
-    MegaTransfer *transfer = ((MegaApplication *)qApp)->getFinishedTransferByTag(tag);
-    if (transfer)
-    {
-        return transfer->copy();
-    }
-
     return megaApi->getTransferByTag(tag);
 }
 
 void QCustomTransfersModel::onTransferStart(MegaApi *api, MegaTransfer *transfer)
 {
-    TransferItemData *ti =  transfers.value(transfer->getTag());
-    if (ti)
+    if (transfers.contains(transfer->getTag()))
     {
         return;
     }
 
-    TransferItemData *item = new TransferItemData();
-    item->tag = transfer->getTag();
-    item->priority = transfer->getPriority();
-
-    transfer_it it = getInsertPosition(transfer);
-    int row = it - transferOrder.begin();
+    int row = getInsertPosition(transfer);
     beginInsertRows(QModelIndex(), row, row);
-    transfers.insert(item->tag, item);
-    transferOrder.insert(it, item);
+    transfers.insert(row, transfer->getTag(), transfer->getPriority());
+    updateTransferRowData(transfer);
 
     // Update model state
     if (transfer->getType() == MegaTransfer::TYPE_DOWNLOAD)
@@ -61,8 +49,9 @@ void QCustomTransfersModel::onTransferStart(MegaApi *api, MegaTransfer *transfer
         activeUploadTag = transfer->getTag();
     }
     endInsertRows();
+    updateTransferCounts();
 
-    if (transferOrder.size() == 1)
+    if (transfers.size() == 1)
     {
         emit onTransferAdded();
     }
@@ -74,29 +63,23 @@ void QCustomTransfersModel::onTransferFinish(MegaApi *api, MegaTransfer *transfe
 
     if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
     {
-        TransferItemData *item = new TransferItemData();
-        item->tag = transfer->getTag();
-        item->priority = transfer->getPriority();
-
         if (transfers.size() == Preferences::MAX_COMPLETED_ITEMS)
         {
-            TransferItemData *t = transferOrder.back();
-            int row = transferOrder.size() - 1;
+            int row = transfers.size() - 1;
+            int lastTag = transfers.tagAt(row);
             beginRemoveRows(QModelIndex(), row, row);
-            transfers.remove(t->tag);
-            transferOrder.pop_back();
-            transferItems.remove(t->tag);
+            transfers.remove(row);
+            transferRows.remove(lastTag);
             endRemoveRows();
-            delete t;
         }
 
-        transfer_it it = getInsertPosition(transfer);
-        int row = it - transferOrder.begin();
+        int row = getInsertPosition(transfer);
         beginInsertRows(QModelIndex(), row, row);
-        transfers.insert(item->tag, item);
-        transferOrder.insert(it, item);
+        transfers.insert(row, transfer->getTag(), transfer->getPriority());
+        updateTransferRowData(transfer);
         endInsertRows();
     }
+    updateTransferCounts();
 
     if (transfers.isEmpty())
     {
@@ -104,7 +87,7 @@ void QCustomTransfersModel::onTransferFinish(MegaApi *api, MegaTransfer *transfe
     }
     else
     {
-        if (transferOrder.size() == 1)
+        if (transfers.size() == 1)
         {
             emit onTransferAdded();
         }
@@ -121,53 +104,19 @@ void QCustomTransfersModel::onTransferTemporaryError(MegaApi *api, MegaTransfer
     updateTransferInfo(transfer);
 }
 
-void QCustomTransfersModel::refreshTransferItem(int tag)
+int QCustomTransfersModel::getRowByTag(int tag)
 {
-    int row = 0;
-    for (transfer_it it = transferOrder.begin(); it != transferOrder.end() && (*it)->tag != tag; ++it)
-    {
-        ++row;
-    }
-
-    assert(row < transferOrder.size());
-    if (row >= transferOrder.size())
-    {
-        return;
-    }
-
-    emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
+    return transfers.rowOf(tag);
 }
 
 void QCustomTransfersModel::updateTransferInfo(MegaTransfer *transfer)
 {
-    TransferItemData *itemData = transfers.value(transfer->getTag());
-    if (!itemData)
+    if (!transfers.contains(transfer->getTag()))
     {
         return;
     }
 
-    unsigned long long newPriority = transfer->getPriority();
-    TransferItem *item = transferItems[transfer->getTag()];
-    if (item)
-    {
-        if (item->getType() < 0)
-        {
-            item->setType(transfer->getType(), transfer->isSyncTransfer());
-            item->setFileName(QString::fromUtf8(transfer->getFileName()));
-            item->setTotalSize(transfer->getTotalBytes());
-        }
-
-        item->setSpeed(transfer->getSpeed(), transfer->getMeanSpeed());
-        item->setTransferredBytes(transfer->getTransferredBytes(), !transfer->isSyncTransfer());
-        item->setTransferState(transfer->getState());
-        item->setPriority(newPriority);
-
-        int tError = transfer->getLastError().getErrorCode();
-        if (tError != MegaError::API_OK)
-        {
-            item->setTransferError(tError);
-        }
-    }
+    updateTransferRowData(transfer);
 
     //Update modified item
     refreshTransferItem(transfer->getTag());
@@ -188,28 +137,53 @@ void QCustomTransfersModel::replaceWithTransfer(MegaTransfer *transfer)
         activeUploadTag = transfer->getTag();
     }
 
-    int row = 0;
-    transfer_it it;
-    for (it = transferOrder.begin(); it != transferOrder.end() && (*it)->tag != transferToReplaced; ++it)
+    int row = transfers.rowOf(transferToReplaced);
+    assert(row >= 0);
+    if (row < 0)
+    {
+        return;
+    }
+
+    //Place the new element in the same row
+    beginResetModel();
+    transfers.replace(row, transfer->getTag(), transfer->getPriority());
+    transferRows.remove(transferToReplaced);
+    updateTransferRowData(transfer);
+    endResetModel();
+    updateTransferCounts();
+}
+
+void QCustomTransfersModel::updateTransferCounts()
+{
+    // The counts only change when transfers start or finish, so the SDK is asked here instead of on every paint
+    setTransferCounts(activeUploadTag, megaApi->getNumPendingUploads(), megaApi->getTotalUploads());
+    setTransferCounts(activeDownloadTag, megaApi->getNumPendingDownloads(), megaApi->getTotalDownloads());
+}
+
+void QCustomTransfersModel::setTransferCounts(int tag, int remainingTransfers, int totalTransfers)
+{
+    QHash<int, TransferRowData>::iterator it = transferRows.find(tag);
+    if (tag < 0 || it == transferRows.end())
     {
-        ++row;
+        return;
     }
 
-    TransferItemData *item =  transfers.value(transferToReplaced);
-    assert(item && row < transferOrder.size());
+    if (totalTransfers < remainingTransfers)
+    {
+        totalTransfers = remainingTransfers;
+    }
 
-    //Generate new element and place it
-    TransferItemData *newItem = new TransferItemData();
-    newItem->tag = transfer->getTag();
-    newItem->priority = transfer->getPriority();
+    TransferRowData &row = it.value();
+    int transferNumber = totalTransfers - remainingTransfers + 1;
+    if (row.transferNumber == transferNumber && row.numTransfers == totalTransfers)
+    {
+        return;
+    }
 
-    beginResetModel();
-    transfers.insert(newItem->tag, newItem);
-    transferOrder[row] = newItem;
-    transfers.remove(transferToReplaced);
-    transferItems.remove(transferToReplaced);
-    endResetModel();
-    delete item;
+    row.transferNumber = transferNumber;
+    row.numTransfers = totalTransfers;
+    row.revision++;
+    refreshTransferItem(tag);
 }
 
 void QCustomTransfersModel::removeAllTransfers()
@@ -234,23 +208,13 @@ void QCustomTransfersModel::removeAllCompletedTransfers()
 
         if (initialDelPos <= (transfers.size() - 1))
         {
-            beginRemoveRows(QModelIndex(), initialDelPos, transfers.size() - 1);
-            for (QMap<int, TransferItemData*>::iterator it = transfers.begin(); it != transfers.end();)
+            int lastRow = transfers.size() - 1;
+            beginRemoveRows(QModelIndex(), initialDelPos, lastRow);
+            for (int row = initialDelPos; row <= lastRow; row++)
             {
-                int tag = it.key();
-                if (tag != activeDownloadTag && tag != activeUploadTag)
-                {
-                    TransferItemData *item = it.value();
-                    transferItems.remove(tag);
-                    it = transfers.erase(it);
-                    delete item;
-                }
-                else
-                {
-                    it++;
-                }
+                transferRows.remove(transfers.tagAt(row));
             }
-            transferOrder.erase(transferOrder.begin() + initialDelPos, transferOrder.end());
+            transfers.removeRange(initialDelPos, lastRow);
             endRemoveRows();
         }
     }
@@ -263,20 +227,12 @@ void QCustomTransfersModel::removeAllCompletedTransfers()
 
 void QCustomTransfersModel::removeTransferByTag(int transferTag)
 {
-    TransferItemData *item =  transfers.value(transferTag);
-    if (!item)
+    int row = transfers.rowOf(transferTag);
+    if (row < 0)
     {
         return;
     }
 
-    int row = 0;
-    transfer_it it;
-    for (it = transferOrder.begin(); it != transferOrder.end() && (*it)->tag != transferTag; ++it)
-    {
-        ++row;
-    }
-    assert(row < transferOrder.size());
-
     beginRemoveRows(QModelIndex(), row, row);
     if (activeDownloadTag == transferTag)
     {
@@ -289,11 +245,9 @@ void QCustomTransfersModel::removeTransferByTag(int transferTag)
         activeUploadTag = -1;
     }
 
-    transfers.remove(transferTag);
-    transferOrder.erase(it);
-    transferItems.remove(transferTag);
+    transfers.remove(row);
+    transferRows.remove(transferTag);
     endRemoveRows();
-    delete item;
 
     if (transfers.isEmpty())
     {
@@ -333,27 +287,27 @@ void QCustomTransfersModel::updateActiveTransfer(MegaApi *api, MegaTransfer *new
     }
 }
 
-transfer_it QCustomTransfersModel::getInsertPosition(MegaTransfer *transfer)
+int QCustomTransfersModel::getInsertPosition(MegaTransfer *transfer)
 {
-    transfer_it it = transferOrder.begin();
+    int row = 0;
     if (transfer->isFinished())
     {
         if (modelState & DOWNLOAD)
         {
-            std::advance(it, 1);
+            row++;
         }
 
         if (modelState & UPLOAD)
         {
-            std::advance(it, 1);
+            row++;
         }
     }
     else
     {
         if (modelState & DOWNLOAD)
         {
-            std::advance(it, 1);
+            row++;
         }
     }
-    return it;
+    return row;
 }
@@ -2,7 +2,6 @@
 #define QCUSTOMTRANSFERSMODEL_H
 
 #include <QAbstractItemModel>
-#include <deque>
 #include <megaapi.h>
 #include "QTransfersModel.h"
 #include "QTMegaTransferListener.h"
@@ -23,6 +22,7 @@ public:
 
     void refreshTransfers();
     virtual mega::MegaTransfer *getTransferByTag(int tag);
+    virtual int getRowByTag(int tag);
 
     // MegaApi callbacks
     virtual void onTransferStart(mega::MegaApi *api, mega::MegaTransfer *transfer);
@@ -31,12 +31,13 @@ public:
     virtual void onTransferTemporaryError(mega::MegaApi *api, mega::MegaTransfer *transfer, mega::MegaError* e);
 
 private slots:
-    void refreshTransferItem(int tag);
     void removeAllCompletedTransfers();
 
 protected:
     void updateTransferInfo(mega::MegaTransfer *transfer);
     void replaceWithTransfer(mega::MegaTransfer *transfer);
+    void updateTransferCounts();
+    void setTransferCounts(int tag, int remainingTransfers, int totalTransfers);
 
 public slots:
     void removeAllTransfers();
@@ -47,7 +48,7 @@ private:
     unsigned char modelState;
     int activeUploadTag;
     int activeDownloadTag;
-    transfer_it getInsertPosition(mega::MegaTransfer *transfer);
+    int getInsertPosition(mega::MegaTransfer *transfer);
 };
 
 #endif // QCUSTOMTRANSFERSMODEL_H
@@ -4,83 +4,116 @@
 
 using namespace mega;
 
-QFinishedTransfersModel::QFinishedTransfersModel(QList<MegaTransfer *> finishedTransfers, int type, QObject *parent) :
+const int QFinishedTransfersModel::MAX_CACHED_ROWS = 512;
+const int QFinishedTransfersModel::MAX_SINGLE_REMOVALS = 32;
+
+QFinishedTransfersModel::QFinishedTransfersModel(TransferHistory *history, int type, QObject *parent) :
     QTransfersModel(type, parent)
 {
-    int numTransfers = finishedTransfers.size();
-    if (numTransfers)
+    this->history = history;
+    numRows = history->size();
+    knownNextId = history->nextId();
+    rowCache.setMaxCost(MAX_CACHED_ROWS);
+}
+
+QModelIndex QFinishedTransfersModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent))
     {
-        beginInsertRows(QModelIndex(), 0, numTransfers - 1);
-        for (int i = 0; i < numTransfers; i++)
-        {
-            MegaTransfer *transfer = finishedTransfers.at(i);
-            TransferItemData *item = new TransferItemData();
-            item->tag = transfer->getTag();
-            item->priority = transfer->getPriority();
-            transfers.insert(item->tag, item);
-            transferOrder.push_front(item);
-        }
-        endInsertRows();
+        return QModelIndex();
+    }
+
+    return createIndex(row, column, history->idAt(row));
+}
+
+int QFinishedTransfersModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
     }
+    return numRows;
 }
 
-void QFinishedTransfersModel::insertTransfer(MegaTransfer *transfer)
+void QFinishedTransfersModel::syncWithHistory()
 {
-    TransferItemData *item = new TransferItemData();
-    item->tag = transfer->getTag();
-    item->priority = transfer->getPriority();
+    // Finished transfers are appended to the history before they reach the models,
+    // and the oldest entries may have been dropped to make room for them
+    int newSize = history->size();
+    int numAdded = history->nextId() - knownNextId;
+    int numDropped = numRows + numAdded - newSize;
+    knownNextId = history->nextId();
+    if (numAdded < 0 || numDropped < 0 || numDropped > numRows)
+    {
+        beginResetModel();
+        numRows = newSize;
+        rowCache.clear();
+        endResetModel();
+        return;
+    }
 
-    if (transfers.size() == Preferences::MAX_COMPLETED_ITEMS)
+    if (numDropped)
     {
-        TransferItemData *t = transferOrder.back();
-        int row = transferOrder.size() - 1;
-        beginRemoveRows(QModelIndex(), row, row);
-        transfers.remove(t->tag);
-        transferOrder.pop_back();
-        transferItems.remove(t->tag);
+        beginRemoveRows(QModelIndex(), numRows - numDropped, numRows - 1);
+        numRows -= numDropped;
         endRemoveRows();
-        delete t;
     }
 
-    transfer_it it = transferOrder.begin();
-    int row = 0;
+    if (numAdded)
+    {
+        beginInsertRows(QModelIndex(), 0, numAdded - 1);
+        numRows += numAdded;
+        endInsertRows();
+
+        if (numRows == numAdded)
+        {
+            emit onTransferAdded();
+        }
+    }
+}
+
+void QFinishedTransfersModel::removeTransferByTag(int transferTag)
+{
+    int row = history->rowOf(transferTag);
+    if (row < 0)
+    {
+        return;
+    }
 
-    beginInsertRows(QModelIndex(), row, row);
-    transfers.insert(item->tag, item);
-    transferOrder.insert(it, item);
-    endInsertRows();
+    beginRemoveRows(QModelIndex(), row, row);
+    ((MegaApplication *)qApp)->removeFinishedTransfer(transferTag);
+    numRows--;
+    rowCache.remove(transferTag);
+    endRemoveRows();
 
-    if (transferOrder.size() == 1)
+    if (!numRows)
     {
-        emit onTransferAdded();
+        emit noTransfers();
     }
 }
 
-void QFinishedTransfersModel::removeTransferByTag(int transferTag)
+void QFinishedTransfersModel::removeTransfers(const QList<int> &tags)
 {
-    TransferItemData *item =  transfers.value(transferTag);
-    if (!item)
+    if (tags.size() <= MAX_SINGLE_REMOVALS)
     {
+        QTransfersModel::removeTransfers(tags);
         return;
     }
 
-    int row = 0;
-    transfer_it it;
-    for (it = transferOrder.begin(); it != transferOrder.end() && (*it)->tag != transferTag; ++it)
+    if (tags.size() >= numRows)
     {
-        ++row;
+        removeAllTransfers();
+        return;
     }
-    assert(row < transferOrder.size());
 
-    beginRemoveRows(QModelIndex(), row, row);
-    transfers.remove(transferTag);
-    transferOrder.erase(it);
-    ((MegaApplication *)qApp)->removeFinishedTransfer(transferTag);
-    transferItems.remove(transferTag);
-    endRemoveRows();
-    delete item;
+    // Large selections are removed from the history at once, under a single reset
+    beginResetModel();
+    ((MegaApplication *)qApp)->removeFinishedTransfers(tags);
+    numRows = history->size();
+    rowCache.clear();
+    endResetModel();
 
-    if (transfers.isEmpty())
+    if (!numRows)
     {
         emit noTransfers();
     }
@@ -88,52 +121,57 @@ void QFinishedTransfersModel::removeTransferByTag(int transferTag)
 
 void QFinishedTransfersModel::removeAllTransfers()
 {
-    if (transfers.size())
+    if (numRows)
     {
-        beginRemoveRows(QModelIndex(), 0, transfers.size() - 1);
-        qDeleteAll(transfers);
-        transfers.clear();
-        transferOrder.clear();
-        transferItems.clear();
+        beginRemoveRows(QModelIndex(), 0, numRows - 1);
+        numRows = 0;
+        rowCache.clear();
         endRemoveRows();
 
         ((MegaApplication *)qApp)->removeAllFinishedTransfers();
     }
+    knownNextId = history->nextId();
 
     emit noTransfers();
 }
 
 MegaTransfer *QFinishedTransfersModel::getTransferByTag(int tag)
 {
-    MegaTransfer *transfer = ((MegaApplication *)qApp)->getFinishedTransferByTag(tag);
-    if (transfer)
+    // The history doesn't keep SDK transfers, but the SDK may still have the ones of this session
+    TransferRowData row;
+    if (!history->isFromCurrentSession(tag) || !history->read(tag, &row))
     {
-        return transfer->copy();
+        return NULL;
     }
-    return NULL;
+    return megaApi->getTransferByTag(row.tag);
 }
 
-void QFinishedTransfersModel::onTransferFinish(MegaApi *, MegaTransfer *transfer, MegaError *)
+TransferRowData *QFinishedTransfersModel::getTransferRowData(int tag)
 {
-    if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
+    TransferRowData *row = rowCache.object(tag);
+    if (row)
     {
-        insertTransfer(transfer);
+        return row;
     }
-}
 
-void QFinishedTransfersModel::refreshTransferItem(int tag)
-{
-    int row = 0;
-    for (transfer_it it = transferOrder.begin(); it != transferOrder.end() && (*it)->tag != tag; ++it)
+    row = new TransferRowData();
+    if (!history->read(tag, row))
     {
-        ++row;
+        delete row;
+        return NULL;
     }
 
-    assert(row < transferOrder.size());
-    if (row >= transferOrder.size())
-    {
-        return;
-    }
+    row->tag = tag;
+    rowCache.insert(tag, row);
+    return row;
+}
+
+void QFinishedTransfersModel::onTransferFinish(MegaApi *, MegaTransfer *, MegaError *)
+{
+    syncWithHistory();
+}
 
-    emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
+int QFinishedTransfersModel::getRowByTag(int tag)
+{
+    return history->rowOf(tag);
 }
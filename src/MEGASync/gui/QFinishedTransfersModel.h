@@ -3,29 +3,41 @@
 
 #include <QAbstractItemModel>
 #include <QCache>
-#include "TransferItem.h"
 #include <megaapi.h>
 #include "QTMegaTransferListener.h"
-#include <deque>
 #include "QTransfersModel.h"
+#include "TransferHistory.h"
 
+// Rows of the transfer history, read from it when they are shown.
+// Row identifiers are history ids instead of transfer tags.
 class QFinishedTransfersModel : public QTransfersModel
 {
     Q_OBJECT
 
 public:
-    explicit QFinishedTransfersModel(QList<mega::MegaTransfer *>finishedTransfers, int type = QTransfersModel::TYPE_FINISHED, QObject *parent = 0);
-    void setupModelTransfers();
+    explicit QFinishedTransfersModel(TransferHistory *history, int type = QTransfersModel::TYPE_FINISHED, QObject *parent = 0);
+
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent) const;
+    virtual int rowCount(const QModelIndex &parent) const;
 
     virtual mega::MegaTransfer *getTransferByTag(int tag);
+    virtual int getRowByTag(int tag);
+    virtual TransferRowData *getTransferRowData(int tag);
 
     virtual void onTransferFinish(mega::MegaApi* api, mega::MegaTransfer *transfer, mega::MegaError* e);
 
+    virtual void removeTransfers(const QList<int> &tags);
+
+    static const int MAX_CACHED_ROWS;
+    static const int MAX_SINGLE_REMOVALS;
+
 protected:
-    void insertTransfer(mega::MegaTransfer *transfer);
+    void syncWithHistory();
 
-private slots:
-    void refreshTransferItem(int tag);
+    TransferHistory *history;
+    int numRows;
+    int knownNextId;
+    QCache<int, TransferRowData> rowCache;
 
 public slots:
     void removeAllTransfers();
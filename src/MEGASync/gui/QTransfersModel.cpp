@@ -3,12 +3,18 @@
 
 using namespace mega;
 
+const int QTransfersModel::DIRTY_ROWS_REFRESH_INTERVAL_MS = 16;
+
 QTransfersModel::QTransfersModel(int type, QObject *parent) :
     QAbstractItemModel(parent)
 {
     this->type = type;
     this->megaApi = ((MegaApplication *)qApp)->getMegaApi();
-    this->transferItems.setMaxCost(16);
+
+    dirtyRowsTimer = new QTimer(this);
+    dirtyRowsTimer->setSingleShot(true);
+    dirtyRowsTimer->setInterval(DIRTY_ROWS_REFRESH_INTERVAL_MS);
+    connect(dirtyRowsTimer, SIGNAL(timeout()), this, SLOT(emitDirtyRows()));
 }
 
 int QTransfersModel::columnCount(const QModelIndex &parent) const
@@ -18,7 +24,7 @@ int QTransfersModel::columnCount(const QModelIndex &parent) const
 
 QVariant QTransfersModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || (index.row() < 0 || transfers.count() <= index.row()))
+    if (!index.isValid() || (index.row() < 0 || rowCount(QModelIndex()) <= index.row()))
     {
         return QVariant();
     }
@@ -43,15 +49,179 @@ QModelIndex QTransfersModel::index(int row, int column, const QModelIndex &paren
         return QModelIndex();
     }
 
-    return createIndex(row, column, transferOrder[row]->tag);
+    return createIndex(row, column, transfers.tagAt(row));
 }
 
 void QTransfersModel::refreshTransfers()
 {
-    if (transferOrder.size())
+    int numRows = rowCount(QModelIndex());
+    if (numRows)
+    {
+        emit dataChanged(index(0, 0, QModelIndex()), index(numRows - 1, 0, QModelIndex()));
+    }
+}
+
+void QTransfersModel::refreshTransferItem(int tag)
+{
+    dirtyTags.insert(tag);
+    scheduleRefresh();
+}
+
+void QTransfersModel::removeTransfers(const QList<int> &tags)
+{
+    for (int i = 0; i < tags.size(); i++)
+    {
+        removeTransferByTag(tags.at(i));
+    }
+}
+
+void QTransfersModel::setFilter(const QString &)
+{
+    // Only the lists of active transfers can be searched
+}
+
+bool QTransfersModel::isFiltered() const
+{
+    return false;
+}
+
+TransferRowData *QTransfersModel::getTransferRowData(int tag)
+{
+    QHash<int, TransferRowData>::iterator it = transferRows.find(tag);
+    if (it != transferRows.end())
+    {
+        return &it.value();
+    }
+
+    // Only rows that existed before the model was created lack data
+    if (missingRowTags.isEmpty())
+    {
+        QTimer::singleShot(0, this, SLOT(loadMissingRowData()));
+    }
+    missingRowTags.insert(tag);
+    return NULL;
+}
+
+void QTransfersModel::retryTransfer(int tag)
+{
+    MegaTransfer *transfer = getTransferByTag(tag);
+    if (transfer)
+    {
+        megaApi->retryTransfer(transfer);
+        delete transfer;
+        return;
+    }
+
+    // Started again from the stored data once the SDK doesn't have the transfer
+    TransferRowData *row = getTransferRowData(tag);
+    if (!row || row->path.isEmpty())
+    {
+        return;
+    }
+
+    QByteArray path = row->path.toUtf8();
+    if (row->type == MegaTransfer::TYPE_DOWNLOAD)
     {
-        emit dataChanged(index(0, 0, QModelIndex()), index(transferOrder.size() - 1, 0, QModelIndex()));
+        // Public and foreign nodes can't be found by handle
+        MegaNode *node = row->serializedNode.size() ? MegaNode::unserialize(row->serializedNode.constData())
+                                                    : megaApi->getNodeByHandle(row->nodeHandle);
+        if (node)
+        {
+            megaApi->startDownload(node, path.constData());
+            delete node;
+        }
+    }
+    else if (row->type == MegaTransfer::TYPE_UPLOAD)
+    {
+        MegaNode *parent = megaApi->getNodeByHandle(row->parentHandle);
+        if (parent)
+        {
+            megaApi->startUpload(path.constData(), parent);
+            delete parent;
+        }
+    }
+}
+
+void QTransfersModel::updateTransferRowData(MegaTransfer *transfer)
+{
+    transferRows[transfer->getTag()].update(transfer);
+}
+
+void QTransfersModel::loadMissingRowData()
+{
+    QSet<int> tags;
+    tags.swap(missingRowTags);
+    for (QSet<int>::const_iterator it = tags.constBegin(); it != tags.constEnd(); ++it)
+    {
+        int tag = *it;
+        if (transferRows.contains(tag) || getRowByTag(tag) < 0)
+        {
+            continue;
+        }
+
+        MegaTransfer *transfer = getTransferByTag(tag);
+        if (transfer)
+        {
+            updateTransferRowData(transfer);
+            refreshTransferItem(tag);
+            delete transfer;
+        }
+    }
+}
+
+void QTransfersModel::scheduleRefresh()
+{
+    if (!dirtyRowsTimer->isActive())
+    {
+        dirtyRowsTimer->start();
+    }
+}
+
+void QTransfersModel::applyPendingChanges()
+{
+}
+
+void QTransfersModel::emitDirtyRows()
+{
+    applyPendingChanges();
+    if (dirtyTags.isEmpty())
+    {
+        return;
+    }
+
+    QList<int> rows;
+    rows.reserve(dirtyTags.size());
+    for (QSet<int>::const_iterator it = dirtyTags.constBegin(); it != dirtyTags.constEnd(); ++it)
+    {
+        int row = getRowByTag(*it);
+        if (row >= 0)
+        {
+            rows.append(row);
+        }
+    }
+    dirtyTags.clear();
+
+    if (rows.isEmpty())
+    {
+        return;
+    }
+
+    qSort(rows);
+    int first = rows.at(0);
+    int last = first;
+    for (int i = 1; i < rows.size(); i++)
+    {
+        int row = rows.at(i);
+        if (row <= last + 1)
+        {
+            last = row;
+            continue;
+        }
+
+        emit dataChanged(index(first, 0, QModelIndex()), index(last, 0, QModelIndex()));
+        first = last = row;
     }
+    emit dataChanged(index(first, 0, QModelIndex()), index(last, 0, QModelIndex()));
 }
 
 int QTransfersModel::rowCount(const QModelIndex &parent) const
@@ -60,7 +230,7 @@ int QTransfersModel::rowCount(const QModelIndex &parent) const
     {
         return 0;
     }
-    return transferOrder.size();
+    return transfers.size();
 }
 
 int QTransfersModel::getModelType()
@@ -70,5 +240,4 @@ int QTransfersModel::getModelType()
 
 QTransfersModel::~QTransfersModel()
 {
-    qDeleteAll(transfers);
 }
@@ -2,20 +2,13 @@
 #define QTRANSFERSMODEL_H
 
 #include <QAbstractItemModel>
-#include <QCache>
-#include "TransferItem.h"
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include "TransferRowData.h"
 #include <megaapi.h>
 #include "QTMegaTransferListener.h"
-#include <deque>
-
-class TransferItemData
-{
-public:
-    int tag;
-    unsigned long long priority;
-};
-
-typedef std::deque<TransferItemData*>::iterator transfer_it;
+#include "TransferIndex.h"
 
 class QTransfersModel : public QAbstractItemModel, public mega::MegaTransferListener
 {
@@ -42,22 +35,44 @@ public:
 
     virtual void removeTransferByTag(int transferTag) = 0;
     virtual void removeAllTransfers() = 0;
+    virtual void removeTransfers(const QList<int> &tags);
+    virtual void setFilter(const QString &text);
+    virtual bool isFiltered() const;
     virtual mega::MegaTransfer *getTransferByTag(int tag) = 0;
+    virtual int getRowByTag(int tag) = 0;
+    virtual TransferRowData *getTransferRowData(int tag);
+    void retryTransfer(int tag);
+
+    static const int DIRTY_ROWS_REFRESH_INTERVAL_MS;
 
-    QCache<int, TransferItem> transferItems;
     mega::MegaApi *megaApi;
 
 signals:
     void noTransfers();
     void onTransferAdded();
 
+protected slots:
+    void refreshTransferItem(int tag);
+
 private slots:
-    virtual void refreshTransferItem(int tag) = 0;
+    void emitDirtyRows();
+    void loadMissingRowData();
 
 protected:
-    QMap<int, TransferItemData*> transfers;
-    std::deque<TransferItemData*> transferOrder;
+    void scheduleRefresh();
+    virtual void applyPendingChanges();
+    void updateTransferRowData(mega::MegaTransfer *transfer);
+
+    TransferIndex transfers;
+    QHash<int, TransferRowData> transferRows;
     int type;
+
+    // Rows without data yet, loaded from the SDK once the current paint is done
+    QSet<int> missingRowTags;
+
+    // Rows changed since the last refresh, emitted as merged ranges once per frame
+    QSet<int> dirtyTags;
+    QTimer *dirtyRowsTimer;
 };
 
 #endif // QTRANSFERSMODEL_H
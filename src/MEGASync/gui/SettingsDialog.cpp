@@ -33,11 +33,11 @@ using namespace std;
 
 long long calculateCacheSize()
 {
-    Preferences *preferences = Preferences::instance();
+    QSharedPointer<const SyncRegistry> syncs = Preferences::instance()->getSyncRegistry();
     long long cacheSize = 0;
-    for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+    for (int i = 0; i < syncs->size(); i++)
     {
-        QString syncPath = preferences->getLocalFolder(i);
+        QString syncPath = syncs->at(i).localPath;
         if (!syncPath.isEmpty())
         {
             Utilities::getFolderSize(syncPath + QDir::separator() + QString::fromAscii(MEGA_DEBRIS_FOLDER), &cacheSize);
@@ -48,10 +48,10 @@ long long calculateCacheSize()
 
 void deleteCache()
 {
-    Preferences *preferences = Preferences::instance();
-    for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+    QSharedPointer<const SyncRegistry> syncs = Preferences::instance()->getSyncRegistry();
+    for (int i = 0; i < syncs->size(); i++)
     {
-        QString syncPath = preferences->getLocalFolder(i);
+        QString syncPath = syncs->at(i).localPath;
         if (!syncPath.isEmpty())
         {
             Utilities::removeRecursively(syncPath + QDir::separator() + QString::fromAscii(MEGA_DEBRIS_FOLDER));
@@ -1513,6 +1513,7 @@ int SettingsDialog::saveSettings()
 
         if (sizeLimitsChanged)
         {
+            preferences->beginTransaction();
             preferences->setUpperSizeLimit(hasUpperLimit);
             preferences->setLowerSizeLimit(hasLowerLimit);
             preferences->setUpperSizeLimitValue(upperLimit);
@@ -1520,6 +1521,7 @@ int SettingsDialog::saveSettings()
             preferences->setUpperSizeLimitUnit(upperLimitUnit);
             preferences->setLowerSizeLimitUnit(lowerLimitUnit);
             preferences->setCrashed(true);
+            preferences->commitTransaction();
             QMegaMessageBox::information(this, tr("Warning"),
                                          tr("The new excluded file sizes will be taken into account when the application starts again."),
                                          Utilities::getDevicePixelRatio(),
@@ -1529,8 +1531,10 @@ int SettingsDialog::saveSettings()
 
         if (cleanerLimitsChanged)
         {
+            preferences->beginTransaction();
             preferences->setCleanerDaysLimit(hasDaysLimit);
             preferences->setCleanerDaysLimitValue(daysLimit);
+            preferences->commitTransaction();
             app->cleanLocalCaches();
             cleanerLimitsChanged = false;
         }
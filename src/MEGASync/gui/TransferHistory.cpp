@@ -0,0 +1,621 @@
+#include "TransferHistory.h"
+#include "control/EncryptedSettings.h"
+#include "platform/Platform.h"
+#include <algorithm>
+#include <string.h>
+
+const int TransferHistory::MAX_ENTRIES = 1000000;
+
+const quint32 TransferHistory::MAGIC = 0x4854544D; // "MTTH"
+const quint32 TransferHistory::VERSION = 3;
+const int TransferHistory::RECORDS_GROWTH = 4096;
+const int TransferHistory::HEAP_GROWTH = 1048576;
+const int TransferHistory::COMPACT_THRESHOLD = 65536;
+
+TransferHistory::MappedFile::MappedFile()
+{
+    data = NULL;
+    capacity = 0;
+}
+
+bool TransferHistory::MappedFile::open(const QString &path)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        return false;
+    }
+
+    capacity = file.size();
+    if (capacity)
+    {
+        data = file.map(0, capacity);
+        if (!data)
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void TransferHistory::MappedFile::close()
+{
+    if (data)
+    {
+        file.unmap(data);
+        data = NULL;
+    }
+    capacity = 0;
+    file.close();
+}
+
+bool TransferHistory::MappedFile::reserve(qint64 size, qint64 step)
+{
+    if (size <= capacity)
+    {
+        return true;
+    }
+
+    // Files can't be resized while they are mapped on Windows
+    qint64 newCapacity = ((size + step - 1) / step) * step;
+    if (data)
+    {
+        file.unmap(data);
+        data = NULL;
+    }
+
+    if (!file.resize(newCapacity))
+    {
+        data = capacity ? file.map(0, capacity) : NULL;
+        return false;
+    }
+
+    capacity = newCapacity;
+    data = file.map(0, capacity);
+    return data != NULL;
+}
+
+bool TransferHistory::MappedFile::truncate(qint64 size)
+{
+    if (data)
+    {
+        file.unmap(data);
+        data = NULL;
+    }
+
+    capacity = 0;
+    if (!file.resize(size))
+    {
+        return false;
+    }
+
+    capacity = size;
+    if (size)
+    {
+        data = file.map(0, size);
+    }
+    return !size || data;
+}
+
+TransferHistory::TransferHistory()
+{
+    sessionFirst = 0;
+    encryptionKey = EncryptedSettings::getLocalEncryptionKey();
+}
+
+TransferHistory::~TransferHistory()
+{
+    close();
+}
+
+bool TransferHistory::open(const QString &basePath)
+{
+    close();
+    this->basePath = basePath;
+
+    removedFile.setFileName(basePath + QString::fromAscii(".del"));
+    if (!records.open(basePath + QString::fromAscii(".dat"))
+            || !heap.open(basePath + QString::fromAscii(".str"))
+            || !removedFile.open(QIODevice::ReadWrite))
+    {
+        close();
+        return false;
+    }
+
+    if (!load())
+    {
+        reset();
+    }
+
+    if (!isOpen())
+    {
+        close();
+        return false;
+    }
+
+    Header *h = header();
+    sessionFirst = h->count;
+    if ((h->first - h->base) >= (quint32)COMPACT_THRESHOLD && (h->first - h->base) >= (h->count - h->first))
+    {
+        compact();
+    }
+    return isOpen();
+}
+
+void TransferHistory::close()
+{
+    records.close();
+    heap.close();
+    removedFile.close();
+    removedIds.clear();
+    sessionFirst = 0;
+}
+
+bool TransferHistory::isOpen() const
+{
+    return records.data != NULL;
+}
+
+bool TransferHistory::load()
+{
+    if (records.capacity < (qint64)sizeof(Header))
+    {
+        return false;
+    }
+
+    Header *h = header();
+    if (h->magic != MAGIC || h->version != VERSION || h->recordSize != sizeof(Record)
+            || h->base > h->first || h->first > h->count || h->heapBase > h->heapSize
+            || records.capacity < (qint64)(sizeof(Header) + (qint64)(h->count - h->base) * sizeof(Record))
+            || heap.capacity < (qint64)(h->heapSize - h->heapBase))
+    {
+        return false;
+    }
+
+    QByteArray removedData = removedFile.readAll();
+    int numRemoved = removedData.size() / sizeof(quint32);
+    removedIds.resize(numRemoved);
+    if (numRemoved)
+    {
+        memcpy(removedIds.data(), removedData.constData(), numRemoved * sizeof(quint32));
+        std::sort(removedIds.begin(), removedIds.end());
+        QVector<quint32>::iterator end = std::unique(removedIds.begin(), removedIds.end());
+        QVector<quint32>::iterator begin = std::lower_bound(removedIds.begin(), end, h->first);
+        end = std::lower_bound(begin, end, h->count);
+        removedIds = QVector<quint32>::fromStdVector(std::vector<quint32>(begin, end));
+    }
+    return true;
+}
+
+void TransferHistory::reset()
+{
+    removedIds.clear();
+    if (!heap.truncate(0) || !removedFile.resize(0)
+            || !records.truncate(0)
+            || !records.reserve(sizeof(Header) + RECORDS_GROWTH * sizeof(Record), RECORDS_GROWTH * sizeof(Record)))
+    {
+        records.truncate(0);
+        return;
+    }
+
+    Header *h = header();
+    memset(h, 0, sizeof(Header));
+    h->magic = MAGIC;
+    h->version = VERSION;
+    h->recordSize = sizeof(Record);
+}
+
+bool TransferHistory::compact()
+{
+    // Only the dropped oldest entries are reclaimed, so ids remain valid
+    Header *h = header();
+    Header newHeader = *h;
+    newHeader.base = h->first;
+    newHeader.heapBase = (h->first < h->count) ? record(h->first)->stringsOffset : h->heapSize;
+
+    QFile newRecords(basePath + QString::fromAscii(".dat.tmp"));
+    QFile newHeap(basePath + QString::fromAscii(".str.tmp"));
+    qint64 recordsSize = (qint64)(h->count - h->first) * sizeof(Record);
+    qint64 heapSize = h->heapSize - newHeader.heapBase;
+    if (!newRecords.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || !newHeap.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || newRecords.write((const char *)&newHeader, sizeof(Header)) != sizeof(Header)
+            || newRecords.write((const char *)record(h->first), recordsSize) != recordsSize
+            || newHeap.write((const char *)heap.data + (newHeader.heapBase - h->heapBase), heapSize) != heapSize
+            || !newRecords.flush() || !newHeap.flush())
+    {
+        newRecords.remove();
+        newHeap.remove();
+        return false;
+    }
+    newRecords.close();
+    newHeap.close();
+
+    quint32 session = sessionFirst;
+    QVector<quint32> removed = removedIds;
+    close();
+    QFile::remove(basePath + QString::fromAscii(".dat"));
+    QFile::remove(basePath + QString::fromAscii(".str"));
+    newRecords.rename(basePath + QString::fromAscii(".dat"));
+    newHeap.rename(basePath + QString::fromAscii(".str"));
+
+    if (!records.open(basePath + QString::fromAscii(".dat"))
+            || !heap.open(basePath + QString::fromAscii(".str"))
+            || !removedFile.open(QIODevice::ReadWrite)
+            || !load())
+    {
+        reset();
+        return false;
+    }
+
+    sessionFirst = session;
+    removedIds = removed;
+    return writeRemovedIds();
+}
+
+bool TransferHistory::writeRemovedIds()
+{
+    qint64 size = removedIds.size() * sizeof(quint32);
+    return removedFile.resize(0) && removedFile.seek(0)
+            && removedFile.write((const char *)removedIds.constData(), size) == size
+            && removedFile.flush();
+}
+
+TransferHistory::Header *TransferHistory::header() const
+{
+    return (Header *)records.data;
+}
+
+TransferHistory::Record *TransferHistory::record(int id) const
+{
+    return (Record *)(records.data + sizeof(Header) + (qint64)((quint32)id - header()->base) * sizeof(Record));
+}
+
+int TransferHistory::size() const
+{
+    if (!isOpen())
+    {
+        return 0;
+    }
+
+    Header *h = header();
+    return h->count - h->first - removedIds.size();
+}
+
+bool TransferHistory::isEmpty() const
+{
+    return !size();
+}
+
+int TransferHistory::nextId() const
+{
+    return isOpen() ? header()->count : 0;
+}
+
+bool TransferHistory::isRemoved(int id) const
+{
+    return std::binary_search(removedIds.constBegin(), removedIds.constEnd(), (quint32)id);
+}
+
+int TransferHistory::numRemovedBefore(int id) const
+{
+    return std::lower_bound(removedIds.constBegin(), removedIds.constEnd(), (quint32)id) - removedIds.constBegin();
+}
+
+int TransferHistory::idAt(int row) const
+{
+    int numEntries = size();
+    if (row < 0 || row >= numEntries)
+    {
+        return -1;
+    }
+
+    // Find the k-th live id, counting from the oldest one and skipping the removed ones
+    quint32 first = header()->first;
+    int k = numEntries - 1 - row;
+    int low = 0;
+    int high = removedIds.size();
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if ((int)(removedIds.at(middle) - first) - middle <= k)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return first + k + low;
+}
+
+int TransferHistory::rowOf(int id) const
+{
+    if (!isOpen() || id < 0)
+    {
+        return -1;
+    }
+
+    Header *h = header();
+    if ((quint32)id < h->first || (quint32)id >= h->count || isRemoved(id))
+    {
+        return -1;
+    }
+
+    int k = id - h->first - numRemovedBefore(id);
+    return size() - 1 - k;
+}
+
+bool TransferHistory::read(int id, TransferRowData *row) const
+{
+    if (rowOf(id) < 0)
+    {
+        return false;
+    }
+
+    Record *r = record(id);
+    row->tag = r->tag;
+    row->type = r->type;
+    row->state = r->state;
+    row->error = r->error;
+    row->isSyncTransfer = (r->flags & FLAG_SYNC_TRANSFER) != 0;
+    row->regular = !row->isSyncTransfer;
+    QByteArray strings = decrypt(readString(r->stringsOffset, r->stringsLength), r->stringsOffset);
+    if ((quint64)strings.size() == (quint64)r->nameLength + r->pathLength + r->linkLength + r->nodeLength)
+    {
+        const char *data = strings.constData();
+        row->fileName = QString::fromUtf8(data, r->nameLength);
+        data += r->nameLength;
+        row->path = QString::fromUtf8(data, r->pathLength);
+        data += r->pathLength;
+        row->publicLink = QString::fromUtf8(data, r->linkLength);
+        data += r->linkLength;
+        row->serializedNode = QByteArray(data, r->nodeLength);
+    }
+    row->nodeHandle = r->nodeHandle;
+    row->parentHandle = r->parentHandle;
+    row->totalSize = r->totalSize;
+    row->transferredBytes = r->transferredBytes;
+    row->speed = 0;
+    row->meanSpeed = r->meanSpeed;
+    row->startTime = r->startTime;
+    row->finishedTime = r->finishedTime;
+    row->priority = 0;
+
+    // Entries never change once written
+    row->revision = 1;
+    return true;
+}
+
+bool TransferHistory::isFromCurrentSession(int id) const
+{
+    return id >= 0 && (quint32)id >= sessionFirst;
+}
+
+quint64 TransferHistory::appendString(const QByteArray &value)
+{
+    Header *h = header();
+    quint64 offset = h->heapSize;
+    if (value.isEmpty() || !heap.reserve(offset - h->heapBase + value.size(), HEAP_GROWTH))
+    {
+        return offset;
+    }
+
+    memcpy(heap.data + (offset - h->heapBase), value.constData(), value.size());
+    h->heapSize += value.size();
+    return offset;
+}
+
+QByteArray TransferHistory::readString(quint64 offset, quint32 length) const
+{
+    Header *h = header();
+    if (!length || offset < h->heapBase || offset + length > h->heapSize)
+    {
+        return QByteArray();
+    }
+    return QByteArray((const char *)heap.data + (offset - h->heapBase), length);
+}
+
+QByteArray TransferHistory::encrypt(const QByteArray &data, quint64 offset) const
+{
+    if (data.isEmpty())
+    {
+        return data;
+    }
+
+    // Each entry gets its own key, so equal strings don't look alike in the heap
+    QByteArray k = QCryptographicHash::hash(encryptionKey + QByteArray::number(offset), QCryptographicHash::Sha1);
+    return EncryptedSettings::XOR(k, Platform::encrypt(EncryptedSettings::XOR(k, data), k));
+}
+
+QByteArray TransferHistory::decrypt(const QByteArray &data, quint64 offset) const
+{
+    if (data.isEmpty())
+    {
+        return data;
+    }
+
+    QByteArray k = QCryptographicHash::hash(encryptionKey + QByteArray::number(offset), QCryptographicHash::Sha1);
+    return EncryptedSettings::XOR(k, Platform::decrypt(EncryptedSettings::XOR(k, data), k));
+}
+
+int TransferHistory::append(const TransferRowData &row)
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+
+    Header *h = header();
+    if (!records.reserve(sizeof(Header) + (qint64)(h->count - h->base + 1) * sizeof(Record),
+                         RECORDS_GROWTH * sizeof(Record)))
+    {
+        return -1;
+    }
+
+    // The mapping may have moved
+    h = header();
+    int id = h->count;
+
+    // Strings go first, the entry only exists once the count is increased
+    QByteArray name = row.fileName.toUtf8();
+    QByteArray path = row.path.toUtf8();
+    QByteArray link = row.publicLink.toUtf8();
+    quint64 heapSize = h->heapSize;
+    QByteArray strings = encrypt(name + path + link + row.serializedNode, heapSize);
+    quint64 stringsOffset = appendString(strings);
+    if (h->heapSize - heapSize != (quint64)strings.size())
+    {
+        h->heapSize = heapSize;
+        return -1;
+    }
+
+    Record *r = record(id);
+    memset(r, 0, sizeof(Record));
+    r->nodeHandle = row.nodeHandle;
+    r->parentHandle = row.parentHandle;
+    r->totalSize = row.totalSize;
+    r->transferredBytes = row.transferredBytes;
+    r->meanSpeed = row.meanSpeed;
+    r->startTime = row.startTime;
+    r->finishedTime = row.finishedTime;
+    r->stringsOffset = stringsOffset;
+    r->stringsLength = strings.size();
+    r->nameLength = name.size();
+    r->pathLength = path.size();
+    r->linkLength = link.size();
+    r->nodeLength = row.serializedNode.size();
+    r->tag = row.tag;
+    r->error = row.error;
+    r->type = row.type;
+    r->state = row.state;
+    r->flags = row.isSyncTransfer ? FLAG_SYNC_TRANSFER : 0;
+    h->count++;
+
+    if (size() > MAX_ENTRIES)
+    {
+        dropOldest();
+    }
+    return id;
+}
+
+void TransferHistory::dropOldest()
+{
+    Header *h = header();
+    if (h->first == h->count)
+    {
+        return;
+    }
+
+    h->first++;
+    int numDropped = 0;
+    while (numDropped < removedIds.size() && removedIds.at(numDropped) == h->first)
+    {
+        h->first++;
+        numDropped++;
+    }
+    removedIds.remove(0, numDropped);
+}
+
+bool TransferHistory::remove(int id, int *tag)
+{
+    if (rowOf(id) < 0)
+    {
+        return false;
+    }
+
+    if (tag)
+    {
+        *tag = record(id)->tag;
+    }
+
+    if ((quint32)id == header()->first)
+    {
+        dropOldest();
+        return true;
+    }
+
+    quint32 removedId = id;
+    removedIds.insert(numRemovedBefore(id), removedId);
+    removedFile.seek(removedFile.size());
+    removedFile.write((const char *)&removedId, sizeof(removedId));
+    removedFile.flush();
+    return true;
+}
+
+int TransferHistory::remove(const QList<int> &ids, QList<int> *sessionTags)
+{
+    if (!isOpen())
+    {
+        return 0;
+    }
+
+    QVector<quint32> newIds;
+    newIds.reserve(ids.size());
+    for (int i = 0; i < ids.size(); i++)
+    {
+        if (rowOf(ids.at(i)) >= 0)
+        {
+            newIds.append(ids.at(i));
+        }
+    }
+    std::sort(newIds.begin(), newIds.end());
+    newIds.erase(std::unique(newIds.begin(), newIds.end()), newIds.end());
+    if (newIds.isEmpty())
+    {
+        return 0;
+    }
+
+    if (sessionTags)
+    {
+        for (QVector<quint32>::const_iterator it = std::lower_bound(newIds.constBegin(), newIds.constEnd(), sessionFirst);
+             it != newIds.constEnd(); ++it)
+        {
+            sessionTags->append(record(*it)->tag);
+        }
+    }
+
+    // Live ids aren't in removedIds yet, so both lists merge without duplicates
+    QVector<quint32> merged(removedIds.size() + newIds.size());
+    std::merge(removedIds.constBegin(), removedIds.constEnd(), newIds.constBegin(), newIds.constEnd(), merged.begin());
+    removedIds = merged;
+
+    // Removed entries at the start of the history are dropped instead
+    Header *h = header();
+    int numDropped = 0;
+    while (numDropped < removedIds.size() && removedIds.at(numDropped) == h->first)
+    {
+        h->first++;
+        numDropped++;
+    }
+    removedIds.remove(0, numDropped);
+
+    QVector<quint32>::const_iterator begin = std::lower_bound(newIds.constBegin(), newIds.constEnd(), h->first);
+    qint64 size = (newIds.constEnd() - begin) * sizeof(quint32);
+    if (size)
+    {
+        removedFile.seek(removedFile.size());
+        removedFile.write((const char *)begin, size);
+        removedFile.flush();
+    }
+    return newIds.size();
+}
+
+void TransferHistory::clear()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    // Ids keep growing, so nothing cached for the old entries can match the new ones
+    Header *h = header();
+    h->base = h->first = h->count;
+    h->heapBase = h->heapSize;
+    removedIds.clear();
+    heap.truncate(0);
+    writeRemovedIds();
+    records.truncate(sizeof(Header));
+}
@@ -0,0 +1,141 @@
+#ifndef TRANSFERHISTORY_H
+#define TRANSFERHISTORY_H
+
+#include <QFile>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include "TransferRowData.h"
+
+// Completed transfers, kept on disk across restarts. Fixed-size records are
+// appended to a memory-mapped file whose header holds the counters, and the
+// strings of each entry go, encrypted with the local key like the settings,
+// to a separate memory-mapped heap, so opening the history only
+// maps both files and rows are read straight from the mappings on demand.
+// Removed entries are listed in a small side file instead of being rewritten.
+// Ids are sequence numbers that never change while the history is open.
+class TransferHistory
+{
+public:
+    TransferHistory();
+    ~TransferHistory();
+
+    bool open(const QString &basePath);
+    void close();
+    bool isOpen() const;
+
+    int size() const;
+    bool isEmpty() const;
+
+    // Id that the next appended entry will get
+    int nextId() const;
+
+    // Rows are ordered from the newest entry to the oldest one
+    int idAt(int row) const;
+    int rowOf(int id) const;
+    bool read(int id, TransferRowData *row) const;
+
+    // Entries appended since the history was opened keep the tag of their transfer
+    bool isFromCurrentSession(int id) const;
+
+    // Returns the id of the new entry. The oldest entries are dropped
+    // when the history grows beyond MAX_ENTRIES.
+    int append(const TransferRowData &row);
+    bool remove(int id, int *tag = NULL);
+    // Removes all the entries with a single write of the removed ids file. Returns the number of
+    // removed entries, and adds the tags of the ones appended in this session to sessionTags
+    int remove(const QList<int> &ids, QList<int> *sessionTags = NULL);
+    void clear();
+
+    static const int MAX_ENTRIES;
+
+protected:
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 recordSize;
+        quint32 reserved;
+        quint32 base;       // id of the first record stored in the file
+        quint32 first;      // id of the oldest entry still in the history
+        quint32 count;      // id that the next entry will get
+        quint32 reserved2;
+        quint64 heapBase;   // heap offset of the first byte stored in the heap file
+        quint64 heapSize;   // heap offset where the next string will be written
+    };
+
+    struct Record
+    {
+        quint64 nodeHandle;
+        quint64 parentHandle;
+        qint64 totalSize;
+        qint64 transferredBytes;
+        qint64 meanSpeed;
+        qint64 startTime;
+        qint64 finishedTime;
+        quint64 stringsOffset;  // heap offset of the encrypted strings of the entry
+        quint32 stringsLength;
+        quint32 nameLength;     // lengths of the decrypted strings
+        quint32 pathLength;
+        quint32 linkLength;
+        quint32 nodeLength;
+        qint32 tag;
+        qint32 error;
+        quint8 type;
+        quint8 state;
+        quint8 flags;
+        quint8 reserved;
+    };
+
+    enum {
+        FLAG_SYNC_TRANSFER = 0x01
+    };
+
+    // A file mapped as a whole, grown in steps so that appends rarely remap it
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        bool open(const QString &path);
+        void close();
+        bool reserve(qint64 size, qint64 step);
+        bool truncate(qint64 size);
+
+        QFile file;
+        uchar *data;
+        qint64 capacity;
+    };
+
+    bool load();
+    void reset();
+    bool compact();
+    bool writeRemovedIds();
+    bool isRemoved(int id) const;
+    int numRemovedBefore(int id) const;
+    void dropOldest();
+
+    Header *header() const;
+    Record *record(int id) const;
+    quint64 appendString(const QByteArray &value);
+    QByteArray readString(quint64 offset, quint32 length) const;
+    QByteArray encrypt(const QByteArray &data, quint64 offset) const;
+    QByteArray decrypt(const QByteArray &data, quint64 offset) const;
+
+    static const quint32 MAGIC;
+    static const quint32 VERSION;
+    static const int RECORDS_GROWTH;
+    static const int HEAP_GROWTH;
+    static const int COMPACT_THRESHOLD;
+
+    QString basePath;
+    MappedFile records;
+    MappedFile heap;
+    QFile removedFile;
+    QByteArray encryptionKey;
+
+    // Sorted ids of the entries removed after the oldest one
+    QVector<quint32> removedIds;
+    quint32 sessionFirst;
+};
+
+#endif // TRANSFERHISTORY_H
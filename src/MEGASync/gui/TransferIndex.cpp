@@ -0,0 +1,372 @@
+#include "TransferIndex.h"
+#include <algorithm>
+#include <assert.h>
+
+namespace {
+
+const int MIN_HASH_CAPACITY = 16;
+const int MIN_COMPACT_SIZE = 4096;
+
+inline unsigned int hashTag(int tag)
+{
+    unsigned int h = (unsigned int)tag * 2654435769U;
+    return h ^ (h >> 16);
+}
+
+struct PriorityOrder
+{
+    const std::vector<int> *tags;
+    const std::vector<unsigned long long> *priorities;
+
+    bool operator()(int i, int j) const
+    {
+        if ((*priorities)[i] != (*priorities)[j])
+        {
+            return (*priorities)[i] < (*priorities)[j];
+        }
+        return (*tags)[i] < (*tags)[j];
+    }
+};
+
+}
+
+TransferIndex::TransferIndex()
+{
+    head = 0;
+    validEnd = 0;
+    usedSlots = 0;
+    rehash(MIN_HASH_CAPACITY);
+}
+
+int TransferIndex::size() const
+{
+    return tags.size() - head;
+}
+
+bool TransferIndex::isEmpty() const
+{
+    return !size();
+}
+
+bool TransferIndex::contains(int tag) const
+{
+    return findSlot(tag) >= 0;
+}
+
+int TransferIndex::rowOf(int tag) const
+{
+    int slot = findSlot(tag);
+    if (slot < 0)
+    {
+        return -1;
+    }
+
+    int position = slots[slot].position;
+    if (position >= validEnd || position < head || tags[position] != tag)
+    {
+        reindex();
+        position = slots[slot].position;
+    }
+
+    assert(position >= head && position < (int)tags.size() && tags[position] == tag);
+    return position - head;
+}
+
+int TransferIndex::tagAt(int row) const
+{
+    return tags[head + row];
+}
+
+unsigned long long TransferIndex::priorityAt(int row) const
+{
+    return priorities[head + row];
+}
+
+void TransferIndex::setPriority(int row, unsigned long long priority)
+{
+    priorities[head + row] = priority;
+}
+
+int TransferIndex::lowerBound(unsigned long long priority, int tag) const
+{
+    int first = head;
+    int count = size();
+    while (count > 0)
+    {
+        int step = count / 2;
+        int position = first + step;
+        if (priorities[position] < priority || (priorities[position] == priority && tags[position] < tag))
+        {
+            first = position + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first - head;
+}
+
+void TransferIndex::reserve(int n)
+{
+    tags.reserve(head + n);
+    priorities.reserve(head + n);
+
+    int capacity = slots.size();
+    while (capacity < n * 2)
+    {
+        capacity *= 2;
+    }
+
+    if (capacity != (int)slots.size())
+    {
+        rehash(capacity);
+    }
+}
+
+void TransferIndex::append(int tag, unsigned long long priority)
+{
+    int position = tags.size();
+    tags.push_back(tag);
+    priorities.push_back(priority);
+    hashInsert(tag, position);
+    if (validEnd == position)
+    {
+        validEnd++;
+    }
+}
+
+void TransferIndex::insert(int row, int tag, unsigned long long priority)
+{
+    if (row >= size())
+    {
+        append(tag, priority);
+        return;
+    }
+
+    if (!row && head)
+    {
+        // Reuse the space left by removals at the front, nothing moves
+        head--;
+        tags[head] = tag;
+        priorities[head] = priority;
+        hashInsert(tag, head);
+        return;
+    }
+
+    int position = head + row;
+    tags.insert(tags.begin() + position, tag);
+    priorities.insert(priorities.begin() + position, priority);
+    hashInsert(tag, position);
+    validEnd = std::min(validEnd, position);
+}
+
+void TransferIndex::replace(int row, int tag, unsigned long long priority)
+{
+    int position = head + row;
+    hashRemove(tags[position]);
+    tags[position] = tag;
+    priorities[position] = priority;
+    hashInsert(tag, position);
+}
+
+void TransferIndex::remove(int row)
+{
+    removeRange(row, row);
+}
+
+void TransferIndex::removeRange(int first, int last)
+{
+    if (first > last)
+    {
+        return;
+    }
+
+    for (int row = first; row <= last; row++)
+    {
+        hashRemove(tags[head + row]);
+    }
+
+    if (!first)
+    {
+        // Finished transfers usually leave from the front, so only the head moves
+        head += last + 1;
+        if (head >= MIN_COMPACT_SIZE && head > size())
+        {
+            tags.erase(tags.begin(), tags.begin() + head);
+            priorities.erase(priorities.begin(), priorities.begin() + head);
+            head = 0;
+            rehash(slots.size());
+        }
+        return;
+    }
+
+    tags.erase(tags.begin() + head + first, tags.begin() + head + last + 1);
+    priorities.erase(priorities.begin() + head + first, priorities.begin() + head + last + 1);
+    validEnd = std::min(validEnd, head + first);
+}
+
+void TransferIndex::removeRows(const std::vector<int> &rows)
+{
+    if (rows.empty())
+    {
+        return;
+    }
+
+    int output = head + rows[0];
+    std::vector<int>::const_iterator next = rows.begin();
+    for (int position = head + rows[0]; position < (int)tags.size(); position++)
+    {
+        if (next != rows.end() && *next == position - head)
+        {
+            hashRemove(tags[position]);
+            ++next;
+            continue;
+        }
+
+        tags[output] = tags[position];
+        priorities[output] = priorities[position];
+        output++;
+    }
+
+    tags.resize(output);
+    priorities.resize(output);
+    validEnd = std::min(validEnd, head + rows[0]);
+}
+
+void TransferIndex::sortByPriority()
+{
+    int n = size();
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = head + i;
+    }
+
+    PriorityOrder comparator;
+    comparator.tags = &tags;
+    comparator.priorities = &priorities;
+    std::sort(order.begin(), order.end(), comparator);
+
+    std::vector<int> sortedTags(n);
+    std::vector<unsigned long long> sortedPriorities(n);
+    for (int i = 0; i < n; i++)
+    {
+        sortedTags[i] = tags[order[i]];
+        sortedPriorities[i] = priorities[order[i]];
+    }
+
+    tags.swap(sortedTags);
+    priorities.swap(sortedPriorities);
+    head = 0;
+    validEnd = 0;
+}
+
+void TransferIndex::clear()
+{
+    tags.clear();
+    priorities.clear();
+    head = 0;
+    rehash(MIN_HASH_CAPACITY);
+}
+
+int TransferIndex::findSlot(int tag) const
+{
+    unsigned int mask = slots.size() - 1;
+    unsigned int i = hashTag(tag) & mask;
+    while (slots[i].position != SLOT_EMPTY)
+    {
+        if (slots[i].position != SLOT_DELETED && slots[i].tag == tag)
+        {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+void TransferIndex::hashInsert(int tag, int position)
+{
+    if ((usedSlots + 1) * 2 > (int)slots.size())
+    {
+        int capacity = MIN_HASH_CAPACITY;
+        while (capacity < (size() + 1) * 4)
+        {
+            capacity *= 2;
+        }
+        rehash(capacity);
+
+        // The rehash already indexed the tag if it was stored before this call
+        int slot = findSlot(tag);
+        if (slot >= 0)
+        {
+            slots[slot].position = position;
+            return;
+        }
+    }
+
+    unsigned int mask = slots.size() - 1;
+    unsigned int i = hashTag(tag) & mask;
+    while (slots[i].position >= 0)
+    {
+        assert(slots[i].tag != tag);
+        i = (i + 1) & mask;
+    }
+
+    if (slots[i].position == SLOT_EMPTY)
+    {
+        usedSlots++;
+    }
+    slots[i].tag = tag;
+    slots[i].position = position;
+}
+
+void TransferIndex::hashRemove(int tag)
+{
+    int slot = findSlot(tag);
+    if (slot >= 0)
+    {
+        slots[slot].position = SLOT_DELETED;
+    }
+}
+
+void TransferIndex::rehash(int capacity)
+{
+    Slot empty;
+    empty.tag = 0;
+    empty.position = SLOT_EMPTY;
+    slots.assign(capacity, empty);
+    usedSlots = 0;
+
+    // Every row gets its current position, so the whole table becomes valid
+    unsigned int mask = capacity - 1;
+    int end = tags.size();
+    for (int position = head; position < end; position++)
+    {
+        unsigned int i = hashTag(tags[position]) & mask;
+        while (slots[i].position != SLOT_EMPTY)
+        {
+            i = (i + 1) & mask;
+        }
+        slots[i].tag = tags[position];
+        slots[i].position = position;
+        usedSlots++;
+    }
+    validEnd = end;
+}
+
+void TransferIndex::reindex() const
+{
+    int end = tags.size();
+    for (int position = std::max(validEnd, head); position < end; position++)
+    {
+        int slot = findSlot(tags[position]);
+        assert(slot >= 0);
+        if (slot >= 0)
+        {
+            slots[slot].position = position;
+        }
+    }
+    validEnd = end;
+}
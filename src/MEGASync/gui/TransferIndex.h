@@ -0,0 +1,68 @@
+#ifndef TRANSFERINDEX_H
+#define TRANSFERINDEX_H
+
+#include <vector>
+
+// Row storage for the transfer models: tags and priorities are kept in
+// contiguous arrays indexed by row, and an open-addressing hash maps each
+// tag to its position. Positions after an insertion or removal point are
+// reindexed lazily, and removals from the front only advance the head, so
+// appends and finished transfers don't rewrite the whole table.
+class TransferIndex
+{
+public:
+    TransferIndex();
+
+    int size() const;
+    bool isEmpty() const;
+    bool contains(int tag) const;
+    int rowOf(int tag) const;
+    int tagAt(int row) const;
+    unsigned long long priorityAt(int row) const;
+    void setPriority(int row, unsigned long long priority);
+
+    // First row whose (priority, tag) is not lower than the given one
+    int lowerBound(unsigned long long priority, int tag) const;
+
+    void reserve(int n);
+    void append(int tag, unsigned long long priority);
+    void insert(int row, int tag, unsigned long long priority);
+    void replace(int row, int tag, unsigned long long priority);
+    void remove(int row);
+    void removeRange(int first, int last);
+
+    // Removes the given rows, which must be sorted, in a single pass
+    void removeRows(const std::vector<int> &rows);
+    void sortByPriority();
+    void clear();
+
+private:
+    struct Slot
+    {
+        int tag;
+        int position;
+    };
+
+    enum {
+        SLOT_EMPTY = -1,
+        SLOT_DELETED = -2
+    };
+
+    int findSlot(int tag) const;
+    void hashInsert(int tag, int position);
+    void hashRemove(int tag);
+    void rehash(int capacity);
+    void reindex() const;
+
+    // Rows live in [head, tags.size())
+    std::vector<int> tags;
+    std::vector<unsigned long long> priorities;
+    int head;
+
+    // Positions below validEnd have an up to date entry in the hash
+    mutable std::vector<Slot> slots;
+    mutable int validEnd;
+    int usedSlots;
+};
+
+#endif // TRANSFERINDEX_H
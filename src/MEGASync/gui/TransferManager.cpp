@@ -50,7 +50,7 @@ TransferManager::TransferManager(MegaApi *megaApi, QWidget *parent) :
     delete firstUpload;
     delete firstDownload;
 
-    if (((MegaApplication *)qApp)->getFinishedTransfers().size() > 0)
+    if (!((MegaApplication *)qApp)->getTransferHistory()->isEmpty())
     {
         ui->wCompletedTab->setVisible(true);
     }
@@ -59,7 +59,7 @@ TransferManager::TransferManager(MegaApi *megaApi, QWidget *parent) :
         ui->wCompletedTab->setVisible(false);
     }
 
-    ui->wCompleted->setupFinishedTransfers(((MegaApplication *)qApp)->getFinishedTransfers());
+    ui->wCompleted->setupFinishedTransfers(((MegaApplication *)qApp)->getTransferHistory());
     updateNumberOfCompletedTransfers(((MegaApplication *)qApp)->getNumUnviewedTransfers());
     delete transferData;
 
@@ -270,6 +270,7 @@ void TransferManager::on_tCompleted_clicked()
     ui->tDownloads->setStyleSheet(QString::fromUtf8("color: #999999;"));
     ui->bClearAll->setText(tr("Clear all"));
     ui->bPause->setVisible(false);
+    ui->leSearch->setVisible(false);
     ui->wTransfers->setCurrentWidget(ui->wCompleted);
     updateState();
     updatePauseState();
@@ -300,6 +301,7 @@ void TransferManager::on_tDownloads_clicked()
     ui->tDownloads->setStyleSheet(QString::fromUtf8("color: #333333;"));
     ui->bClearAll->setText(tr("Cancel all"));
     ui->bPause->setVisible(true);
+    ui->leSearch->setVisible(true);
 
     ui->wTransfers->setCurrentWidget(ui->wDownloads);
     updateState();
@@ -329,6 +331,7 @@ void TransferManager::on_tUploads_clicked()
     ui->tDownloads->setStyleSheet(QString::fromUtf8("color: #999999;"));
     ui->bClearAll->setText(tr("Cancel all"));
     ui->bPause->setVisible(true);
+    ui->leSearch->setVisible(true);
 
     ui->wTransfers->setCurrentWidget(ui->wUploads);
     updateState();
@@ -358,12 +361,20 @@ void TransferManager::on_tAllTransfers_clicked()
     ui->tDownloads->setStyleSheet(QString::fromUtf8("color: #999999;"));
     ui->bClearAll->setText(tr("Cancel all"));
     ui->bPause->setVisible(true);
+    ui->leSearch->setVisible(false);
 
     ui->wTransfers->setCurrentWidget(ui->wActiveTransfers);
     updateState();
     updatePauseState();
 }
 
+void TransferManager::on_leSearch_textChanged(const QString &text)
+{
+    // Both lists keep the filter, so it still applies after switching tabs
+    ui->wUploads->setFilter(text);
+    ui->wDownloads->setFilter(text);
+}
+
 void TransferManager::on_bAdd_clicked()
 {
     emit userActivity();
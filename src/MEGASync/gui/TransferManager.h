@@ -73,6 +73,7 @@ private slots:
     void on_bClose_clicked();
     void on_bPause_clicked();
     void on_bClearAll_clicked();
+    void on_leSearch_textChanged(const QString &text);
 
     void refreshFinishedTime();
 
@@ -0,0 +1,116 @@
+#include "TransferRowData.h"
+
+using namespace mega;
+
+TransferRowData::TransferRowData()
+{
+    tag = 0;
+    type = -1;
+    state = 0;
+    error = 0;
+    isSyncTransfer = false;
+    regular = false;
+    nodeHandle = INVALID_HANDLE;
+    parentHandle = INVALID_HANDLE;
+    totalSize = 0;
+    transferredBytes = 0;
+    speed = 0;
+    meanSpeed = 0;
+    startTime = 0;
+    finishedTime = 0;
+    priority = 0;
+    transferNumber = 0;
+    numTransfers = 0;
+    revision = 0;
+}
+
+void TransferRowData::update(MegaTransfer *transfer)
+{
+    if (type < 0)
+    {
+        tag = transfer->getTag();
+        type = transfer->getType();
+        isSyncTransfer = transfer->isSyncTransfer();
+        fileName = QString::fromUtf8(transfer->getFileName());
+        startTime = transfer->getStartTime();
+        parentHandle = transfer->getParentHandle();
+    }
+
+    totalSize = transfer->getTotalBytes();
+    if (totalSize < 0)
+    {
+        totalSize = 0;
+    }
+
+    transferredBytes = transfer->getTransferredBytes();
+    if (transferredBytes < 0)
+    {
+        transferredBytes = 0;
+    }
+    if (transferredBytes > totalSize)
+    {
+        transferredBytes = totalSize;
+    }
+
+    speed = transfer->getSpeed();
+    if (speed < 0)
+    {
+        speed = 0;
+    }
+    meanSpeed = transfer->getMeanSpeed();
+    regular = !transfer->isSyncTransfer();
+    priority = transfer->getPriority();
+    state = transfer->getState();
+    nodeHandle = transfer->getNodeHandle();
+
+    int tError = transfer->getLastError().getErrorCode();
+    if (tError != MegaError::API_OK)
+    {
+        error = tError;
+    }
+
+    if (path.isEmpty() && transfer->getPath())
+    {
+        path = QString::fromUtf8(transfer->getPath());
+    }
+
+    if (isFinished())
+    {
+        finishedTime = transfer->getUpdateTime();
+
+        // Public and foreign nodes are only known to the transfer. Keep the node
+        // to retry a failed download, and the link of public ones for "Get link"
+        MegaNode *node = transfer->getPublicMegaNode();
+        if (node && state == MegaTransfer::STATE_FAILED && type == MegaTransfer::TYPE_DOWNLOAD)
+        {
+            char *serialized = node->serialize();
+            if (serialized)
+            {
+                serializedNode = QByteArray(serialized);
+            }
+            delete [] serialized;
+        }
+
+        if (node && node->isPublic())
+        {
+            char *handle = node->getBase64Handle();
+            char *key = node->getBase64Key();
+            if (handle && key)
+            {
+                publicLink = QString::fromUtf8("https://mega.nz/#!%1!%2")
+                        .arg(QString::fromUtf8(handle)).arg(QString::fromUtf8(key));
+            }
+            delete [] handle;
+            delete [] key;
+        }
+        delete node;
+    }
+
+    revision++;
+}
+
+bool TransferRowData::isFinished() const
+{
+    return state == MegaTransfer::STATE_COMPLETED
+            || state == MegaTransfer::STATE_FAILED;
+}
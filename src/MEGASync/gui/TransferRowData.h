@@ -0,0 +1,47 @@
+#ifndef TRANSFERROWDATA_H
+#define TRANSFERROWDATA_H
+
+#include <QString>
+#include <QByteArray>
+#include "megaapi.h"
+
+// Copy of the fields of a transfer that the transfer views show or act on.
+// The models keep one per row, filled from the transfer callbacks, so that
+// painting and the context actions don't have to ask the SDK again.
+class TransferRowData
+{
+public:
+    TransferRowData();
+
+    void update(mega::MegaTransfer *transfer);
+    bool isFinished() const;
+
+    int tag;
+    int type;
+    int state;
+    int error;
+    bool isSyncTransfer;
+    bool regular;
+    QString fileName;
+    QString path;
+    QString publicLink;
+    // Public or foreign node of a failed download, the only way to retry it once the SDK forgets the transfer
+    QByteArray serializedNode;
+    mega::MegaHandle nodeHandle;
+    mega::MegaHandle parentHandle;
+    long long totalSize;
+    long long transferredBytes;
+    long long speed;
+    long long meanSpeed;
+    long long startTime;
+    long long finishedTime;
+    unsigned long long priority;
+    // "N of M" among the transfers of the same type, only kept by the custom model
+    int transferNumber;
+    int numTransfers;
+
+    // Changes on every update, so anything derived from the row can be reused until then
+    unsigned int revision;
+};
+
+#endif // TRANSFERROWDATA_H
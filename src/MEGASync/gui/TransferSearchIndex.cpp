@@ -0,0 +1,157 @@
+#include "TransferSearchIndex.h"
+#include <algorithm>
+
+const int TransferSearchIndex::MIN_REBUILD_STALE_ENTRIES = 65536;
+
+TransferSearchIndex::TransferSearchIndex()
+{
+    numEntries = 0;
+    numStaleEntries = 0;
+}
+
+quint64 TransferSearchIndex::gramKey(const QChar *text, int length)
+{
+    quint64 key = length;
+    for (int i = 0; i < length; i++)
+    {
+        key = (key << 16) | text[i].unicode();
+    }
+    return key;
+}
+
+void TransferSearchIndex::getGramKeys(const QString &text, std::vector<quint64> &keys)
+{
+    keys.clear();
+    const QChar *data = text.constData();
+    int size = text.size();
+    for (int i = 0; i < size; i++)
+    {
+        for (int length = 1; length <= 3 && i + length <= size; length++)
+        {
+            keys.push_back(gramKey(data + i, length));
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+bool TransferSearchIndex::contains(int tag) const
+{
+    return names.contains(tag);
+}
+
+bool TransferSearchIndex::matches(int tag, const QString &lowerText) const
+{
+    QHash<int, QString>::const_iterator it = names.constFind(tag);
+    return it != names.constEnd() && it.value().contains(lowerText);
+}
+
+void TransferSearchIndex::add(int tag, const QString &name)
+{
+    if (names.contains(tag))
+    {
+        return;
+    }
+
+    QString lowerName = name.toLower();
+    names.insert(tag, lowerName);
+    addPostings(tag, lowerName);
+}
+
+void TransferSearchIndex::addPostings(int tag, const QString &lowerName)
+{
+    std::vector<quint64> keys;
+    getGramKeys(lowerName, keys);
+    for (unsigned int i = 0; i < keys.size(); i++)
+    {
+        postings[keys[i]].append(tag);
+    }
+    numEntries += keys.size();
+}
+
+void TransferSearchIndex::remove(int tag)
+{
+    QHash<int, QString>::iterator it = names.find(tag);
+    if (it == names.end())
+    {
+        return;
+    }
+
+    std::vector<quint64> keys;
+    getGramKeys(it.value(), keys);
+    numStaleEntries += keys.size();
+    names.erase(it);
+
+    if (numStaleEntries >= MIN_REBUILD_STALE_ENTRIES && numStaleEntries * 2 > numEntries)
+    {
+        rebuild();
+    }
+}
+
+void TransferSearchIndex::rebuild()
+{
+    postings.clear();
+    numEntries = 0;
+    numStaleEntries = 0;
+    for (QHash<int, QString>::const_iterator it = names.constBegin(); it != names.constEnd(); ++it)
+    {
+        addPostings(it.key(), it.value());
+    }
+}
+
+void TransferSearchIndex::clear()
+{
+    names.clear();
+    postings.clear();
+    numEntries = 0;
+    numStaleEntries = 0;
+}
+
+QVector<int> TransferSearchIndex::search(const QString &lowerText) const
+{
+    QVector<int> result;
+    int size = lowerText.size();
+    if (!size)
+    {
+        return result;
+    }
+
+    // Shortest list among the grams of the text, its own gram when it is short enough
+    const QVector<int> *candidates = NULL;
+    int gramLength = qMin(size, 3);
+    for (int i = 0; i + gramLength <= size; i++)
+    {
+        QHash<quint64, QVector<int> >::const_iterator it = postings.constFind(gramKey(lowerText.constData() + i, gramLength));
+        if (it == postings.constEnd())
+        {
+            return result;
+        }
+
+        if (!candidates || it.value().size() < candidates->size())
+        {
+            candidates = &it.value();
+        }
+    }
+
+    // Lists only need checking against the names if they can hold stale
+    // entries or the text is longer than the indexed grams
+    bool exact = size <= 3 && !numStaleEntries;
+    result.reserve(candidates->size());
+    for (int i = 0; i < candidates->size(); i++)
+    {
+        int tag = candidates->at(i);
+        if (exact || matches(tag, lowerText))
+        {
+            result.append(tag);
+        }
+    }
+
+    if (!exact)
+    {
+        // A tag removed and added again can be listed twice
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    return result;
+}
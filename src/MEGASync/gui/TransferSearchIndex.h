@@ -0,0 +1,42 @@
+#ifndef TRANSFERSEARCHINDEX_H
+#define TRANSFERSEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// Lowercase n-gram index over transfer names. Every distinct sequence of up to
+// three characters of a name lists the tags that contain it, so queries of up
+// to three characters are answered from a single list, and longer ones only
+// check the names in the shortest list among their trigrams.
+// Removed tags stay in the lists until enough of them pile up to rebuild them.
+class TransferSearchIndex
+{
+public:
+    TransferSearchIndex();
+
+    bool contains(int tag) const;
+    bool matches(int tag, const QString &lowerText) const;
+    void add(int tag, const QString &name);
+    void remove(int tag);
+    void clear();
+
+    // Tags whose name contains the lowercase text, in no particular order
+    QVector<int> search(const QString &lowerText) const;
+
+private:
+    static quint64 gramKey(const QChar *text, int length);
+    static void getGramKeys(const QString &text, std::vector<quint64> &keys);
+    void addPostings(int tag, const QString &lowerName);
+    void rebuild();
+
+    static const int MIN_REBUILD_STALE_ENTRIES;
+
+    QHash<int, QString> names;
+    QHash<quint64, QVector<int> > postings;
+    int numEntries;
+    int numStaleEntries;
+};
+
+#endif // TRANSFERSEARCHINDEX_H
@@ -32,20 +32,20 @@ void TransfersWidget::setupTransfers(MegaTransferData *transferData, int type)
     }
 }
 
-void TransfersWidget::setupFinishedTransfers(QList<MegaTransfer* > transferData, int modelType)
+void TransfersWidget::setupFinishedTransfers(TransferHistory *history, int modelType)
 {
     this->type = modelType;
-    model = new QFinishedTransfersModel(transferData, modelType);
+    model = new QFinishedTransfersModel(history, modelType);
     connect(model, SIGNAL(noTransfers()), this, SLOT(noTransfers()));
     connect(model, SIGNAL(onTransferAdded()), this, SLOT(onTransferAdded()));
-    // Subscribe to MegaApplication for changes on finished transfers generated by other finished model to keep consistency
+    // Subscribe to MegaApplication for changes on finished transfers generated by other finished model to keep consistency.
+    // Single entries are only removed from this model, which identifies them by history id instead of tag.
     connect(app, SIGNAL(clearAllFinishedTransfers()), model, SLOT(removeAllTransfers()));
-    connect(app, SIGNAL(clearFinishedTransfer(int)),  model, SLOT(removeTransferByTag(int)));
 
     noTransfers();
     configureTransferView();
 
-    if (transferData.size())
+    if (!history->isEmpty())
     {
         onTransferAdded();
     }
@@ -61,6 +61,11 @@ void TransfersWidget::clearTransfers()
     model->removeAllTransfers();
 }
 
+void TransfersWidget::setFilter(const QString &text)
+{
+    model->setFilter(text);
+}
+
 TransfersWidget::~TransfersWidget()
 {
     delete ui;
@@ -2,7 +2,6 @@
 #define TRANSFERSWIDGET_H
 
 #include <QWidget>
-#include "TransferItem.h"
 #include "QTransfersModel.h"
 #include "QActiveTransfersModel.h"
 #include "QFinishedTransfersModel.h"
@@ -21,10 +20,11 @@ class TransfersWidget : public QWidget
 
 public:
     explicit TransfersWidget(QWidget *parent = 0);
-    void setupFinishedTransfers(QList<mega::MegaTransfer* > transferData, int modelType = QTransfersModel::TYPE_FINISHED);
+    void setupFinishedTransfers(TransferHistory *history, int modelType = QTransfersModel::TYPE_FINISHED);
     void setupTransfers(mega::MegaTransferData *transferData, int type);
     void refreshTransferItems();
     void clearTransfers();
+    void setFilter(const QString &text);
     void pausedTransfers(bool paused);
     void disableGetLink(bool disable);
     QTransfersModel *getModel();
@@ -45,18 +45,20 @@ SOURCES += $$PWD/SettingsDialog.cpp \
     $$PWD/DataUsageMenu.cpp \
     $$PWD/AddExclusionDialog.cpp \
     $$PWD/LocalCleanScheduler.cpp \
-    $$PWD/TransferManagerItem.cpp \
-    $$PWD/TransferItem.cpp \
     $$PWD/InfoDialogTransfersWidget.cpp \
     $$PWD/QCustomTransfersModel.cpp \
     $$PWD/StatusInfo.cpp \
     $$PWD/ChangePassword.cpp \
-    $$PWD/CustomTransferItem.cpp \
     $$PWD/PSAwidget.cpp \
     $$PWD/ElidedLabel.cpp \
     $$PWD/UpgradeOverStorage.cpp \
     $$PWD/UpgradeWidget.cpp \
-    $$PWD/Login2FA.cpp
+    $$PWD/Login2FA.cpp \
+    $$PWD/TransferIndex.cpp \
+    $$PWD/TransferHistory.cpp \
+    $$PWD/BulkTransferOperation.cpp \
+    $$PWD/TransferSearchIndex.cpp \
+    $$PWD/TransferRowData.cpp
 
 HEADERS  += $$PWD/SettingsDialog.h \
     $$PWD/InfoDialog.h \
@@ -103,18 +105,20 @@ HEADERS  += $$PWD/SettingsDialog.h \
     $$PWD/DataUsageMenu.h \
     $$PWD/AddExclusionDialog.h \
     $$PWD/LocalCleanScheduler.h \
-    $$PWD/TransferManagerItem.h \
-    $$PWD/TransferItem.h \
     $$PWD/InfoDialogTransfersWidget.h \
     $$PWD/QCustomTransfersModel.h \
     $$PWD/StatusInfo.h \
-    $$PWD/CustomTransferItem.h \
     $$PWD/PSAwidget.h \
     $$PWD/ElidedLabel.h \
     $$PWD/UpgradeOverStorage.h \
     $$PWD/UpgradeWidget.h \
     $$PWD/ChangePassword.h \
-    $$PWD/Login2FA.h
+    $$PWD/Login2FA.h \
+    $$PWD/TransferIndex.h \
+    $$PWD/TransferHistory.h \
+    $$PWD/BulkTransferOperation.h \
+    $$PWD/TransferSearchIndex.h \
+    $$PWD/TransferRowData.h
 
 INCLUDEPATH += $$PWD
 
@@ -126,7 +130,6 @@ win32 {
     RESOURCES += $$PWD/Resources_win.qrc
     INCLUDEPATH += $$PWD/win
     FORMS    += $$PWD/win/InfoDialog.ui \
-                $$PWD/win/CustomTransferItem.ui \
                 $$PWD/win/TransferProgressBar.ui \
                 $$PWD/win/UsageProgressBar.ui \
                 $$PWD/win/NodeSelector.ui \
@@ -150,7 +153,6 @@ win32 {
                 $$PWD/win/PlanWidget.ui \
                 $$PWD/win/UpgradeDialog.ui \
                 $$PWD/win/InfoWizard.ui \
-                $$PWD/win/TransferManagerItem.ui \
                 $$PWD/win/TransferManager.ui \
                 $$PWD/win/TransfersWidget.ui \
                 $$PWD/win/TransfersStateInfoWidget.ui \
@@ -196,7 +198,6 @@ macx {
                 $$PWD/macx/PlanWidget.ui \
                 $$PWD/macx/UpgradeDialog.ui \
                 $$PWD/macx/InfoWizard.ui \
-                $$PWD/macx/TransferManagerItem.ui \
                 $$PWD/macx/TransferManager.ui \
                 $$PWD/macx/TransfersWidget.ui \
                 $$PWD/macx/TransfersStateInfoWidget.ui \
@@ -206,7 +207,6 @@ macx {
                 $$PWD/macx/LocalCleanScheduler.ui \
                 $$PWD/macx/InfoDialogTransfersWidget.ui \
                 $$PWD/macx/StatusInfo.ui \
-                $$PWD/macx/CustomTransferItem.ui \
                 $$PWD/macx/PSAwidget.ui \
                 $$PWD/macx/UpgradeOverStorage.ui \
                 $$PWD/macx/UpgradeWidget.ui \
@@ -227,7 +227,6 @@ unix:!macx {
     RESOURCES += $$PWD/Resources_linux.qrc
     INCLUDEPATH += $$PWD/linux
     FORMS    += $$PWD/linux/InfoDialog.ui \
-                $$PWD/linux/CustomTransferItem.ui \
                 $$PWD/linux/TransferProgressBar.ui \
                 $$PWD/linux/UsageProgressBar.ui \
                 $$PWD/linux/NodeSelector.ui \
@@ -253,7 +252,6 @@ unix:!macx {
                 $$PWD/linux/PlanWidget.ui \
                 $$PWD/linux/UpgradeDialog.ui \
                 $$PWD/linux/InfoWizard.ui \
-                $$PWD/linux/TransferManagerItem.ui \
                 $$PWD/linux/TransferManager.ui \
                 $$PWD/linux/TransfersWidget.ui \
                 $$PWD/linux/TransfersStateInfoWidget.ui \
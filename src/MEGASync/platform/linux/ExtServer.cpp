@@ -3,6 +3,7 @@
 #include <pwd.h>
 #include <unistd.h>
 #include "control/Utilities.h"
+#include "control/Tracer.h"
 
 using namespace mega;
 using namespace std;
@@ -104,6 +105,7 @@ void ExtServer::onClientData()
 // parse incoming request and send response back to client
 const char *ExtServer::GetAnswerToRequest(const char *buf)
 {
+    TRACE_SPAN("ExtServer::GetAnswerToRequest");
     char c = buf[0];
     const char *content = buf+2;
     static char out[BUFSIZE];
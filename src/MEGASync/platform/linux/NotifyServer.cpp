@@ -55,11 +55,11 @@ void NotifyServer::acceptConnection()
 
         // send the list of current synced folders to the new client
         int localFolders = 0;
-        Preferences *preferences = Preferences::instance();
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+        QSharedPointer<const SyncRegistry> syncs = Preferences::instance()->getSyncRegistry();
+        for (int i = 0; i < syncs->size(); i++)
         {
-            QString c = QDir::toNativeSeparators(QDir(preferences->getLocalFolder(i)).canonicalPath());
-            if (!c.size() || !preferences->isFolderActive(i))
+            QString c = syncs->at(i).localPath;
+            if (!syncs->at(i).exists || !syncs->at(i).active)
             {
                 continue;
             }
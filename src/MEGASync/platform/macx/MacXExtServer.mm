@@ -1,5 +1,6 @@
 #include "MacXExtServer.h"
 #include <assert.h>
+#include "control/Tracer.h"
 
 #if QT_VERSION >= 0x050000
 #include <QtConcurrent/QtConcurrent>
@@ -50,17 +51,17 @@ void MacXExtServer::acceptConnection()
         m_clients.append(client);
 
         // send the list of current synced folders to the new client
-        Preferences *preferences = Preferences::instance();
-        for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+        QSharedPointer<const SyncRegistry> syncs = Preferences::instance()->getSyncRegistry();
+        for (int i = 0; i < syncs->size(); i++)
         {
-            QString syncPath = QDir::toNativeSeparators(QDir(preferences->getLocalFolder(i)).canonicalPath());
-            if (!syncPath.size() || !preferences->isFolderActive(i))
+            const SyncEntry &sync = syncs->at(i);
+            if (!sync.exists || !sync.active)
             {
                 continue;
             }
 
-            QString message = QString::fromUtf8("A:") + syncPath
-                    + QChar::fromAscii(':') + preferences->getSyncName(i);
+            QString message = QString::fromUtf8("A:") + sync.localPath
+                    + QChar::fromAscii(':') + sync.name;
             client->writeData(message.toUtf8().constData(), message.length());
         }        
     }
@@ -115,6 +116,7 @@ void MacXExtServer::onClientDisconnected()
 #define RESPONSE_IGNORED    "4"
 bool MacXExtServer::GetAnswerToRequest(const char *buf, QByteArray *response)
 {
+    TRACE_SPAN("MacXExtServer::GetAnswerToRequest");
     if (!buf || !response)
     {
         return false;
@@ -399,15 +401,16 @@ void MacXExtServer::notifyAllClients(int op)
         command = QString::fromUtf8("D:");
     }
 
-    for (int i = 0; i < preferences->getNumSyncedFolders(); i++)
+    QSharedPointer<const SyncRegistry> syncs = preferences->getSyncRegistry();
+    for (int i = 0; i < syncs->size(); i++)
     {
-        QString syncPath = QDir::toNativeSeparators(QDir(preferences->getLocalFolder(i)).canonicalPath());
-        if (!syncPath.size() || !preferences->isFolderActive(i))
+        const SyncEntry &sync = syncs->at(i);
+        if (!sync.exists || !sync.active)
         {
             continue;
         }
 
-        QString message = command + syncPath + QChar::fromAscii(':') + preferences->getSyncName(i);
+        QString message = command + sync.localPath + QChar::fromAscii(':') + sync.name;
 
         emit sendToAll(message.toUtf8());
     }
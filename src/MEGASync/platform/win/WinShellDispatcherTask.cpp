@@ -1,5 +1,6 @@
 #include "WinShellDispatcherTask.h"
 #include "megaapi.h"
+#include "control/Tracer.h"
 
 PIPEINST Pipe[INSTANCES];
 HANDLE hEvents[INSTANCES+1];
@@ -342,6 +343,7 @@ BOOL ConnectToNewClient(HANDLE hPipe, LPOVERLAPPED lpo)
 
 VOID WinShellDispatcherTask::GetAnswerToRequest(LPPIPEINST pipe)
 {
+    TRACE_SPAN("WinShellDispatcherTask::GetAnswerToRequest");
     //wprintf( TEXT("[%d] %s\n"), pipe->hPipeInst, pipe->chRequest);
     wcscpy_s(pipe->chReply, BUFSIZE, RESPONSE_DEFAULT);
     wchar_t c = pipe->chRequest[0];